@@ -8,6 +8,8 @@ using namespace TCPNetworkLinuxNamespace;
 #define TCPNetworkLinux_version             "V1.1"          // Library version tag
 #define TCPNetworkLinux_DEFAULT_RX_SIZE     1000            // Default RX buffer size
 #define TCPNetworkLinux_DEFAULT_TX_SIZE     1000            // Default TX buffer size
+#define TCPNetworkLinux_IO_CHUNK_SIZE       65536           // Chunk size for receive/send loops of event loop
+#define TCPNetworkLinux_MAX_EVENTS          256             // Maximum number of events for one epoll_wait call
 
 // ###############################################################################################
 // General functions:
@@ -52,760 +54,9084 @@ std::string TCPNetworkLinuxNamespace::getIPAddressByInterface(const std::string&
     return ipAddress;  // Return the IP address or an empty string if not found
 }
 
+// Descriptor of one field of TCPSocketOptions.
+struct TCPNetworkLinux_SocketOption
+{
+    int level;
+    int name;
+    const char* label;
+    int TCPSocketOptions::* field;
+};
+
+// Fields of TCPSocketOptions in apply order. Buffer sizes are set first, so they are in effect before other options.
+static const TCPNetworkLinux_SocketOption TCPNetworkLinux_socketOptions[] =
+{
+    {SOL_SOCKET,  SO_SNDBUF,         "SO_SNDBUF",         &TCPSocketOptions::sendBufferSize},
+    {SOL_SOCKET,  SO_RCVBUF,         "SO_RCVBUF",         &TCPSocketOptions::receiveBufferSize},
+    {IPPROTO_TCP, TCP_NODELAY,       "TCP_NODELAY",       &TCPSocketOptions::noDelay},
+    {IPPROTO_TCP, TCP_CORK,          "TCP_CORK",          &TCPSocketOptions::cork},
+    {IPPROTO_TCP, TCP_QUICKACK,      "TCP_QUICKACK",      &TCPSocketOptions::quickAck},
+    {IPPROTO_TCP, TCP_NOTSENT_LOWAT, "TCP_NOTSENT_LOWAT", &TCPSocketOptions::notSentLowat},
+    {SOL_SOCKET,  SO_BUSY_POLL,      "SO_BUSY_POLL",      &TCPSocketOptions::busyPoll},
+};
+
+bool TCPNetworkLinuxNamespace::applySocketOptions(int socket, const TCPSocketOptions &options, std::string &errorMessage, bool tcpLevel)
+{
+    bool result = true;
+
+    for (const TCPNetworkLinux_SocketOption &option : TCPNetworkLinux_socketOptions)
+    {
+        int value = options.*option.field;
+
+        if ( (value == -1) || (!tcpLevel && (option.level == IPPROTO_TCP)) )
+        {
+            continue;
+        }
+
+        if (setsockopt(socket, option.level, option.name, &value, sizeof(value)) == -1)
+        {
+            errorMessage += (result ? "" : ", ") + std::string(option.label);
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+TCPSocketOptions TCPNetworkLinuxNamespace::getSocketOptions(int socket)
+{
+    TCPSocketOptions options;
+    options.listenBacklog = -1;
+
+    for (const TCPNetworkLinux_SocketOption &option : TCPNetworkLinux_socketOptions)
+    {
+        int value = 0;
+        socklen_t length = sizeof(value);
+
+        options.*option.field = (getsockopt(socket, option.level, option.name, &value, &length) == 0) ? value : -1;
+    }
+
+    return options;
+}
+
+socklen_t TCPNetworkLinuxNamespace::makeUnixAddress(const char* path, struct sockaddr_un &address)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    size_t length = strlen(path);
+
+    // Filesystem path needs a terminating null character. Abstract name is not terminated.
+    if ( (length == 0) || (length >= sizeof(address.sun_path)) )
+    {
+        return 0;
+    }
+
+    memcpy(address.sun_path, path, length);
+
+    if (path[0] == '@')
+    {
+        address.sun_path[0] = '\0';
+        return offsetof(struct sockaddr_un, sun_path) + length;
+    }
+
+    return offsetof(struct sockaddr_un, sun_path) + length + 1;
+}
+
+ssize_t TCPNetworkLinuxNamespace::sendFileDescriptors(int socket, const char* data, size_t size, const int* fileDescriptors, size_t count)
+{
+    if ( (size == 0) || (count > TCPNetworkLinux_MAX_FILE_DESCRIPTORS) )
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * TCPNetworkLinux_MAX_FILE_DESCRIPTORS)];
+    struct iovec buffer = {(void*)data, size};
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &buffer;
+    message.msg_iovlen = 1;
+
+    if (count > 0)
+    {
+        message.msg_control = control;
+        message.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+        struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int) * count);
+        memcpy(CMSG_DATA(header), fileDescriptors, sizeof(int) * count);
+    }
+
+    ssize_t bytesWrite;
+    do
+    {
+        bytesWrite = sendmsg(socket, &message, MSG_NOSIGNAL);
+    } while ( (bytesWrite == -1) && (errno == EINTR) );
+
+    return bytesWrite;
+}
+
+ssize_t TCPNetworkLinuxNamespace::receiveFileDescriptors(int socket, const struct iovec* buffers, size_t count, std::vector<int> &fileDescriptors)
+{
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * TCPNetworkLinux_MAX_FILE_DESCRIPTORS)];
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = (struct iovec*)buffers;
+    message.msg_iovlen = count;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t bytesRead = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+
+    if (bytesRead <= 0)
+    {
+        return bytesRead;
+    }
+
+    for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header))
+    {
+        if ( (header->cmsg_level != SOL_SOCKET) || (header->cmsg_type != SCM_RIGHTS) )
+        {
+            continue;
+        }
+
+        size_t number = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const unsigned char* data = CMSG_DATA(header);
+
+        for (size_t i = 0; i < number; i++)
+        {
+            int fileDescriptor;
+            memcpy(&fileDescriptor, data + i * sizeof(int), sizeof(int));
+            fileDescriptors.push_back(fileDescriptor);
+        }
+    }
+
+    return bytesRead;
+}
+
 // ######################################################################
-// TCPServer class:
+// TCPSocketOptions struct:
+
+TCPSocketOptions TCPSocketOptions::lowLatency(void)
+{
+    TCPSocketOptions options;
+    options.noDelay = 1;
+    options.cork = 0;
+    options.quickAck = 1;
+    options.notSentLowat = 16384;
+    options.busyPoll = 50;
+
+    return options;
+}
+
+TCPSocketOptions TCPSocketOptions::bulkThroughput(void)
+{
+    TCPSocketOptions options;
+    options.noDelay = 0;
+    options.sendBufferSize = 4194304;
+    options.receiveBufferSize = 4194304;
+
+    return options;
+}
+
+// ######################################################################
+// TCPBufferPool class:
+
+static_assert((TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK & (TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK - 1)) == 0, "Minimum chunk must be power of two.");
+static_assert((TCPNetworkLinux_BUFFER_POOL_MAX_CHUNK & (TCPNetworkLinux_BUFFER_POOL_MAX_CHUNK - 1)) == 0, "Maximum chunk must be power of two.");
+static_assert((TCPNetworkLinux_BUFFER_POOL_SLAB_SIZE & (TCPNetworkLinux_BUFFER_POOL_SLAB_SIZE - 1)) == 0, "Slab size must be power of two.");
+
+// Number of chunk size classes. Class i has chunks of TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK << i bytes.
+static constexpr size_t TCPNetworkLinux_bufferPoolClassNum = __builtin_ctzll(TCPNetworkLinux_BUFFER_POOL_MAX_CHUNK) - __builtin_ctzll(TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK) + 1;
+
+struct TCPNetworkLinux_BufferCache;
+
+// Free chunk. Size is kept for chunks that wait in remote list.
+struct TCPNetworkLinux_Chunk
+{
+    TCPNetworkLinux_Chunk* next;
+    size_t size;
+};
+
+// Header of slab. It is stored in first chunk of the slab. Slab is aligned to its size, so address of a chunk finds its header.
+struct TCPNetworkLinux_Slab
+{
+    std::atomic<TCPNetworkLinux_BufferCache*> owner;    // Owner cache. It is the shared cache after owner thread exited.
+    TCPNetworkLinux_Slab* previous;         // List of owner cache.
+    TCPNetworkLinux_Slab* next;
+    TCPNetworkLinux_Chunk* freeChunks;      // Released chunks.
+    size_t carveOffset;                     // Offset of first chunk that was never handed out.
+    size_t usedChunks;                      // Number of handed out chunks.
+    size_t classIndex;
+    bool full;                              // Slab is in full list.
+};
+
+static_assert(sizeof(TCPNetworkLinux_Slab) <= TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK, "Slab header must fit in one chunk.");
+
+// Slabs of one thread or shared slabs. Index of lists is size class.
+struct TCPNetworkLinux_BufferCache
+{
+    TCPNetworkLinux_Slab* partial[TCPNetworkLinux_bufferPoolClassNum] = {};     // Slabs with free chunks.
+    TCPNetworkLinux_Slab* full[TCPNetworkLinux_bufferPoolClassNum] = {};        // Slabs without free chunks.
+    TCPNetworkLinux_Slab* spare[TCPNetworkLinux_bufferPoolClassNum] = {};       // Empty slab that is kept for next allocation.
+    TCPNetworkLinux_Chunk* remoteChunks = nullptr;                              // Chunks released by other threads. Guarded by pool mutex.
+    std::atomic<bool> hasRemoteChunks{false};
+};
+
+static std::atomic<size_t> TCPNetworkLinux_poolBudget{0};
+static std::atomic<size_t> TCPNetworkLinux_poolReserved{0};
+static std::atomic<size_t> TCPNetworkLinux_poolUsed{0};
+static std::atomic<size_t> TCPNetworkLinux_poolSlabs{0};
+static std::atomic<uint64_t> TCPNetworkLinux_poolRefusals{0};
+
+// Pool mutex and shared cache live until process exit, since buffers of static objects may be released after thread local caches.
+static std::mutex& TCPNetworkLinux_poolMutex(void)
+{
+    static std::mutex* mutex = new std::mutex;
+    return *mutex;
+}
+
+static TCPNetworkLinux_BufferCache& TCPNetworkLinux_sharedCache(void)
+{
+    static TCPNetworkLinux_BufferCache* cache = new TCPNetworkLinux_BufferCache;
+    return *cache;
+}
+
+static size_t TCPNetworkLinux_slabSize(size_t classIndex)
+{
+    return std::max((size_t)TCPNetworkLinux_BUFFER_POOL_SLAB_SIZE, ((size_t)TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK << classIndex) * 16);
+}
+
+static void TCPNetworkLinux_unlinkSlab(TCPNetworkLinux_Slab* &list, TCPNetworkLinux_Slab* slab)
+{
+    if (slab->previous != nullptr)
+    {
+        slab->previous->next = slab->next;
+    }
+    else
+    {
+        list = slab->next;
+    }
+
+    if (slab->next != nullptr)
+    {
+        slab->next->previous = slab->previous;
+    }
+}
+
+static void TCPNetworkLinux_linkSlab(TCPNetworkLinux_Slab* &list, TCPNetworkLinux_Slab* slab)
+{
+    slab->previous = nullptr;
+    slab->next = list;
+    if (list != nullptr)
+    {
+        list->previous = slab;
+    }
+    list = slab;
+}
+
+// Take memory from system budget. return false if budget does not allow it.
+static bool TCPNetworkLinux_reserveMemory(size_t size, bool force)
+{
+    size_t reserved = TCPNetworkLinux_poolReserved.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t budget = TCPNetworkLinux_poolBudget.load(std::memory_order_relaxed);
+
+    if (!force && (budget != 0) && (reserved > budget))
+    {
+        TCPNetworkLinux_poolReserved.fetch_sub(size, std::memory_order_relaxed);
+        TCPNetworkLinux_poolRefusals.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+static void TCPNetworkLinux_freeSlab(TCPNetworkLinux_Slab* slab)
+{
+    size_t slabSize = TCPNetworkLinux_slabSize(slab->classIndex);
+
+    free(slab);
+    TCPNetworkLinux_poolReserved.fetch_sub(slabSize, std::memory_order_relaxed);
+    TCPNetworkLinux_poolSlabs.fetch_sub(1, std::memory_order_relaxed);
+}
+
+static void* TCPNetworkLinux_cacheAllocate(TCPNetworkLinux_BufferCache &cache, size_t classIndex, bool force)
+{
+    size_t chunkSize = (size_t)TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK << classIndex;
+    size_t slabSize = TCPNetworkLinux_slabSize(classIndex);
+    TCPNetworkLinux_Slab* slab = cache.partial[classIndex];
+
+    if (slab == nullptr)
+    {
+        slab = cache.spare[classIndex];
+        cache.spare[classIndex] = nullptr;
+
+        if (slab == nullptr)
+        {
+            if (!TCPNetworkLinux_reserveMemory(slabSize, force))
+            {
+                return nullptr;
+            }
+
+            slab = (TCPNetworkLinux_Slab*)aligned_alloc(slabSize, slabSize);
+            if (slab == nullptr)
+            {
+                TCPNetworkLinux_poolReserved.fetch_sub(slabSize, std::memory_order_relaxed);
+                return nullptr;
+            }
+            TCPNetworkLinux_poolSlabs.fetch_add(1, std::memory_order_relaxed);
+
+            // First chunk holds the header.
+            slab->owner.store(&cache, std::memory_order_relaxed);
+            slab->freeChunks = nullptr;
+            slab->carveOffset = chunkSize;
+            slab->usedChunks = 0;
+            slab->classIndex = classIndex;
+            slab->full = false;
+        }
+
+        TCPNetworkLinux_linkSlab(cache.partial[classIndex], slab);
+    }
+
+    void* chunk;
+    if (slab->freeChunks != nullptr)
+    {
+        chunk = slab->freeChunks;
+        slab->freeChunks = slab->freeChunks->next;
+    }
+    else
+    {
+        chunk = (char*)slab + slab->carveOffset;
+        slab->carveOffset += chunkSize;
+    }
+    slab->usedChunks++;
+
+    if ( (slab->freeChunks == nullptr) && (slab->carveOffset == slabSize) )
+    {
+        TCPNetworkLinux_unlinkSlab(cache.partial[classIndex], slab);
+        TCPNetworkLinux_linkSlab(cache.full[classIndex], slab);
+        slab->full = true;
+    }
+
+    return chunk;
+}
+
+static void TCPNetworkLinux_cacheDeallocate(TCPNetworkLinux_BufferCache &cache, TCPNetworkLinux_Slab* slab, void* pointer)
+{
+    size_t classIndex = slab->classIndex;
+
+    TCPNetworkLinux_Chunk* chunk = (TCPNetworkLinux_Chunk*)pointer;
+    chunk->next = slab->freeChunks;
+    slab->freeChunks = chunk;
+    slab->usedChunks--;
+
+    if (slab->full)
+    {
+        TCPNetworkLinux_unlinkSlab(cache.full[classIndex], slab);
+        TCPNetworkLinux_linkSlab(cache.partial[classIndex], slab);
+        slab->full = false;
+    }
+
+    if (slab->usedChunks > 0)
+    {
+        return;
+    }
+
+    // Empty slab. Keep one per class, so a single buffer that is allocated and released repeatedly does not hit system.
+    TCPNetworkLinux_unlinkSlab(cache.partial[classIndex], slab);
+    slab->freeChunks = nullptr;
+    slab->carveOffset = (size_t)TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK << classIndex;
+
+    if (cache.spare[classIndex] == nullptr)
+    {
+        cache.spare[classIndex] = slab;
+    }
+    else
+    {
+        TCPNetworkLinux_freeSlab(slab);
+    }
+}
+
+static TCPNetworkLinux_Slab* TCPNetworkLinux_slabOf(void* pointer, size_t classIndex)
+{
+    return (TCPNetworkLinux_Slab*)((uintptr_t)pointer & ~(uintptr_t)(TCPNetworkLinux_slabSize(classIndex) - 1));
+}
+
+// Release chunks that other threads released into slabs of cache.
+static void TCPNetworkLinux_drainRemoteChunks(TCPNetworkLinux_BufferCache &cache)
+{
+    TCPNetworkLinux_Chunk* chunk;
+    {
+        std::lock_guard<std::mutex> lock(TCPNetworkLinux_poolMutex());
+        chunk = cache.remoteChunks;
+        cache.remoteChunks = nullptr;
+        cache.hasRemoteChunks.store(false, std::memory_order_relaxed);
+    }
+
+    while (chunk != nullptr)
+    {
+        TCPNetworkLinux_Chunk* next = chunk->next;
+        size_t classIndex = __builtin_ctzll(chunk->size) - __builtin_ctzll(TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK);
+        TCPNetworkLinux_cacheDeallocate(cache, TCPNetworkLinux_slabOf(chunk, classIndex), chunk);
+        chunk = next;
+    }
+}
+
+// Calling thread destroyed its cache. Later calls of the thread use the shared cache.
+static thread_local bool TCPNetworkLinux_bufferCacheExited = false;
+
+// Cache of one thread. On thread exit its slabs move to the shared cache and chunks in use stay valid.
+struct TCPNetworkLinux_BufferCacheHolder
+{
+    TCPNetworkLinux_BufferCache* cache = nullptr;
+
+    ~TCPNetworkLinux_BufferCacheHolder()
+    {
+        TCPNetworkLinux_bufferCacheExited = true;
+
+        if (cache == nullptr)
+        {
+            return;
+        }
+
+        // Remote chunks are taken in the same critical section that moves slabs, so no remote release can land in between.
+        std::lock_guard<std::mutex> lock(TCPNetworkLinux_poolMutex());
+        TCPNetworkLinux_BufferCache &shared = TCPNetworkLinux_sharedCache();
+        TCPNetworkLinux_Chunk* remoteChunk = cache->remoteChunks;
+        cache->remoteChunks = nullptr;
+
+        for (size_t i = 0; i < TCPNetworkLinux_bufferPoolClassNum; i++)
+        {
+            if (cache->spare[i] != nullptr)
+            {
+                TCPNetworkLinux_freeSlab(cache->spare[i]);
+            }
+
+            for (TCPNetworkLinux_Slab** list : {&cache->partial[i], &cache->full[i]})
+            {
+                while (*list != nullptr)
+                {
+                    TCPNetworkLinux_Slab* slab = *list;
+                    TCPNetworkLinux_unlinkSlab(*list, slab);
+                    slab->owner.store(&shared, std::memory_order_relaxed);
+                    TCPNetworkLinux_linkSlab(slab->full ? shared.full[i] : shared.partial[i], slab);
+                }
+            }
+        }
+
+        while (remoteChunk != nullptr)
+        {
+            TCPNetworkLinux_Chunk* next = remoteChunk->next;
+            size_t classIndex = __builtin_ctzll(remoteChunk->size) - __builtin_ctzll(TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK);
+            TCPNetworkLinux_cacheDeallocate(shared, TCPNetworkLinux_slabOf(remoteChunk, classIndex), remoteChunk);
+            remoteChunk = next;
+        }
+
+        delete cache;
+        cache = nullptr;
+    }
+};
+
+static thread_local TCPNetworkLinux_BufferCacheHolder TCPNetworkLinux_bufferCacheHolder;
+
+// Return cache of calling thread. return nullptr while the thread exits.
+static TCPNetworkLinux_BufferCache* TCPNetworkLinux_localCache(void)
+{
+    if (TCPNetworkLinux_bufferCacheExited)
+    {
+        return nullptr;
+    }
+
+    TCPNetworkLinux_BufferCacheHolder &holder = TCPNetworkLinux_bufferCacheHolder;
+    if (holder.cache == nullptr)
+    {
+        holder.cache = new TCPNetworkLinux_BufferCache;
+    }
+
+    return holder.cache;
+}
+
+void* TCPBufferPool::allocate(size_t size, bool force)
+{
+    size = chunkSize(size);
+
+    void* pointer = nullptr;
+
+    if (size > TCPNetworkLinux_BUFFER_POOL_MAX_CHUNK)
+    {
+        if (!TCPNetworkLinux_reserveMemory(size, force))
+        {
+            return nullptr;
+        }
+
+        pointer = malloc(size);
+        if (pointer == nullptr)
+        {
+            TCPNetworkLinux_poolReserved.fetch_sub(size, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+    else
+    {
+        size_t classIndex = __builtin_ctzll(size) - __builtin_ctzll(TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK);
+        TCPNetworkLinux_BufferCache* cache = TCPNetworkLinux_localCache();
+
+        if (cache != nullptr)
+        {
+            if (cache->hasRemoteChunks.load(std::memory_order_relaxed))
+            {
+                TCPNetworkLinux_drainRemoteChunks(*cache);
+            }
+            pointer = TCPNetworkLinux_cacheAllocate(*cache, classIndex, force);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(TCPNetworkLinux_poolMutex());
+            pointer = TCPNetworkLinux_cacheAllocate(TCPNetworkLinux_sharedCache(), classIndex, force);
+        }
+
+        if (pointer == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    TCPNetworkLinux_poolUsed.fetch_add(size, std::memory_order_relaxed);
+
+    return pointer;
+}
+
+void TCPBufferPool::deallocate(void* pointer, size_t size) noexcept
+{
+    if (pointer == nullptr)
+    {
+        return;
+    }
+
+    size = chunkSize(size);
+    TCPNetworkLinux_poolUsed.fetch_sub(size, std::memory_order_relaxed);
+
+    if (size > TCPNetworkLinux_BUFFER_POOL_MAX_CHUNK)
+    {
+        free(pointer);
+        TCPNetworkLinux_poolReserved.fetch_sub(size, std::memory_order_relaxed);
+        return;
+    }
+
+    size_t classIndex = __builtin_ctzll(size) - __builtin_ctzll(TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK);
+    TCPNetworkLinux_Slab* slab = TCPNetworkLinux_slabOf(pointer, classIndex);
+    TCPNetworkLinux_BufferCache* cache = TCPNetworkLinux_bufferCacheExited ? nullptr : TCPNetworkLinux_bufferCacheHolder.cache;
+
+    // Owner of a slab changes only when owner thread exits, so calling thread owns the slab or it never will.
+    // Owner is atomic, since it is read here without lock while an exiting thread changes it under lock.
+    if ( (cache != nullptr) && (slab->owner.load(std::memory_order_relaxed) == cache) )
+    {
+        TCPNetworkLinux_cacheDeallocate(*cache, slab, pointer);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(TCPNetworkLinux_poolMutex());
+    TCPNetworkLinux_BufferCache &shared = TCPNetworkLinux_sharedCache();
+
+    TCPNetworkLinux_BufferCache* owner = slab->owner.load(std::memory_order_relaxed);
+    if (owner == &shared)
+    {
+        TCPNetworkLinux_cacheDeallocate(shared, slab, pointer);
+        return;
+    }
+
+    TCPNetworkLinux_Chunk* chunk = (TCPNetworkLinux_Chunk*)pointer;
+    chunk->size = size;
+    chunk->next = owner->remoteChunks;
+    owner->remoteChunks = chunk;
+    owner->hasRemoteChunks.store(true, std::memory_order_relaxed);
+}
+
+size_t TCPBufferPool::chunkSize(size_t size)
+{
+    size_t chunkSize = TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK;
+    while (chunkSize < size)
+    {
+        chunkSize <<= 1;
+    }
+
+    return chunkSize;
+}
+
+void TCPBufferPool::setMemoryBudget(size_t bytes)
+{
+    TCPNetworkLinux_poolBudget.store(bytes, std::memory_order_relaxed);
+}
+
+size_t TCPBufferPool::getMemoryBudget(void)
+{
+    return TCPNetworkLinux_poolBudget.load(std::memory_order_relaxed);
+}
+
+TCPBufferPoolStats TCPBufferPool::getStats(void)
+{
+    TCPBufferPoolStats stats;
+    stats.budgetBytes = TCPNetworkLinux_poolBudget.load(std::memory_order_relaxed);
+    stats.reservedBytes = TCPNetworkLinux_poolReserved.load(std::memory_order_relaxed);
+    stats.usedBytes = TCPNetworkLinux_poolUsed.load(std::memory_order_relaxed);
+    stats.slabs = TCPNetworkLinux_poolSlabs.load(std::memory_order_relaxed);
+    stats.refusals = TCPNetworkLinux_poolRefusals.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+void TCPBufferPool::formatPrometheus(std::string &output, bool withHeader)
+{
+    TCPBufferPoolStats stats = getStats();
+
+    const struct
+    {
+        const char* name;
+        const char* type;
+        const char* help;
+        uint64_t value;
+    } metrics[] =
+    {
+        {"tcpnetworklinux_pool_budget_bytes",           "gauge",   "Memory budget of buffer pool. 0 means unlimited.",          stats.budgetBytes},
+        {"tcpnetworklinux_pool_reserved_bytes",         "gauge",   "Memory taken from system by pool slabs and large chunks.",  stats.reservedBytes},
+        {"tcpnetworklinux_pool_used_bytes",             "gauge",   "Bytes of pool chunks in use.",                              stats.usedBytes},
+        {"tcpnetworklinux_pool_slabs",                  "gauge",   "Number of pool slabs.",                                     stats.slabs},
+        {"tcpnetworklinux_pool_budget_refusals_total",  "counter", "Allocations refused by memory budget.",                     stats.refusals},
+    };
+
+    for (const auto &metric : metrics)
+    {
+        if (withHeader)
+        {
+            output += std::string("# HELP ") + metric.name + " " + metric.help + "\n";
+            output += std::string("# TYPE ") + metric.name + " " + metric.type + "\n";
+        }
+
+        output += std::string(metric.name) + " " + std::to_string(metric.value) + "\n";
+    }
+}
+
+void TCPBufferPool::release(void)
+{
+    TCPNetworkLinux_BufferCache* cache = TCPNetworkLinux_localCache();
+    if (cache == nullptr)
+    {
+        return;
+    }
+
+    TCPNetworkLinux_drainRemoteChunks(*cache);
+
+    for (TCPNetworkLinux_Slab* &slab : cache->spare)
+    {
+        if (slab != nullptr)
+        {
+            TCPNetworkLinux_freeSlab(slab);
+            slab = nullptr;
+        }
+    }
+}
+
+// ######################################################################
+// TCPRingBuffer class:
+
+TCPRingBuffer::TCPRingBuffer()
+{
+    _data = nullptr;
+    _capacity = 0;
+    _readIndex = 0;
+    _writeIndex = 0;
+    _mirrored = false;
+}
+
+TCPRingBuffer::~TCPRingBuffer()
+{
+    _release(_data, _capacity, _mirrored);
+}
+
+bool TCPRingBuffer::reserve(size_t capacity)
+{
+    if (capacity <= _capacity)
+    {
+        return true;
+    }
+
+    return _reallocate(capacity, _mirrored);
+}
+
+bool TCPRingBuffer::setMirrored(bool enable)
+{
+    if (enable == _mirrored)
+    {
+        return true;
+    }
+
+    return _reallocate(std::max(_capacity, size()), enable);
+}
+
+bool TCPRingBuffer::isMirrored(void) const
+{
+    return _mirrored;
+}
+
+size_t TCPRingBuffer::size(void) const
+{
+    return _writeIndex - _readIndex;
+}
+
+size_t TCPRingBuffer::capacity(void) const
+{
+    return _capacity;
+}
+
+size_t TCPRingBuffer::space(void) const
+{
+    return _capacity - size();
+}
+
+void TCPRingBuffer::release(void)
+{
+    if (!empty() || _mirrored)
+    {
+        return;
+    }
+
+    _release(_data, _capacity, _mirrored);
+
+    _data = nullptr;
+    _capacity = 0;
+    _readIndex = 0;
+    _writeIndex = 0;
+}
+
+bool TCPRingBuffer::empty(void) const
+{
+    return (_writeIndex == _readIndex);
+}
+
+size_t TCPRingBuffer::push(const char* data, size_t size)
+{
+    struct iovec segments[2];
+    writableSegments(segments);
+
+    size = std::min(size, space());
+    if (size == 0)
+    {
+        // Storage may be released. (nullptr)
+        return 0;
+    }
+
+    size_t first = std::min(size, segments[0].iov_len);
+    memcpy(segments[0].iov_base, data, first);
+    memcpy(segments[1].iov_base, data + first, size - first);
+
+    _writeIndex += size;
+
+    return size;
+}
+
+size_t TCPRingBuffer::pushDropOldest(const char* data, size_t size, size_t limit)
+{
+    size_t dropped = 0;
+
+    // Only the newest limit bytes of data can be kept.
+    if (size > limit)
+    {
+        dropped = size - limit;
+        data += dropped;
+        size = limit;
+    }
+
+    if (this->size() + size > limit)
+    {
+        size_t num = std::min(this->size() + size - limit, this->size());
+        discard(num);
+        dropped += num;
+    }
+
+    if (size > space())
+    {
+        reserve(this->size() + size);
+    }
+
+    size_t pushed = push(data, size);
+
+    return dropped + (size - pushed);
+}
+
+size_t TCPRingBuffer::pop(char* data, size_t size)
+{
+    size = peek(data, size);
+    _readIndex += size;
+
+    return size;
+}
+
+void TCPRingBuffer::erase(size_t offset, size_t size)
+{
+    offset = std::min(offset, this->size());
+    size = std::min(size, this->size() - offset);
+
+    if (size == 0)
+    {
+        return;
+    }
+
+    // Move front bytes over the erased range, then the range is at front and it is discarded.
+    size_t mask = _capacity - 1;
+    size_t source = _readIndex & mask;
+    size_t destination = (_readIndex + size) & mask;
+
+    if ( (source + offset <= _capacity) && (destination + offset <= _capacity) )
+    {
+        memmove(_data + destination, _data + source, offset);
+    }
+    else
+    {
+        for (size_t i = offset; i > 0; i--)
+        {
+            _data[(_readIndex + size + i - 1) & mask] = _data[(_readIndex + i - 1) & mask];
+        }
+    }
+
+    _readIndex += size;
+}
+
+size_t TCPRingBuffer::peek(char* data, size_t size) const
+{
+    struct iovec segments[2];
+    readableSegments(segments);
+
+    size = std::min(size, this->size());
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    size_t first = std::min(size, segments[0].iov_len);
+    memcpy(data, segments[0].iov_base, first);
+    memcpy(data + first, segments[1].iov_base, size - first);
+
+    return size;
+}
+
+void TCPRingBuffer::discard(size_t size)
+{
+    _readIndex += std::min(size, this->size());
+}
+
+void TCPRingBuffer::clear(void)
+{
+    _readIndex = 0;
+    _writeIndex = 0;
+}
+
+void TCPRingBuffer::swap(TCPRingBuffer &other)
+{
+    std::swap(_data, other._data);
+    std::swap(_capacity, other._capacity);
+    std::swap(_readIndex, other._readIndex);
+    std::swap(_writeIndex, other._writeIndex);
+    std::swap(_mirrored, other._mirrored);
+}
+
+int TCPRingBuffer::readableSegments(struct iovec segments[2]) const
+{
+    size_t offset = _readIndex & (_capacity - 1);
+    size_t length = size();
+    size_t first = _mirrored ? length : std::min(length, _capacity - offset);
+
+    segments[0].iov_base = _data + offset;
+    segments[0].iov_len = first;
+    segments[1].iov_base = _data;
+    segments[1].iov_len = length - first;
+
+    return (first > 0) + (length > first);
+}
+
+int TCPRingBuffer::writableSegments(struct iovec segments[2]) const
+{
+    size_t offset = _writeIndex & (_capacity - 1);
+    size_t length = space();
+    size_t first = _mirrored ? length : std::min(length, _capacity - offset);
+
+    segments[0].iov_base = _data + offset;
+    segments[0].iov_len = first;
+    segments[1].iov_base = _data;
+    segments[1].iov_len = length - first;
+
+    return (first > 0) + (length > first);
+}
+
+void TCPRingBuffer::commit(size_t size)
+{
+    _writeIndex += std::min(size, space());
+}
+
+std::string_view TCPRingBuffer::readable(void) const
+{
+    struct iovec segments[2];
+    readableSegments(segments);
+
+    return std::string_view((const char*)segments[0].iov_base, segments[0].iov_len);
+}
+
+struct iovec TCPRingBuffer::writable(void) const
+{
+    struct iovec segments[2];
+    writableSegments(segments);
+
+    return segments[0];
+}
+
+std::string_view TCPRingBuffer::linearize(void)
+{
+    struct iovec segments[2];
+
+    if (readableSegments(segments) == 2)
+    {
+        // Data wraps around the end of storage. Rotate storage so data starts at offset zero.
+        size_t length = size();
+        std::rotate(_data, _data + (_readIndex & (_capacity - 1)), _data + _capacity);
+        _readIndex = 0;
+        _writeIndex = length;
+    }
+
+    return readable();
+}
+
+bool TCPRingBuffer::append(const char* data, size_t size)
+{
+    if (!reserve(this->size() + size))
+    {
+        return false;
+    }
+
+    push(data, size);
+
+    return true;
+}
+
+ssize_t TCPRingBuffer::sendTo(int socket)
+{
+    struct msghdr message;
+    struct iovec segments[2];
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = segments;
+    message.msg_iovlen = readableSegments(segments);
+
+    if (message.msg_iovlen == 0)
+    {
+        return 0;
+    }
+
+    ssize_t bytesWrite = sendmsg(socket, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+    if (bytesWrite > 0)
+    {
+        discard(bytesWrite);
+    }
+
+    return bytesWrite;
+}
+
+ssize_t TCPRingBuffer::sendTo(int socket, const struct iovec* buffers, size_t count)
+{
+    struct msghdr message;
+    struct iovec segments[IOV_MAX];
+    ssize_t totalWrite = 0;
+    size_t index = 0;
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = segments;
+
+    do
+    {
+        // Stored data first, then as many buffers as fit in one sendmsg call.
+        size_t segmentNum = readableSegments(segments);
+        size_t first = index;
+
+        while ((index < count) && (segmentNum < IOV_MAX))
+        {
+            segments[segmentNum++] = buffers[index++];
+        }
+
+        if (segmentNum == 0)
+        {
+            break;
+        }
+
+        message.msg_iovlen = segmentNum;
+        ssize_t bytesWrite = sendmsg(socket, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (bytesWrite == -1)
+        {
+            if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR)
+            {
+                return -1;
+            }
+            bytesWrite = 0;
+        }
+
+        totalWrite += bytesWrite;
+
+        size_t storedWrite = std::min((size_t)bytesWrite, size());
+        discard(storedWrite);
+        size_t remained = bytesWrite - storedWrite;
+
+        for (size_t i = first; i < index; i++)
+        {
+            if (remained >= buffers[i].iov_len)
+            {
+                remained -= buffers[i].iov_len;
+                continue;
+            }
+
+            // Socket is full. Queue the unsent tail of this buffer and all next buffers.
+            if (!_reserveTail(buffers + i, count - i, remained))
+            {
+                return -1;
+            }
+            append((const char*)buffers[i].iov_base + remained, buffers[i].iov_len - remained);
+            for (size_t j = i + 1; j < count; j++)
+            {
+                append((const char*)buffers[j].iov_base, buffers[j].iov_len);
+            }
+            return totalWrite;
+        }
+
+        if (!empty())
+        {
+            // Stored data is not sent completely. Queue all next buffers behind it.
+            if (!_reserveTail(buffers + index, count - index, 0))
+            {
+                return -1;
+            }
+            for (size_t j = index; j < count; j++)
+            {
+                append((const char*)buffers[j].iov_base, buffers[j].iov_len);
+            }
+            return totalWrite;
+        }
+
+    } while (index < count);
+
+    return totalWrite;
+}
+
+bool TCPRingBuffer::_reserveTail(const struct iovec* buffers, size_t count, size_t offset)
+{
+    size_t totalBytes = size();
+    for (size_t i = 0; i < count; i++)
+    {
+        totalBytes += buffers[i].iov_len;
+    }
+
+    if (!reserve(totalBytes - offset))
+    {
+        errno = ENOMEM;
+        return false;
+    }
+
+    return true;
+}
+
+ssize_t TCPRingBuffer::recvFrom(int socket, size_t limit, size_t* droppedBytes, std::vector<int>* fileDescriptors)
+{
+    // readv() of zero bytes returns 0, which looks like peer closed.
+    if (limit == 0)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    if (!reserve(2 * limit))
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    size_t dropped = 0;
+
+    if (size() > limit)
+    {
+        dropped += size() - limit;
+        discard(size() - limit);
+    }
+
+    // Receive at most limit bytes straight into free region of storage.
+    struct iovec segments[2];
+    writableSegments(segments);
+    segments[0].iov_len = std::min(segments[0].iov_len, limit);
+    segments[1].iov_len = std::min(segments[1].iov_len, limit - segments[0].iov_len);
+
+    ssize_t bytesRead = _receive(socket, segments, fileDescriptors);
+
+    if ( (bytesRead > 0) && (size() > limit) )
+    {
+        dropped += size() - limit;
+        discard(size() - limit);
+    }
+
+    if (droppedBytes != nullptr)
+    {
+        *droppedBytes += dropped;
+    }
+
+    return bytesRead;
+}
+
+ssize_t TCPRingBuffer::recvAppend(int socket, size_t size, std::vector<int>* fileDescriptors)
+{
+    // readv() of zero bytes returns 0, which looks like peer closed.
+    if (size == 0)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    if (!reserve(this->size() + size))
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    struct iovec segments[2];
+    writableSegments(segments);
+    segments[0].iov_len = std::min(segments[0].iov_len, size);
+    segments[1].iov_len = std::min(segments[1].iov_len, size - segments[0].iov_len);
+
+    return _receive(socket, segments, fileDescriptors);
+}
+
+ssize_t TCPRingBuffer::_receive(int socket, struct iovec segments[2], std::vector<int>* fileDescriptors)
+{
+    int segmentNum = (segments[1].iov_len > 0) ? 2 : 1;
+    ssize_t bytesRead;
+
+    if (fileDescriptors == nullptr)
+    {
+        bytesRead = readv(socket, segments, segmentNum);
+    }
+    else
+    {
+        bytesRead = TCPNetworkLinuxNamespace::receiveFileDescriptors(socket, segments, segmentNum, *fileDescriptors);
+    }
+
+    if (bytesRead > 0)
+    {
+        _writeIndex += bytesRead;
+    }
+
+    return bytesRead;
+}
+
+bool TCPRingBuffer::_reallocate(size_t capacity, bool mirrored)
+{
+    size_t newCapacity = 1;
+    while (newCapacity < capacity)
+    {
+        newCapacity <<= 1;
+    }
+
+    char* data = nullptr;
+
+    if (mirrored)
+    {
+        size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        newCapacity = std::max(newCapacity, pageSize);
+
+        int memSocket = memfd_create("TCPRingBuffer", MFD_CLOEXEC);
+        if (memSocket == -1)
+        {
+            return false;
+        }
+
+        if (ftruncate(memSocket, newCapacity) == -1)
+        {
+            close(memSocket);
+            return false;
+        }
+
+        // Reserve address space for two copies, then map the same pages into both halves.
+        void* base = mmap(nullptr, 2 * newCapacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED)
+        {
+            close(memSocket);
+            return false;
+        }
+
+        data = (char*)base;
+        if ( (mmap(data, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memSocket, 0) == MAP_FAILED) ||
+             (mmap(data + newCapacity, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memSocket, 0) == MAP_FAILED) )
+        {
+            munmap(base, 2 * newCapacity);
+            close(memSocket);
+            return false;
+        }
+
+        close(memSocket);
+    }
+    else
+    {
+        newCapacity = TCPBufferPool::chunkSize(newCapacity);
+
+        data = (char*)TCPBufferPool::allocate(newCapacity);
+        if (data == nullptr)
+        {
+            return false;
+        }
+    }
+
+    size_t length = peek(data, size());
+
+    _release(_data, _capacity, _mirrored);
+
+    _data = data;
+    _capacity = newCapacity;
+    _mirrored = mirrored;
+    _readIndex = 0;
+    _writeIndex = length;
+
+    return true;
+}
+
+void TCPRingBuffer::_release(char* data, size_t capacity, bool mirrored)
+{
+    if (data == nullptr)
+    {
+        return;
+    }
+
+    if (mirrored)
+    {
+        munmap(data, 2 * capacity);
+    }
+    else
+    {
+        TCPBufferPool::deallocate(data, capacity);
+    }
+}
+
+// ######################################################################
+// TCPFrameTracker class:
+
+TCPFrameTracker::TCPFrameTracker()
+{
+    _bytes = 0;
+    _frontSent = 0;
+    _frontLocked = false;
+}
+
+void TCPFrameTracker::push(size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    _frames.push_back(size);
+    _bytes += size;
+}
+
+void TCPFrameTracker::sync(size_t bufferedBytes)
+{
+    if (bufferedBytes > _bytes)
+    {
+        // Bytes were queued without a record. Keep all of them as one frame, since their boundaries are unknown.
+        clear();
+        push(bufferedBytes);
+        _frontLocked = true;
+        return;
+    }
+
+    size_t leftBytes = _bytes - bufferedBytes;
+    _bytes = bufferedBytes;
+
+    while (leftBytes > 0)
+    {
+        size_t frontBytes = std::min(leftBytes, _frames.front() - _frontSent);
+        _frontSent += frontBytes;
+        leftBytes -= frontBytes;
+
+        if (_frontSent == _frames.front())
+        {
+            _frames.pop_front();
+            _frontSent = 0;
+            _frontLocked = false;
+        }
+    }
+
+    _frontLocked = _frontLocked || (_frontSent > 0);
+}
+
+size_t TCPFrameTracker::dropOldest(TCPRingBuffer &buffer, size_t size)
+{
+    size_t first = _frontLocked ? 1 : 0;
+    size_t offset = _frontLocked ? (_frames.front() - _frontSent) : 0;
+    size_t last = first;
+    size_t droppedBytes = 0;
+
+    while ( (last < _frames.size()) && (droppedBytes < size) )
+    {
+        droppedBytes += _frames[last];
+        last++;
+    }
+
+    if (droppedBytes > 0)
+    {
+        buffer.erase(offset, droppedBytes);
+        _frames.erase(_frames.begin() + first, _frames.begin() + last);
+        _bytes -= droppedBytes;
+    }
+
+    return droppedBytes;
+}
+
+void TCPFrameTracker::clear(void)
+{
+    _frames.clear();
+    _bytes = 0;
+    _frontSent = 0;
+    _frontLocked = false;
+}
+
+// ######################################################################
+// TCPStats class:
+
+// Prometheus metric name, type and help of every TCPStatsCounter.
+static const char* TCPNetworkLinux_statsMetrics[(size_t)TCPStatsCounter::Count][3] =
+{
+    {"tcpnetworklinux_rx_bytes_total",              "counter", "Bytes received."},
+    {"tcpnetworklinux_rx_calls_total",              "counter", "Receive syscalls or completions."},
+    {"tcpnetworklinux_rx_eagain_total",             "counter", "Receive calls that would block."},
+    {"tcpnetworklinux_rx_dropped_bytes_total",      "counter", "Received bytes dropped by RX buffer overflow trimming."},
+    {"tcpnetworklinux_rx_buffer_high_water_bytes",  "gauge",   "Maximum RX buffer size."},
+    {"tcpnetworklinux_rx_pauses_total",             "counter", "Times that reading stopped since RX buffer was full."},
+    {"tcpnetworklinux_tx_bytes_total",              "counter", "Bytes sent."},
+    {"tcpnetworklinux_tx_calls_total",              "counter", "Send syscalls or completions."},
+    {"tcpnetworklinux_tx_eagain_total",             "counter", "Send calls that would block."},
+    {"tcpnetworklinux_tx_partial_writes_total",     "counter", "Send calls that accepted only part of offered data."},
+    {"tcpnetworklinux_tx_dropped_bytes_total",      "counter", "Queued bytes dropped by TX buffer overflow trimming."},
+    {"tcpnetworklinux_tx_queue_high_water_bytes",   "gauge",   "Maximum TX queue size."},
+    {"tcpnetworklinux_tx_refused_total",            "counter", "Enqueue calls refused since TX queue was full."},
+    {"tcpnetworklinux_accepts_total",               "counter", "Accepted connections."},
+    {"tcpnetworklinux_disconnects_total",           "counter", "Closed connections."},
+};
+
+TCPStats::TCPStats()
+{
+    reset();
+}
+
+void TCPStats::add(TCPStatsCounter counter, uint64_t value)
+{
+    // Single writer: plain load and store, no locked read-modify-write.
+    std::atomic<uint64_t> &target = _counters[(size_t)counter];
+    target.store(target.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void TCPStats::max(TCPStatsCounter counter, uint64_t value)
+{
+    std::atomic<uint64_t> &target = _counters[(size_t)counter];
+    if (value > target.load(std::memory_order_relaxed))
+    {
+        target.store(value, std::memory_order_relaxed);
+    }
+}
+
+void TCPStats::countRx(ssize_t bytesRead, size_t droppedBytes, size_t bufferedBytes)
+{
+    add(TCPStatsCounter::RxCalls);
+
+    if (bytesRead > 0)
+    {
+        add(TCPStatsCounter::RxBytes, bytesRead);
+    }
+    else if ((bytesRead == -EAGAIN) || (bytesRead == -EWOULDBLOCK))
+    {
+        add(TCPStatsCounter::RxEagain);
+    }
+
+    if (droppedBytes > 0)
+    {
+        add(TCPStatsCounter::RxDroppedBytes, droppedBytes);
+    }
+
+    max(TCPStatsCounter::RxHighWater, bufferedBytes);
+}
+
+void TCPStats::countTx(ssize_t bytesWrite, size_t offeredBytes, size_t queuedBytes)
+{
+    add(TCPStatsCounter::TxCalls);
+
+    if (bytesWrite >= 0)
+    {
+        add(TCPStatsCounter::TxBytes, bytesWrite);
+        if ((size_t)bytesWrite < offeredBytes)
+        {
+            add(TCPStatsCounter::TxPartialWrites);
+        }
+    }
+    else if ((bytesWrite == -EAGAIN) || (bytesWrite == -EWOULDBLOCK))
+    {
+        add(TCPStatsCounter::TxEagain);
+    }
+
+    max(TCPStatsCounter::TxHighWater, queuedBytes);
+}
+
+uint64_t TCPStats::get(TCPStatsCounter counter) const
+{
+    return _counters[(size_t)counter].load(std::memory_order_relaxed);
+}
+
+TCPStatsSnapshot TCPStats::snapshot(void) const
+{
+    TCPStatsSnapshot snapshot;
+
+    for (size_t i = 0; i < (size_t)TCPStatsCounter::Count; i++)
+    {
+        snapshot.counters[i] = _counters[i].load(std::memory_order_relaxed);
+    }
+
+    return snapshot;
+}
+
+void TCPStats::reset(void)
+{
+    for (std::atomic<uint64_t> &counter : _counters)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+void TCPStats::formatPrometheus(std::string &output, const TCPStatsSnapshot &snapshot, const std::string &labels, bool withHeader)
+{
+    for (size_t i = 0; i < (size_t)TCPStatsCounter::Count; i++)
+    {
+        const char* name = TCPNetworkLinux_statsMetrics[i][0];
+
+        if (withHeader)
+        {
+            output += std::string("# HELP ") + name + " " + TCPNetworkLinux_statsMetrics[i][2] + "\n";
+            output += std::string("# TYPE ") + name + " " + TCPNetworkLinux_statsMetrics[i][1] + "\n";
+        }
+
+        output += std::string(name) + "{" + labels + "} " + std::to_string(snapshot.counters[i]) + "\n";
+    }
+}
+
+// ######################################################################
+// TCPTimer class:
+
+TCPTimer::TCPTimer()
+{
+    _wheel = nullptr;
+    _previous = nullptr;
+    _next = nullptr;
+    _expiry = 0;
+    _level = 0;
+    _slot = 0;
+    _callback = nullptr;
+    _context = nullptr;
+}
+
+TCPTimer::TCPTimer(Callback callback, void* context) : TCPTimer()
+{
+    _callback = callback;
+    _context = context;
+}
+
+TCPTimer::~TCPTimer()
+{
+    cancel();
+}
+
+void TCPTimer::setCallback(Callback callback, void* context)
+{
+    _callback = callback;
+    _context = context;
+}
+
+bool TCPTimer::isArmed(void)
+{
+    return _wheel != nullptr;
+}
+
+uint64_t TCPTimer::getExpiry(void)
+{
+    return _expiry;
+}
+
+void TCPTimer::cancel(void)
+{
+    if (_wheel != nullptr)
+    {
+        _wheel->cancel(*this);
+    }
+}
+
+// ######################################################################
+// TCPTimerWheel class:
+
+TCPTimerWheel::TCPTimerWheel()
+{
+    memset(_slots, 0, sizeof(_slots));
+    memset(_occupied, 0, sizeof(_occupied));
+    _tick = 0;
+    _time = 0;
+    _count = 0;
+    _start = std::chrono::steady_clock::now();
+}
+
+TCPTimerWheel::~TCPTimerWheel()
+{
+    for (size_t level = 0; level < TCPNetworkLinux_TIMER_WHEEL_LEVELS; level++)
+    {
+        for (size_t slot = 0; slot < 64; slot++)
+        {
+            while (_slots[level][slot] != nullptr)
+            {
+                _unlink(*_slots[level][slot]);
+            }
+        }
+    }
+}
+
+void TCPTimerWheel::arm(TCPTimer &timer, int64_t delayMs)
+{
+    armAt(timer, (delayMs > 0) ? (_time + delayMs) : 0);
+}
+
+void TCPTimerWheel::armAt(TCPTimer &timer, uint64_t expiry)
+{
+    if (timer._wheel != nullptr)
+    {
+        timer._wheel->_unlink(timer);
+    }
+
+    timer._expiry = expiry;
+
+    // Current tick is already processed, so earliest expiry is next tick.
+    _insert(timer, _tick + 1);
+}
+
+void TCPTimerWheel::cancel(TCPTimer &timer)
+{
+    if (timer._wheel == this)
+    {
+        _unlink(timer);
+    }
+}
+
+void TCPTimerWheel::updateTime(void)
+{
+    _time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+uint64_t TCPTimerWheel::getTime(void)
+{
+    return _time;
+}
+
+size_t TCPTimerWheel::size(void)
+{
+    return _count;
+}
+
+size_t TCPTimerWheel::advance(void)
+{
+    updateTime();
+
+    size_t expiredNum = 0;
+
+    while ( (_tick < _time) && (_count > 0) )
+    {
+        // Jump to next occupied slot of level 0 or to next wrap of level 0 where upper levels cascade.
+        uint64_t index = _tick & 63;
+        uint64_t next = (_tick | 63) + 1;
+        uint64_t later = (index == 63) ? 0 : (_occupied[0] & (~0ULL << (index + 1)));
+        if (later != 0)
+        {
+            next = (_tick & ~63ULL) + __builtin_ctzll(later);
+        }
+
+        if (next > _time)
+        {
+            break;
+        }
+
+        _tick = next;
+
+        if ((_tick & 63) == 0)
+        {
+            // Highest level first, so its timers are placed again before lower levels cascade.
+            size_t level = 1;
+            while ( (level < TCPNetworkLinux_TIMER_WHEEL_LEVELS - 1) && (((_tick >> (6 * level)) & 63) == 0) )
+            {
+                level++;
+            }
+            for (; level > 0; level--)
+            {
+                _cascade(level);
+            }
+        }
+
+        // Callbacks may cancel or arm other timers, so the slot is read again for every timer.
+        size_t slot = _tick & 63;
+        while (_slots[0][slot] != nullptr)
+        {
+            TCPTimer* timer = _slots[0][slot];
+            _unlink(*timer);
+            expiredNum++;
+
+            if (timer->_callback != nullptr)
+            {
+                timer->_callback(*timer, timer->_context);
+            }
+        }
+    }
+
+    _tick = _time;
+
+    return expiredNum;
+}
+
+int TCPTimerWheel::getTimeout(int maxTimeoutMs)
+{
+    if (_count == 0)
+    {
+        return maxTimeoutMs;
+    }
+
+    // Next tick when a slot of any level is processed. Level L slot is processed at start of its 64^L block.
+    uint64_t next = UINT64_MAX;
+    for (size_t level = 0; level < TCPNetworkLinux_TIMER_WHEEL_LEVELS; level++)
+    {
+        if (_occupied[level] == 0)
+        {
+            continue;
+        }
+
+        uint64_t block = _tick >> (6 * level);
+        uint64_t index = block & 63;
+        uint64_t later = (index == 63) ? 0 : (_occupied[level] & (~0ULL << (index + 1)));
+        uint64_t nextBlock = (later != 0) ? ((block & ~63ULL) + __builtin_ctzll(later)) : ((block & ~63ULL) + 64 + __builtin_ctzll(_occupied[level]));
+
+        next = std::min(next, nextBlock << (6 * level));
+    }
+
+    uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+    uint64_t waitMs = (next > now) ? (next - now) : 0;
+
+    if ( (maxTimeoutMs >= 0) && (waitMs > (uint64_t)maxTimeoutMs) )
+    {
+        return maxTimeoutMs;
+    }
+
+    return (int)std::min<uint64_t>(waitMs, INT_MAX);
+}
+
+void TCPTimerWheel::_insert(TCPTimer &timer, uint64_t minimum)
+{
+    uint64_t expiry = std::max(timer._expiry, minimum);
+    timer._expiry = expiry;
+
+    // Level is chosen by distance from last processed tick. Timers beyond the last level are placed at its end.
+    uint64_t delta = expiry - _tick;
+    size_t level = 0;
+    while ( (level < TCPNetworkLinux_TIMER_WHEEL_LEVELS - 1) && (delta >= (1ULL << (6 * (level + 1)))) )
+    {
+        level++;
+    }
+
+    const uint64_t range = 1ULL << (6 * TCPNetworkLinux_TIMER_WHEEL_LEVELS);
+    if (delta >= range)
+    {
+        expiry = _tick + range - 1;
+    }
+
+    size_t slot = (expiry >> (6 * level)) & 63;
+
+    timer._wheel = this;
+    timer._level = (uint8_t)level;
+    timer._slot = (uint8_t)slot;
+    timer._previous = nullptr;
+    timer._next = _slots[level][slot];
+    if (timer._next != nullptr)
+    {
+        timer._next->_previous = &timer;
+    }
+    _slots[level][slot] = &timer;
+    _occupied[level] |= (1ULL << slot);
+    _count++;
+}
+
+void TCPTimerWheel::_unlink(TCPTimer &timer)
+{
+    if (timer._previous != nullptr)
+    {
+        timer._previous->_next = timer._next;
+    }
+    else
+    {
+        _slots[timer._level][timer._slot] = timer._next;
+        if (timer._next == nullptr)
+        {
+            _occupied[timer._level] &= ~(1ULL << timer._slot);
+        }
+    }
+
+    if (timer._next != nullptr)
+    {
+        timer._next->_previous = timer._previous;
+    }
+
+    timer._wheel = nullptr;
+    timer._previous = nullptr;
+    timer._next = nullptr;
+    _count--;
+}
+
+void TCPTimerWheel::_cascade(size_t level)
+{
+    size_t slot = (_tick >> (6 * level)) & 63;
+
+    TCPTimer* timer = _slots[level][slot];
+    _slots[level][slot] = nullptr;
+    _occupied[level] &= ~(1ULL << slot);
+
+    // Expiry at current tick is allowed, so these timers expire in this tick.
+    while (timer != nullptr)
+    {
+        TCPTimer* next = timer->_next;
+        _count--;
+        _insert(*timer, _tick);
+        timer = next;
+    }
+}
+
+// ######################################################################
+// TCPIoUring struct:
+
+// Request types stored in low bits of io_uring user_data. Connection requests carry the TCPConnection pointer in the other bits.
+#define TCPNetworkLinux_URING_ACCEPT        1
+#define TCPNetworkLinux_URING_RECV          2
+#define TCPNetworkLinux_URING_SEND          3
+#define TCPNetworkLinux_URING_CANCEL        4
+#define TCPNetworkLinux_URING_NOTIFY        5
+#define TCPNetworkLinux_URING_TYPE_MASK     7ULL
+
+#define TCPNetworkLinux_URING_ENTRIES       256             // Submission queue size of io_uring backend
+#define TCPNetworkLinux_URING_BUFFER_GROUP  0               // Provided buffer group id
+
+/**
+ * Raw io_uring instance of TCPServer event loop. It uses io_uring syscalls directly without liburing.
+ * Shared ring indexes are accessed by acquire/release atomics as the kernel ABI requires.
+ */
+struct TCPIoUring
+{
+    int ringSocket = -1;                        // io_uring descriptor.
+    std::string errorMessage;                   // Reason if start() failed.
+
+    unsigned sqEntries = 0;
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    struct io_uring_sqe* sqes = (struct io_uring_sqe*)MAP_FAILED;
+    size_t sqesSize = 0;
+    unsigned sqLocalTail = 0;                   // Tail of prepared entries. Published before io_uring_enter.
+    unsigned toSubmit = 0;                      // Number of prepared entries that are not submitted.
+
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    struct io_uring_cqe* cqes = nullptr;
+
+    struct io_uring_buf_ring* bufRing = (struct io_uring_buf_ring*)MAP_FAILED;
+    size_t bufRingSize = 0;
+    char* bufMemory = nullptr;
+    unsigned bufLocalTail = 0;
+    bool bufRegistered = false;
+
+    unsigned fileSlots = 0;                     // Size of registered file table. Zero if it is not supported.
+
+    ~TCPIoUring()
+    {
+        stop();
+    }
+
+    bool start(unsigned entries, unsigned slots)
+    {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 8;
+
+        ringSocket = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (ringSocket == -1)
+        {
+            errorMessage = "io_uring_setup failed";
+            return false;
+        }
+
+        if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+        {
+            errorMessage = "kernel lacks IORING_FEAT_EXT_ARG/IORING_FEAT_NODROP";
+            return false;
+        }
+
+        // Multishot recv with provided buffer rings exists since Linux 6.0.
+        struct utsname name;
+        int major = 0, minor = 0;
+        if ((uname(&name) != 0) || (sscanf(name.release, "%d.%d", &major, &minor) != 2) || (major < 6))
+        {
+            errorMessage = "kernel older than 6.0 lacks multishot recv";
+            return false;
+        }
+
+        sqEntries = params.sq_entries;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringSocket, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED)
+        {
+            errorMessage = "mmap of submission queue failed";
+            return false;
+        }
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            cqRing = sqRing;
+        }
+        else
+        {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringSocket, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED)
+            {
+                errorMessage = "mmap of completion queue failed";
+                return false;
+            }
+        }
+
+        sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        sqes = (struct io_uring_sqe*)mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringSocket, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+        {
+            errorMessage = "mmap of submission entries failed";
+            return false;
+        }
+
+        sqHead = (unsigned*)((char*)sqRing + params.sq_off.head);
+        sqTail = (unsigned*)((char*)sqRing + params.sq_off.tail);
+        sqMask = (unsigned*)((char*)sqRing + params.sq_off.ring_mask);
+        sqArray = (unsigned*)((char*)sqRing + params.sq_off.array);
+        sqLocalTail = *sqTail;
+
+        cqHead = (unsigned*)((char*)cqRing + params.cq_off.head);
+        cqTail = (unsigned*)((char*)cqRing + params.cq_off.tail);
+        cqMask = (unsigned*)((char*)cqRing + params.cq_off.ring_mask);
+        cqes = (struct io_uring_cqe*)((char*)cqRing + params.cq_off.cqes);
+
+        if (!_probe())
+        {
+            return false;
+        }
+
+        // Provided buffer ring for multishot recv.
+        bufRingSize = TCPNetworkLinux_URING_BUFFER_NUM * sizeof(struct io_uring_buf);
+        bufRing = (struct io_uring_buf_ring*)mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (bufRing == MAP_FAILED)
+        {
+            errorMessage = "mmap of provided buffer ring failed";
+            return false;
+        }
+
+        struct io_uring_buf_reg bufReg;
+        memset(&bufReg, 0, sizeof(bufReg));
+        bufReg.ring_addr = (uint64_t)bufRing;
+        bufReg.ring_entries = TCPNetworkLinux_URING_BUFFER_NUM;
+        bufReg.bgid = TCPNetworkLinux_URING_BUFFER_GROUP;
+        if (syscall(__NR_io_uring_register, ringSocket, IORING_REGISTER_PBUF_RING, &bufReg, 1) != 0)
+        {
+            errorMessage = "kernel lacks provided buffer rings";
+            return false;
+        }
+        bufRegistered = true;
+
+        bufMemory = (char*)malloc((size_t)TCPNetworkLinux_URING_BUFFER_NUM * TCPNetworkLinux_URING_BUFFER_SIZE);
+        if (bufMemory == nullptr)
+        {
+            errorMessage = "allocation of provided buffers failed";
+            return false;
+        }
+
+        for (unsigned i = 0; i < TCPNetworkLinux_URING_BUFFER_NUM; i++)
+        {
+            recycleBuffer(i);
+        }
+
+        // Registered file table. Sockets use the slot equal to their descriptor. Optional feature.
+        struct io_uring_rsrc_register filesReg;
+        memset(&filesReg, 0, sizeof(filesReg));
+        filesReg.nr = slots;
+        filesReg.flags = IORING_RSRC_REGISTER_SPARSE;
+        if (syscall(__NR_io_uring_register, ringSocket, IORING_REGISTER_FILES2, &filesReg, sizeof(filesReg)) == 0)
+        {
+            fileSlots = slots;
+        }
+
+        return true;
+    }
+
+    void stop(void)
+    {
+        // Close ring first. Kernel cancels and reaps its requests, so no recv writes into buffers after they are released.
+        if (ringSocket != -1)
+        {
+            close(ringSocket);
+            ringSocket = -1;
+        }
+
+        if (bufMemory != nullptr)
+        {
+            free(bufMemory);
+            bufMemory = nullptr;
+        }
+
+        if (bufRing != MAP_FAILED)
+        {
+            munmap(bufRing, bufRingSize);
+            bufRing = (struct io_uring_buf_ring*)MAP_FAILED;
+        }
+
+        if (sqes != MAP_FAILED)
+        {
+            munmap(sqes, sqesSize);
+            sqes = (struct io_uring_sqe*)MAP_FAILED;
+        }
+
+        if ((cqRing != MAP_FAILED) && (cqRing != sqRing))
+        {
+            munmap(cqRing, cqRingSize);
+        }
+        cqRing = MAP_FAILED;
+
+        if (sqRing != MAP_FAILED)
+        {
+            munmap(sqRing, sqRingSize);
+            sqRing = MAP_FAILED;
+        }
+    }
+
+    /**
+     * Return a cleared submission entry. Submit prepared entries first if submission queue is full.
+     * return nullptr if the queue is still full, since kernel may refuse or take only part of the entries. (EBUSY, EAGAIN, EINTR)
+     */
+    struct io_uring_sqe* getSqe(void)
+    {
+        if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+        {
+            enter(0, 0);
+            if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+            {
+                return nullptr;
+            }
+        }
+
+        unsigned index = sqLocalTail & *sqMask;
+        struct io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        sqLocalTail++;
+        toSubmit++;
+
+        return sqe;
+    }
+
+    // Submit prepared entries and wait for waitNum completions or timeout. return -1 if there is any error.
+    int enter(unsigned waitNum, int timeoutMs)
+    {
+        __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+
+        unsigned flags = 0;
+        struct io_uring_getevents_arg arg;
+        struct __kernel_timespec timeout;
+        void* argPtr = nullptr;
+        size_t argSize = 0;
+
+        if (waitNum > 0)
+        {
+            flags |= IORING_ENTER_GETEVENTS;
+            if (timeoutMs >= 0)
+            {
+                timeout.tv_sec = timeoutMs / 1000;
+                timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+                memset(&arg, 0, sizeof(arg));
+                arg.ts = (uint64_t)&timeout;
+                flags |= IORING_ENTER_EXT_ARG;
+                argPtr = &arg;
+                argSize = sizeof(arg);
+            }
+        }
+
+        long submitted = syscall(__NR_io_uring_enter, ringSocket, toSubmit, waitNum, flags, argPtr, argSize);
+        if (submitted == -1)
+        {
+            // Timeout, signal or completion queue backlog are not errors of the event loop.
+            return ((errno == ETIME) || (errno == EINTR) || (errno == EBUSY) || (errno == EAGAIN)) ? 0 : -1;
+        }
+
+        toSubmit -= std::min((unsigned)submitted, toSubmit);
+
+        return (int)submitted;
+    }
+
+    // Return true if a completion is available.
+    bool hasCompletion(void)
+    {
+        return (*cqHead != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE));
+    }
+
+    // Give a provided buffer back to the kernel.
+    void recycleBuffer(unsigned bufferId)
+    {
+        // Index ring memory as a plain array. In C++ the bufs member of linux/io_uring.h is shifted by its empty struct wrapper.
+        struct io_uring_buf* buffer = (struct io_uring_buf*)bufRing + (bufLocalTail & (TCPNetworkLinux_URING_BUFFER_NUM - 1));
+        buffer->addr = (uint64_t)(bufMemory + (size_t)bufferId * TCPNetworkLinux_URING_BUFFER_SIZE);
+        buffer->len = TCPNetworkLinux_URING_BUFFER_SIZE;
+        buffer->bid = (uint16_t)bufferId;
+        bufLocalTail++;
+        __atomic_store_n(&bufRing->tail, (uint16_t)bufLocalTail, __ATOMIC_RELEASE);
+    }
+
+    // Return data pointer of a provided buffer.
+    const char* buffer(unsigned bufferId)
+    {
+        return bufMemory + (size_t)bufferId * TCPNetworkLinux_URING_BUFFER_SIZE;
+    }
+
+    // Put socket into registered file table. return slot index or -1.
+    int registerFile(int socket)
+    {
+        if ((socket < 0) || ((unsigned)socket >= fileSlots))
+        {
+            return -1;
+        }
+
+        struct io_uring_files_update update;
+        memset(&update, 0, sizeof(update));
+        update.offset = (uint32_t)socket;
+        update.fds = (uint64_t)&socket;
+
+        if (syscall(__NR_io_uring_register, ringSocket, IORING_REGISTER_FILES_UPDATE, &update, 1) != 1)
+        {
+            return -1;
+        }
+
+        return socket;
+    }
+
+    // Remove socket from registered file table.
+    void unregisterFile(int slot)
+    {
+        if (slot < 0)
+        {
+            return;
+        }
+
+        int socket = -1;
+        struct io_uring_files_update update;
+        memset(&update, 0, sizeof(update));
+        update.offset = (uint32_t)slot;
+        update.fds = (uint64_t)&socket;
+        syscall(__NR_io_uring_register, ringSocket, IORING_REGISTER_FILES_UPDATE, &update, 1);
+    }
+
+    // Check that all needed opcodes are supported.
+    bool _probe(void)
+    {
+        const size_t opNum = 256;
+        std::vector<char> memory(sizeof(struct io_uring_probe) + opNum * sizeof(struct io_uring_probe_op), 0);
+        struct io_uring_probe* probe = (struct io_uring_probe*)memory.data();
+
+        if (syscall(__NR_io_uring_register, ringSocket, IORING_REGISTER_PROBE, probe, opNum) != 0)
+        {
+            errorMessage = "io_uring probe failed";
+            return false;
+        }
+
+        const int ops[] = {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ASYNC_CANCEL};
+        for (int op : ops)
+        {
+            if ((op > probe->last_op) || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+            {
+                errorMessage = "kernel lacks needed io_uring opcodes";
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+// ######################################################################
+// TCPConnection class:
+
+TCPConnection::TCPConnection(int socket, const struct sockaddr_in &address, size_t rxBufferSize, size_t txBufferSize)
+{
+    _socket = socket;
+    _rxBufferSize = rxBufferSize;
+    _txBufferSize = txBufferSize;
+    _connected = true;
+    _inReadyList = false;
+    _inDrainedList = false;
+    _closeReason = TCPCloseReason::None;
+    _txDeferredList = nullptr;
+    _txDeferred = false;
+    _txInFlight = false;
+    _txWaited = false;
+    _uringPending = 0;
+    _fileSlot = -1;
+    _serverStats = nullptr;
+    _server = nullptr;
+    _timerWheel = nullptr;
+    _idleTimeout = 0;
+    _writeTimeout = 0;
+    _heartbeatInterval = 0;
+    _lastRxTime = 0;
+    _lastTxTime = 0;
+    _overflowPolicy = TCPOverflowPolicy::DropOldest;
+    _txLowWatermark = txBufferSize / 2;
+    _rxLowWatermark = rxBufferSize / 2;
+    _txBlocked = false;
+    _rxPaused = false;
+    _rxResumeList = nullptr;
+    _txUnblockList = nullptr;
+    _rxArmed = false;
+    _unix = (address.sin_family == AF_UNIX);
+    _port = 0;
+
+    char ip[INET_ADDRSTRLEN];
+    if ( (address.sin_family == AF_INET) && (inet_ntop(AF_INET, &address.sin_addr, ip, INET_ADDRSTRLEN) != nullptr) )
+    {
+        _ip = ip;
+        _port = ntohs(address.sin_port);
+    }
+}
+
+int TCPConnection::getSocket(void)
+{
+    return _socket;
+}
+
+std::string TCPConnection::getIP(void)
+{
+    return _ip;
+}
+
+uint16_t TCPConnection::getPort(void)
+{
+    return _port;
+}
+
+TCPSocketOptions TCPConnection::getAppliedSocketOptions(void)
+{
+    return TCPNetworkLinuxNamespace::getSocketOptions(_socket);
+}
+
+TCPStatsSnapshot TCPConnection::getStats(void)
+{
+    return _stats.snapshot();
+}
+
+void TCPConnection::_countRx(ssize_t bytesRead, size_t droppedBytes)
+{
+    _stats.countRx(bytesRead, droppedBytes, _rxBuffer.size());
+
+    if (_serverStats != nullptr)
+    {
+        _serverStats->countRx(bytesRead, droppedBytes, _rxBuffer.size());
+    }
+}
+
+void TCPConnection::_countTx(ssize_t bytesWrite, size_t offeredBytes, size_t queuedBytes)
+{
+    _stats.countTx(bytesWrite, offeredBytes, queuedBytes);
+
+    if (_serverStats != nullptr)
+    {
+        _serverStats->countTx(bytesWrite, offeredBytes, queuedBytes);
+    }
+
+    // Cached time of event loop. Heartbeat timer is re-armed from it when it expires.
+    if ( (bytesWrite > 0) && (_timerWheel != nullptr) )
+    {
+        _lastTxTime = _timerWheel->getTime();
+    }
+}
+
+void TCPConnection::_updateWriteTimer(void)
+{
+    if ( (_timerWheel == nullptr) || (_writeTimeout <= 0) )
+    {
+        return;
+    }
+
+    bool queued = _connected && (!_txBuffer.empty() || !_txSending.empty());
+
+    if (queued && !_writeTimer.isArmed())
+    {
+        _timerWheel->arm(_writeTimer, _writeTimeout);
+    }
+    else if (!queued && _writeTimer.isArmed())
+    {
+        _writeTimer.cancel();
+    }
+}
+
+bool TCPConnection::isConnected(void)
+{
+    return _connected;
+}
+
+TCPCloseReason TCPConnection::getCloseReason(void)
+{
+    return _closeReason;
+}
+
+int32_t TCPConnection::_readAll(bool hangUp)
+{
+    int32_t totalRead = 0;
+
+    // In edge triggered mode the socket must be read until it would block.
+    while (true)
+    {
+        size_t limit = _rxBufferSize;
+        size_t droppedBytes = 0;
+        ssize_t bytesRead;
+
+        if (_overflowPolicy == TCPOverflowPolicy::Backpressure)
+        {
+            // Read only into free space. Unread data stays in socket and TCP flow control slows down the peer.
+            limit = (_rxBuffer.size() < _rxBufferSize) ? (_rxBufferSize - _rxBuffer.size()) : 0;
+            if (limit == 0)
+            {
+                if (!_rxPaused)
+                {
+                    _rxPaused = true;
+                    _stats.add(TCPStatsCounter::RxPauses);
+                    if (_serverStats != nullptr)
+                    {
+                        _serverStats->add(TCPStatsCounter::RxPauses);
+                    }
+                }
+                break;
+            }
+            bytesRead = _rxBuffer.recvAppend(_socket, limit, _unix ? &_rxFileDescriptors : nullptr);
+        }
+        else
+        {
+            // Keep only the newest _rxBufferSize bytes like TCPServer::pushBackRxBuffer().
+            bytesRead = _rxBuffer.recvFrom(_socket, _rxBufferSize, &droppedBytes, _unix ? &_rxFileDescriptors : nullptr);
+        }
+        _countRx((bytesRead == -1) ? -errno : bytesRead, droppedBytes);
+
+        if (bytesRead > 0)
+        {
+            totalRead += bytesRead;
+            // Short read: receive queue is empty. Not for unix sockets, whose recvmsg() stops after a message with descriptors.
+            if (!hangUp && !_unix && ((size_t)bytesRead < limit))
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (bytesRead == 0)
+        {
+            errorMessage = "TCPConnection error: Client disconnected.";
+            _connected = false;
+            _closeReason = TCPCloseReason::PeerClosed;
+            break;
+        }
+
+        if (errno == EINTR)
+        {
+            continue;
+        }
+
+        if (errno == ENOMEM)
+        {
+            errorMessage = "TCPConnection error: Memory budget is exceeded.";
+            _connected = false;
+            _closeReason = TCPCloseReason::Error;
+        }
+        else if (errno != EWOULDBLOCK && errno != EAGAIN)
+        {
+            errorMessage = "TCPConnection error: Error receiving message.";
+            _connected = false;
+            _closeReason = TCPCloseReason::Error;
+        }
+        break;
+    }
+
+    _releaseIdleBuffers();
+
+    if (!_connected && totalRead == 0)
+    {
+        return -1;
+    }
+
+    return totalRead;
+}
+
+bool TCPConnection::write(void)
+{
+    if (_txDeferredList != nullptr)
+    {
+        // io_uring backend. Event loop submits sends of all connections as one batch.
+        if (_connected && !_txDeferred && (!_txBuffer.empty() || !_txSending.empty()))
+        {
+            _txDeferred = true;
+            _txDeferredList->push_back(this);
+        }
+        _updateWriteTimer();
+        return _connected;
+    }
+
+    while (_connected && !_txBuffer.empty())
+    {
+        // Send both ring segments by one syscall. Only sent bytes are removed from the queue.
+        size_t queuedBytes = _txBuffer.size();
+        ssize_t bytesWrite = _txBuffer.sendTo(_socket);
+        _countTx((bytesWrite == -1) ? -errno : bytesWrite, queuedBytes, queuedBytes);
+
+        if (bytesWrite == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (errno == EWOULDBLOCK || errno == EAGAIN)
+            {
+                // Remained data is sent when event loop reports the socket writable.
+                _reportUnblockedTx();
+                _updateWriteTimer();
+                return true;
+            }
+
+            errorMessage = "TCPConnection error: Error sending message.";
+            _connected = false;
+            _closeReason = TCPCloseReason::Error;
+            return false;
+        }
+
+    }
+
+    _reportUnblockedTx();
+    _releaseIdleBuffers();
+    _updateWriteTimer();
+
+    return _connected;
+}
+
+bool TCPConnection::write(const char* data, size_t size)
+{
+    if (!_admitTx(size))
+    {
+        return false;
+    }
+
+    if (!_txBuffer.append(data, size))
+    {
+        errorMessage = "TCPConnection error: Memory budget is exceeded.";
+        return false;
+    }
+    _recordTxFrame(size);
+
+    return write();
+}
+
+bool TCPConnection::write(const std::string &data)
+{
+    return write(data.c_str(), data.size());
+}
+
+bool TCPConnection::write(const struct iovec* buffers, size_t count)
+{
+    if (!_connected)
+    {
+        return false;
+    }
+
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        totalBytes += buffers[i].iov_len;
+    }
+
+    if (!_admitTx(totalBytes))
+    {
+        return false;
+    }
+
+    if (_txDeferredList != nullptr)
+    {
+        if (!_txBuffer.reserve(_txBuffer.size() + totalBytes))
+        {
+            errorMessage = "TCPConnection error: Memory budget is exceeded.";
+            return false;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            _txBuffer.append((const char*)buffers[i].iov_base, buffers[i].iov_len);
+        }
+        _recordTxFrame(totalBytes);
+        return write();
+    }
+
+    size_t queuedBytes = _txBuffer.size();
+    size_t offeredBytes = queuedBytes + totalBytes;
+
+    ssize_t bytesWrite = _txBuffer.sendTo(_socket, buffers, count);
+    _countTx((bytesWrite == -1) ? -errno : bytesWrite, offeredBytes, queuedBytes);
+
+    if (bytesWrite == -1)
+    {
+        // Unsent part of buffers is lost when it can not be queued, so the stream is broken.
+        errorMessage = (errno == ENOMEM) ? "TCPConnection error: Memory budget is exceeded." : "TCPConnection error: Error sending message.";
+        _connected = false;
+        _closeReason = TCPCloseReason::Error;
+        return false;
+    }
+
+    _recordTxFrame(totalBytes);
+    _reportUnblockedTx();
+    _updateWriteTimer();
+
+    return true;
+}
+
+size_t TCPConnection::getRxBufferedBytes(void)
+{
+    return _rxBuffer.size();
+}
+
+bool TCPConnection::sendFileDescriptors(const int* fileDescriptors, size_t count, const char* data, size_t size)
+{
+    if (!_connected || !_unix)
+    {
+        errorMessage = "TCPConnection error: Descriptors can be sent only on connected unix domain sockets.";
+        return false;
+    }
+
+    if (_txDeferredList == nullptr)
+    {
+        write();
+    }
+
+    // Descriptors can not be queued in TX buffer, so they are sent only behind fully sent data.
+    if (!_txBuffer.empty() || _txInFlight)
+    {
+        errorMessage = "TCPConnection error: TX buffer is not empty. Descriptors are not sent.";
+        return false;
+    }
+
+    ssize_t bytesWrite = TCPNetworkLinuxNamespace::sendFileDescriptors(_socket, data, size, fileDescriptors, count);
+    _countTx((bytesWrite == -1) ? -errno : bytesWrite, size, 0);
+
+    if (bytesWrite == -1)
+    {
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+        {
+            errorMessage = "TCPConnection error: Socket is full. Descriptors are not sent.";
+            return false;
+        }
+
+        errorMessage = "TCPConnection error: Error sending descriptors.";
+        if (errno != EINVAL)
+        {
+            _connected = false;
+            _closeReason = TCPCloseReason::Error;
+        }
+        return false;
+    }
+
+    if ((size_t)bytesWrite < size)
+    {
+        if (!_txBuffer.append(data + bytesWrite, size - bytesWrite))
+        {
+            errorMessage = "TCPConnection error: Memory budget is exceeded.";
+            _connected = false;
+            _closeReason = TCPCloseReason::Error;
+            return false;
+        }
+        _recordTxFrame(size);
+    }
+
+    return true;
+}
+
+int TCPConnection::popFileDescriptor(void)
+{
+    if (_rxFileDescriptors.empty())
+    {
+        return -1;
+    }
+
+    int fileDescriptor = _rxFileDescriptors.front();
+    _rxFileDescriptors.erase(_rxFileDescriptors.begin());
+
+    return fileDescriptor;
+}
+
+size_t TCPConnection::getTxQueuedBytes(void)
+{
+    return _txBuffer.size() + _txSending.size();
+}
+
+void TCPConnection::removeFrontRxBuffer(size_t num)
+{
+    _rxBuffer.discard(num);
+    _releaseIdleBuffers();
+    _resumeRx();
+}
+
+void TCPConnection::removeAllRxBuffer(void)
+{
+    _rxBuffer.clear();
+    _releaseIdleBuffers();
+    _resumeRx();
+}
+
+std::string_view TCPConnection::peekRxBuffer(void)
+{
+    return _rxBuffer.linearize();
+}
+
+int TCPConnection::peekRxBuffer(struct iovec segments[2])
+{
+    return _rxBuffer.readableSegments(segments);
+}
+
+void TCPConnection::consumeRxBuffer(size_t size)
+{
+    _rxBuffer.discard(size);
+    _releaseIdleBuffers();
+    _resumeRx();
+}
+
+std::string TCPConnection::popFrontRxBuffer(size_t size)
+{
+    std::string data(std::min(size, _rxBuffer.size()), '\0');
+    _rxBuffer.pop(&data[0], data.size());
+    _releaseIdleBuffers();
+    _resumeRx();
+
+    return data;
+}
+
+std::string TCPConnection::popAllRxBuffer(void)
+{
+    return popFrontRxBuffer(_rxBuffer.size());
+}
+
+bool TCPConnection::pushBackTxBuffer(const char* data, size_t size)
+{
+    if (!_admitTx(size))
+    {
+        return false;
+    }
+
+    size_t droppedBytes = 0;
+
+    if (_overflowPolicy == TCPOverflowPolicy::DropOldestFrames)
+    {
+        // Drop whole queued frames, so the peer never receives a cut frame.
+        _txFrames.sync(_txBuffer.size());
+        if (_txBuffer.size() + size > _txBufferSize)
+        {
+            droppedBytes = _txFrames.dropOldest(_txBuffer, _txBuffer.size() + size - _txBufferSize);
+        }
+        if (_txBuffer.append(data, size))
+        {
+            _txFrames.push(size);
+        }
+        else
+        {
+            droppedBytes += size;
+        }
+    }
+    else if (_overflowPolicy == TCPOverflowPolicy::Backpressure)
+    {
+        if (!_txBuffer.append(data, size))
+        {
+            errorMessage = "TCPConnection error: Memory budget is exceeded.";
+            return false;
+        }
+    }
+    else
+    {
+        // Bytes that memory budget does not allow are counted as dropped.
+        droppedBytes = _txBuffer.pushDropOldest(data, size, _txBufferSize);
+    }
+
+    if (droppedBytes > 0)
+    {
+        _stats.add(TCPStatsCounter::TxDroppedBytes, droppedBytes);
+        if (_serverStats != nullptr)
+        {
+            _serverStats->add(TCPStatsCounter::TxDroppedBytes, droppedBytes);
+        }
+    }
+
+    return true;
+}
+
+bool TCPConnection::pushBackTxBuffer(const std::string* data)
+{
+    return pushBackTxBuffer(data->c_str(), data->size());
+}
+
+bool TCPConnection::isTxBlocked(void)
+{
+    return _txBlocked;
+}
+
+bool TCPConnection::isRxPaused(void)
+{
+    return _rxPaused;
+}
+
+bool TCPConnection::_admitTx(size_t size)
+{
+    if (_overflowPolicy != TCPOverflowPolicy::Backpressure)
+    {
+        return true;
+    }
+
+    // Empty queue takes any size, so a message larger than TX buffer is not refused forever.
+    size_t queuedBytes = getTxQueuedBytes();
+    if ( (queuedBytes == 0) || (queuedBytes + size <= _txBufferSize) )
+    {
+        return true;
+    }
+
+    _txBlocked = true;
+    errorMessage = "TCPConnection error: TX buffer is full.";
+
+    _stats.add(TCPStatsCounter::TxRefused);
+    if (_serverStats != nullptr)
+    {
+        _serverStats->add(TCPStatsCounter::TxRefused);
+    }
+
+    return false;
+}
+
+void TCPConnection::_recordTxFrame(size_t size)
+{
+    if (_overflowPolicy == TCPOverflowPolicy::DropOldestFrames)
+    {
+        // Part of frame that is already sent is found by sync().
+        _txFrames.push(size);
+        _txFrames.sync(_txBuffer.size());
+    }
+}
+
+bool TCPConnection::_unblockTx(void)
+{
+    if (!_txBlocked || (getTxQueuedBytes() > _txLowWatermark))
+    {
+        return false;
+    }
+
+    _txBlocked = false;
+
+    return true;
+}
+
+void TCPConnection::_reportUnblockedTx(void)
+{
+    if (_connected && _unblockTx() && (_txUnblockList != nullptr))
+    {
+        _txUnblockList->push_back(this);
+    }
+}
+
+void TCPConnection::_releaseIdleBuffers(void)
+{
+    _rxBuffer.release();
+    _txBuffer.release();
+
+    // Storage of an in flight io_uring send is still read by kernel.
+    if (!_txInFlight)
+    {
+        _txSending.release();
+    }
+}
+
+void* TCPConnection::operator new(size_t size)
+{
+    void* pointer = TCPBufferPool::allocate(size, true);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+void TCPConnection::operator delete(void* pointer, size_t size) noexcept
+{
+    TCPBufferPool::deallocate(pointer, size);
+}
+
+void TCPConnection::_resumeRx(void)
+{
+    if (!_rxPaused || (_rxBuffer.size() > _rxLowWatermark))
+    {
+        return;
+    }
+
+    _rxPaused = false;
+    if (_rxResumeList != nullptr)
+    {
+        _rxResumeList->push_back(this);
+    }
+}
+
+void TCPConnection::_close(void)
+{
+    _idleTimer.cancel();
+    _writeTimer.cancel();
+    _heartbeatTimer.cancel();
+
+    if (_socket != -1)
+    {
+        close(_socket);
+        _socket = -1;
+    }
+    _connected = false;
+
+    for (int fileDescriptor : _rxFileDescriptors)
+    {
+        close(fileDescriptor);
+    }
+    _rxFileDescriptors.clear();
+}
+
+// ######################################################################
+// TCPFrameCodec class:
+
+#define TCPNetworkLinux_VARINT_MAX_SIZE     10              // Maximum size of 64 bit varint length header
+
+TCPFrameCodec::TCPFrameCodec(TCPFrameHeader header, size_t maxFrameSize)
+{
+    _header = header;
+    _maxFrameSize = maxFrameSize;
+    setMaxFrameSize(maxFrameSize);
+}
+
+void TCPFrameCodec::setHeader(TCPFrameHeader header)
+{
+    _header = header;
+    setMaxFrameSize(_maxFrameSize);
+}
+
+TCPFrameHeader TCPFrameCodec::getHeader(void)
+{
+    return _header;
+}
+
+void TCPFrameCodec::setMaxFrameSize(size_t size)
+{
+    _maxFrameSize = std::min(size, _headerLimit());
+}
+
+size_t TCPFrameCodec::getMaxFrameSize(void)
+{
+    return _maxFrameSize;
+}
+
+size_t TCPFrameCodec::headerSize(size_t frameSize)
+{
+    switch (_header)
+    {
+        case TCPFrameHeader::Fixed16BE:
+        case TCPFrameHeader::Fixed16LE:
+            return 2;
+        case TCPFrameHeader::Fixed32BE:
+        case TCPFrameHeader::Fixed32LE:
+            return 4;
+        default:
+        {
+            size_t size = 1;
+            while (frameSize >= 0x80)
+            {
+                frameSize >>= 7;
+                size++;
+            }
+            return size;
+        }
+    }
+}
+
+ssize_t TCPFrameCodec::decode(TCPRingBuffer &buffer, std::string_view &frame)
+{
+    // Header is copied out, because it may wrap around the end of storage.
+    uint8_t header[TCPNetworkLinux_VARINT_MAX_SIZE];
+    size_t available = buffer.peek((char*)header, sizeof(header));
+    size_t headerBytes = 0;
+    size_t frameSize = 0;
+
+    switch (_header)
+    {
+        case TCPFrameHeader::Fixed16BE:
+        case TCPFrameHeader::Fixed16LE:
+            headerBytes = 2;
+            if (available < headerBytes)
+            {
+                return 0;
+            }
+            frameSize = (_header == TCPFrameHeader::Fixed16BE) ? ((size_t)header[0] << 8) | header[1] : 
+                                                                 ((size_t)header[1] << 8) | header[0];
+            break;
+        case TCPFrameHeader::Fixed32BE:
+        case TCPFrameHeader::Fixed32LE:
+            headerBytes = 4;
+            if (available < headerBytes)
+            {
+                return 0;
+            }
+            for (size_t i = 0; i < 4; i++)
+            {
+                frameSize = (frameSize << 8) | header[(_header == TCPFrameHeader::Fixed32BE) ? i : 3 - i];
+            }
+            break;
+        default:
+            while (true)
+            {
+                if (headerBytes == available)
+                {
+                    // Incomplete varint. It is invalid if it can not be completed within maximum varint size.
+                    if (available == TCPNetworkLinux_VARINT_MAX_SIZE)
+                    {
+                        errorMessage = "TCPFrameCodec error: Invalid varint length header.";
+                        return -1;
+                    }
+                    return 0;
+                }
+
+                uint8_t byte = header[headerBytes];
+                frameSize |= (size_t)(byte & 0x7F) << (7 * headerBytes);
+                headerBytes++;
+
+                if ((byte & 0x80) == 0)
+                {
+                    break;
+                }
+
+                if (frameSize > _maxFrameSize)
+                {
+                    break;
+                }
+            }
+            break;
+    }
+
+    if (frameSize > _maxFrameSize)
+    {
+        errorMessage = "TCPFrameCodec error: Frame size is more than maximum frame size.";
+        return -1;
+    }
+
+    size_t frameBytes = headerBytes + frameSize;
+    if (buffer.size() < frameBytes)
+    {
+        return 0;
+    }
+
+    std::string_view data = buffer.readable();
+    if (data.size() < frameBytes)
+    {
+        // Frame wraps around the end of non mirrored storage.
+        data = buffer.linearize();
+    }
+
+    frame = data.substr(headerBytes, frameSize);
+
+    return (ssize_t)frameBytes;
+}
+
+ssize_t TCPFrameCodec::decode(TCPConnection* connection, std::string_view &frame)
+{
+    return decode(connection->_rxBuffer, frame);
+}
+
+bool TCPFrameCodec::encode(TCPRingBuffer &buffer, const struct iovec* frames, size_t count)
+{
+    size_t totalBytes = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (frames[i].iov_len > _maxFrameSize)
+        {
+            errorMessage = "TCPFrameCodec error: Frame size is more than maximum frame size.";
+            return false;
+        }
+        totalBytes += headerSize(frames[i].iov_len) + frames[i].iov_len;
+    }
+
+    if (!buffer.reserve(buffer.size() + totalBytes))
+    {
+        errorMessage = "TCPFrameCodec error: Error allocating buffer.";
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t header[TCPNetworkLinux_VARINT_MAX_SIZE];
+        buffer.push((const char*)header, _encodeHeader(frames[i].iov_len, header));
+        buffer.push((const char*)frames[i].iov_base, frames[i].iov_len);
+    }
+
+    return true;
+}
+
+bool TCPFrameCodec::encode(TCPRingBuffer &buffer, const char* data, size_t size)
+{
+    struct iovec frame = {(void*)data, size};
+
+    return encode(buffer, &frame, 1);
+}
+
+bool TCPFrameCodec::write(TCPConnection* connection, const struct iovec* frames, size_t count)
+{
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        totalBytes += headerSize(frames[i].iov_len) + frames[i].iov_len;
+    }
+
+    if (!connection->_admitTx(totalBytes))
+    {
+        errorMessage = "TCPFrameCodec error: TX buffer is full.";
+        return false;
+    }
+
+    if (!encode(connection->_txBuffer, frames, count))
+    {
+        return false;
+    }
+
+    // Encoded frames are real frame boundaries for TCPOverflowPolicy::DropOldestFrames.
+    if (connection->_overflowPolicy == TCPOverflowPolicy::DropOldestFrames)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            connection->_txFrames.push(headerSize(frames[i].iov_len) + frames[i].iov_len);
+        }
+        connection->_txFrames.sync(connection->_txBuffer.size());
+    }
+
+    return connection->write();
+}
+
+bool TCPFrameCodec::write(TCPConnection* connection, const char* data, size_t size)
+{
+    struct iovec frame = {(void*)data, size};
+
+    return write(connection, &frame, 1);
+}
+
+size_t TCPFrameCodec::_headerLimit(void)
+{
+    switch (_header)
+    {
+        case TCPFrameHeader::Fixed16BE:
+        case TCPFrameHeader::Fixed16LE:
+            return UINT16_MAX;
+        case TCPFrameHeader::Fixed32BE:
+        case TCPFrameHeader::Fixed32LE:
+            return UINT32_MAX;
+        default:
+            return SIZE_MAX;
+    }
+}
+
+size_t TCPFrameCodec::_encodeHeader(size_t frameSize, uint8_t* header)
+{
+    size_t size = headerSize(frameSize);
+
+    switch (_header)
+    {
+        case TCPFrameHeader::Fixed16BE:
+        case TCPFrameHeader::Fixed32BE:
+            for (size_t i = 0; i < size; i++)
+            {
+                header[size - 1 - i] = (uint8_t)(frameSize >> (8 * i));
+            }
+            break;
+        case TCPFrameHeader::Fixed16LE:
+        case TCPFrameHeader::Fixed32LE:
+            for (size_t i = 0; i < size; i++)
+            {
+                header[i] = (uint8_t)(frameSize >> (8 * i));
+            }
+            break;
+        default:
+            for (size_t i = 0; i < size; i++)
+            {
+                header[i] = (uint8_t)(frameSize & 0x7F) | ((i + 1 < size) ? 0x80 : 0);
+                frameSize >>= 7;
+            }
+            break;
+    }
+
+    return size;
+}
+
+// ######################################################################
+// TCPDelimiterFramer class:
+
+// Byte by byte delimiter scan. It is used on all CPUs and for tails of vector scans.
+static const char* TCPNetworkLinux_findScalar(const char* data, size_t size, char delimiter)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] == delimiter)
+        {
+            return data + i;
+        }
+    }
+
+    return nullptr;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Compare 16 bytes per step and locate first match by movemask.
+__attribute__((target("sse2")))
+static const char* TCPNetworkLinux_findSSE2(const char* data, size_t size, char delimiter)
+{
+    const __m128i pattern = _mm_set1_epi8(delimiter);
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern));
+
+        if (mask != 0)
+        {
+            return data + i + __builtin_ctz(mask);
+        }
+    }
+
+    if ((i < size) && (size >= 16))
+    {
+        // Tail by one overlapped load of last 16 bytes. Bytes before i have no match.
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + size - 16));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern));
+
+        return (mask != 0) ? data + size - 16 + __builtin_ctz(mask) : nullptr;
+    }
+
+    return TCPNetworkLinux_findScalar(data + i, size - i, delimiter);
+}
+
+// Compare 64 bytes per step in two 32 byte lanes. Matches of both lanes are tested by one branch.
+__attribute__((target("avx2")))
+static const char* TCPNetworkLinux_findAVX2(const char* data, size_t size, char delimiter)
+{
+    const __m256i pattern = _mm256_set1_epi8(delimiter);
+    size_t i = 0;
+
+    for (; i + 64 <= size; i += 64)
+    {
+        __m256i match0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)), pattern);
+        __m256i match1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i + 32)), pattern);
+
+        if (!_mm256_testz_si256(_mm256_or_si256(match0, match1), _mm256_or_si256(match0, match1)))
+        {
+            uint64_t mask = (uint32_t)_mm256_movemask_epi8(match0) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(match1) << 32);
+            return data + i + __builtin_ctzll(mask);
+        }
+    }
+
+    for (; i + 32 <= size; i += 32)
+    {
+        int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)), pattern));
+
+        if (mask != 0)
+        {
+            return data + i + __builtin_ctz(mask);
+        }
+    }
+
+    if ((i < size) && (size >= 32))
+    {
+        // Tail by one overlapped load of last 32 bytes. Bytes before i have no match.
+        int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + size - 32)), pattern));
+
+        return (mask != 0) ? data + size - 32 + __builtin_ctz(mask) : nullptr;
+    }
+
+    return TCPNetworkLinux_findSSE2(data + i, size - i, delimiter);
+}
+
+#endif
+
+// Return true if CPU supports certain scan implementation.
+static bool TCPNetworkLinux_scanSupported(TCPScanImplementation implementation)
+{
+    switch (implementation)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case TCPScanImplementation::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case TCPScanImplementation::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        case TCPScanImplementation::Scalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Return best scan implementation that CPU supports.
+static TCPScanImplementation TCPNetworkLinux_bestScan(void)
+{
+    if (TCPNetworkLinux_scanSupported(TCPScanImplementation::AVX2))
+    {
+        return TCPScanImplementation::AVX2;
+    }
+
+    if (TCPNetworkLinux_scanSupported(TCPScanImplementation::SSE2))
+    {
+        return TCPScanImplementation::SSE2;
+    }
+
+    return TCPScanImplementation::Scalar;
+}
+
+// Selected scan implementation of all TCPDelimiterFramer objects.
+static TCPScanImplementation TCPNetworkLinux_scanImplementation = TCPNetworkLinux_bestScan();
+
+TCPDelimiterFramer::TCPDelimiterFramer(char delimiter, size_t maxRecordSize)
+{
+    _delimiter = delimiter;
+    _maxRecordSize = maxRecordSize;
+}
+
+void TCPDelimiterFramer::setDelimiter(char delimiter)
+{
+    _delimiter = delimiter;
+}
+
+char TCPDelimiterFramer::getDelimiter(void)
+{
+    return _delimiter;
+}
+
+void TCPDelimiterFramer::setMaxRecordSize(size_t size)
+{
+    _maxRecordSize = size;
+}
+
+size_t TCPDelimiterFramer::getMaxRecordSize(void)
+{
+    return _maxRecordSize;
+}
+
+ssize_t TCPDelimiterFramer::decode(TCPRingBuffer &buffer, std::string_view &record)
+{
+    struct iovec segments[2];
+    buffer.readableSegments(segments);
+
+    // Delimiter must be within maximum record size plus one byte.
+    size_t limit = (_maxRecordSize == SIZE_MAX) ? SIZE_MAX : _maxRecordSize + 1;
+    size_t firstSize = std::min(segments[0].iov_len, limit);
+    size_t recordSize = 0;
+
+    const char* position = find((const char*)segments[0].iov_base, firstSize, _delimiter);
+
+    if (position != nullptr)
+    {
+        recordSize = position - (const char*)segments[0].iov_base;
+    }
+    else
+    {
+        size_t secondSize = std::min(segments[1].iov_len, limit - firstSize);
+        position = find((const char*)segments[1].iov_base, secondSize, _delimiter);
+
+        if (position == nullptr)
+        {
+            if (firstSize + secondSize == limit)
+            {
+                errorMessage = "TCPDelimiterFramer error: Record size is more than maximum record size.";
+                return -1;
+            }
+            return 0;
+        }
+
+        recordSize = segments[0].iov_len + (position - (const char*)segments[1].iov_base);
+    }
+
+    std::string_view data = buffer.readable();
+    if (data.size() < recordSize)
+    {
+        // Record wraps around the end of non mirrored storage.
+        data = buffer.linearize();
+    }
+
+    record = data.substr(0, recordSize);
+
+    return (ssize_t)(recordSize + 1);
+}
+
+ssize_t TCPDelimiterFramer::decode(TCPConnection* connection, std::string_view &record)
+{
+    return decode(connection->_rxBuffer, record);
+}
+
+const char* TCPDelimiterFramer::find(const char* data, size_t size, char delimiter)
+{
+    switch (TCPNetworkLinux_scanImplementation)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case TCPScanImplementation::AVX2:
+            return TCPNetworkLinux_findAVX2(data, size, delimiter);
+        case TCPScanImplementation::SSE2:
+            return TCPNetworkLinux_findSSE2(data, size, delimiter);
+#endif
+        default:
+            return TCPNetworkLinux_findScalar(data, size, delimiter);
+    }
+}
+
+bool TCPDelimiterFramer::setScanImplementation(TCPScanImplementation implementation)
+{
+    if (!TCPNetworkLinux_scanSupported(implementation))
+    {
+        return false;
+    }
+
+    TCPNetworkLinux_scanImplementation = implementation;
+
+    return true;
+}
+
+TCPScanImplementation TCPDelimiterFramer::getScanImplementation(void)
+{
+    return TCPNetworkLinux_scanImplementation;
+}
+
+// ######################################################################
+// TCPLinkMonitor class:
+
+TCPLinkMonitor::TCPLinkMonitor()
+{
+    _socket = -1;
+    _running = false;
+    _changeCount = 0;
+    _requestSequence = 0;
+    _dumpType = 0;
+    _resyncPending = false;
+
+    for (_Entry &entry : _entries)
+    {
+        entry.sequence = 0;
+        memset(&entry.state, 0, sizeof(entry.state));
+        entry.linkRefreshed = false;
+        entry.addressRefreshed = false;
+    }
+}
+
+TCPLinkMonitor::~TCPLinkMonitor()
+{
+    stop();
+}
+
+bool TCPLinkMonitor::start(Handler handler)
+{
+    if (_running)
+    {
+        errorMessage = "TCPLinkMonitor error: Monitor is already running.";
+        return false;
+    }
+
+    _socket = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (_socket == -1)
+    {
+        errorMessage = "TCPLinkMonitor error: Error creating netlink socket.";
+        return false;
+    }
+
+    struct sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR;
+
+    if (bind(_socket, (struct sockaddr*)&address, sizeof(address)) == -1)
+    {
+        errorMessage = "TCPLinkMonitor error: Error binding netlink socket.";
+        stop();
+        return false;
+    }
+
+    // Initial table is not reported to handler. Address dump is requested when link dump is done.
+    _handler = nullptr;
+
+    if (!_requestDump(RTM_GETLINK))
+    {
+        errorMessage = "TCPLinkMonitor error: Error requesting link dump.";
+        stop();
+        return false;
+    }
+
+    while (_dumpType != 0)
+    {
+        struct pollfd pollSocket = {_socket, POLLIN, 0};
+
+        if ( (poll(&pollSocket, 1, TCPNetworkLinux_LINK_MONITOR_TIMEOUT) <= 0) || !_receive(0) )
+        {
+            errorMessage = "TCPLinkMonitor error: Dump of links and addresses failed.";
+            stop();
+            return false;
+        }
+    }
+
+    _handler = handler;
+    _running = true;
+    _thread = std::thread(&TCPLinkMonitor::_run, this);
+
+    return true;
+}
+
+void TCPLinkMonitor::stop(void)
+{
+    _running = false;
+
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+
+    if (_socket != -1)
+    {
+        close(_socket);
+        _socket = -1;
+    }
+
+    _dumpType = 0;
+    _resyncPending = false;
+}
+
+bool TCPLinkMonitor::isRunning(void)
+{
+    return _running;
+}
+
+bool TCPLinkMonitor::getLinkState(const char* interfaceName, TCPLinkState &state)
+{
+    for (const _Entry &entry : _entries)
+    {
+        _readEntry(entry, state);
+
+        if ( (state.index != 0) && (strncmp(state.name, interfaceName, IFNAMSIZ) == 0) )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TCPLinkMonitor::isLinkUp(const char* interfaceName)
+{
+    TCPLinkState state;
+
+    return getLinkState(interfaceName, state) && state.up && state.carrier;
+}
+
+std::string TCPLinkMonitor::getIPAddress(const char* interfaceName)
+{
+    TCPLinkState state;
+
+    if (!getLinkState(interfaceName, state) || (state.address == 0))
+    {
+        return "";
+    }
+
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &state.address, ip, sizeof(ip));
+
+    return ip;
+}
+
+uint64_t TCPLinkMonitor::getChangeCount(void)
+{
+    return _changeCount.load(std::memory_order_relaxed);
+}
+
+void TCPLinkMonitor::_run(void)
+{
+    while (_running)
+    {
+        struct pollfd pollSocket = {_socket, POLLIN, 0};
+
+        // Timeout only bounds the delay of stop().
+        if (poll(&pollSocket, 1, TCPNetworkLinux_LINK_MONITOR_TIMEOUT) <= 0)
+        {
+            continue;
+        }
+
+        if (!_receive(MSG_DONTWAIT))
+        {
+            _running = false;
+        }
+    }
+}
+
+bool TCPLinkMonitor::_requestDump(int type)
+{
+    struct
+    {
+        struct nlmsghdr header;
+        struct rtgenmsg message;
+    } request;
+
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg));
+    request.header.nlmsg_type = type;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = ++_requestSequence;
+    request.message.rtgen_family = (type == RTM_GETADDR) ? AF_INET : AF_UNSPEC;
+
+    if (send(_socket, &request, request.header.nlmsg_len, 0) == -1)
+    {
+        return false;
+    }
+
+    for (_Entry &entry : _entries)
+    {
+        if (type == RTM_GETLINK)
+        {
+            entry.linkRefreshed = false;
+        }
+        else
+        {
+            entry.addressRefreshed = false;
+        }
+    }
+
+    _dumpType = type;
+
+    return true;
+}
+
+void TCPLinkMonitor::_sweepEntries(int type)
+{
+    for (_Entry &entry : _entries)
+    {
+        if (entry.state.index == 0)
+        {
+            continue;
+        }
+
+        TCPLinkState state = entry.state;
+
+        if ( (type == RTM_GETLINK) && !entry.linkRefreshed )
+        {
+            // Link was removed while its notification was lost.
+            state.index = 0;
+            state.up = false;
+            state.carrier = false;
+            state.address = 0;
+        }
+        else if ( (type == RTM_GETADDR) && !entry.addressRefreshed )
+        {
+            state.address = 0;
+        }
+
+        _writeEntry(entry, state);
+    }
+}
+
+bool TCPLinkMonitor::_receive(int flags)
+{
+    alignas(struct nlmsghdr) char buffer[16384];
+
+    ssize_t length = recv(_socket, buffer, sizeof(buffer), flags);
+
+    if (length == -1)
+    {
+        if ( (errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+        {
+            return true;
+        }
+
+        if (errno == ENOBUFS)
+        {
+            // Socket buffer overflowed and notifications were lost. Resynchronize table by new dump, after the dump in progress if any.
+            if (_dumpType != 0)
+            {
+                _resyncPending = true;
+                return true;
+            }
+            return _requestDump(RTM_GETLINK);
+        }
+
+        return false;
+    }
+
+    for (struct nlmsghdr* message = (struct nlmsghdr*)buffer; NLMSG_OK(message, length); message = NLMSG_NEXT(message, length))
+    {
+        switch (message->nlmsg_type)
+        {
+            case NLMSG_DONE:
+                if (_dumpType == 0)
+                {
+                    break;
+                }
+
+                _sweepEntries(_dumpType);
+
+                if (_dumpType == RTM_GETLINK)
+                {
+                    if (!_requestDump(RTM_GETADDR))
+                    {
+                        _dumpType = 0;
+                    }
+                }
+                else if (_resyncPending)
+                {
+                    _resyncPending = false;
+                    if (!_requestDump(RTM_GETLINK))
+                    {
+                        _dumpType = 0;
+                    }
+                }
+                else
+                {
+                    _dumpType = 0;
+                }
+                break;
+
+            case NLMSG_ERROR:
+                // Only dump requests are sent. Table stays as it is until next notification.
+                _dumpType = 0;
+                break;
+
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+                _handleLink(message);
+                break;
+
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+                _handleAddress(message);
+                break;
+        }
+    }
+
+    return true;
+}
+
+void TCPLinkMonitor::_handleLink(const struct nlmsghdr* message)
+{
+    const struct ifinfomsg* info = (const struct ifinfomsg*)NLMSG_DATA(message);
+
+    _Entry* entry = _findEntry(info->ifi_index, message->nlmsg_type == RTM_NEWLINK);
+    if (entry == nullptr)
+    {
+        return;
+    }
+
+    // Only monitor thread writes entries, so it reads its own entry directly.
+    TCPLinkState state = entry->state;
+
+    if (message->nlmsg_type == RTM_DELLINK)
+    {
+        state.index = 0;
+        state.up = false;
+        state.carrier = false;
+        state.address = 0;
+        _writeEntry(*entry, state);
+        return;
+    }
+
+    if (state.index != info->ifi_index)
+    {
+        memset(&state, 0, sizeof(state));
+        state.index = info->ifi_index;
+    }
+
+    entry->linkRefreshed = true;
+
+    state.up = (info->ifi_flags & IFF_UP) != 0;
+    state.carrier = (info->ifi_flags & IFF_RUNNING) != 0;
+
+    int attributeLength = IFLA_PAYLOAD(message);
+    for (const struct rtattr* attribute = IFLA_RTA(info); RTA_OK(attribute, attributeLength); attribute = RTA_NEXT(attribute, attributeLength))
+    {
+        if (attribute->rta_type == IFLA_IFNAME)
+        {
+            strncpy(state.name, (const char*)RTA_DATA(attribute), IFNAMSIZ - 1);
+            state.name[IFNAMSIZ - 1] = '\0';
+        }
+        else if (attribute->rta_type == IFLA_CARRIER)
+        {
+            state.carrier = *(const uint8_t*)RTA_DATA(attribute) != 0;
+        }
+    }
+
+    _writeEntry(*entry, state);
+}
+
+void TCPLinkMonitor::_handleAddress(const struct nlmsghdr* message)
+{
+    const struct ifaddrmsg* info = (const struct ifaddrmsg*)NLMSG_DATA(message);
+
+    if (info->ifa_family != AF_INET)
+    {
+        return;
+    }
+
+    _Entry* entry = _findEntry(info->ifa_index, false);
+    if (entry == nullptr)
+    {
+        return;
+    }
+
+    uint32_t address = 0;
+
+    int attributeLength = IFA_PAYLOAD(message);
+    for (const struct rtattr* attribute = IFA_RTA(info); RTA_OK(attribute, attributeLength); attribute = RTA_NEXT(attribute, attributeLength))
+    {
+        // IFA_LOCAL is the interface address. IFA_ADDRESS is the peer address on point to point links.
+        if ( (attribute->rta_type == IFA_LOCAL) || ((attribute->rta_type == IFA_ADDRESS) && (address == 0)) )
+        {
+            memcpy(&address, RTA_DATA(attribute), sizeof(address));
+        }
+    }
+
+    TCPLinkState state = entry->state;
+
+    if (message->nlmsg_type == RTM_NEWADDR)
+    {
+        // First address of an address dump replaces the old one, which may be removed meanwhile.
+        bool refreshed = (_dumpType != RTM_GETADDR) || entry->addressRefreshed;
+
+        if ( !refreshed || (state.address == 0) || !(info->ifa_flags & IFA_F_SECONDARY) )
+        {
+            state.address = address;
+        }
+        entry->addressRefreshed = true;
+    }
+    else if (state.address == address)
+    {
+        // Other addresses of interface may remain. Resynchronize addresses.
+        state.address = 0;
+        if (_dumpType == 0)
+        {
+            _requestDump(RTM_GETADDR);
+        }
+    }
+
+    _writeEntry(*entry, state);
+}
+
+TCPLinkMonitor::_Entry* TCPLinkMonitor::_findEntry(int index, bool create)
+{
+    _Entry* freeEntry = nullptr;
+
+    for (_Entry &entry : _entries)
+    {
+        if (entry.state.index == index)
+        {
+            return &entry;
+        }
+
+        if ( (entry.state.index == 0) && (freeEntry == nullptr) )
+        {
+            freeEntry = &entry;
+        }
+    }
+
+    return create ? freeEntry : nullptr;
+}
+
+void TCPLinkMonitor::_readEntry(const _Entry &entry, TCPLinkState &state)
+{
+    uint32_t sequence;
+
+    do
+    {
+        sequence = entry.sequence.load(std::memory_order_acquire);
+        state = entry.state;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ( (sequence & 1) || (sequence != entry.sequence.load(std::memory_order_relaxed)) );
+}
+
+void TCPLinkMonitor::_writeEntry(_Entry &entry, const TCPLinkState &state)
+{
+    const TCPLinkState &oldState = entry.state;
+
+    if ( (oldState.index == state.index) && (oldState.up == state.up) && (oldState.carrier == state.carrier) && 
+         (oldState.address == state.address) && (strncmp(oldState.name, state.name, IFNAMSIZ) == 0) )
+    {
+        return;
+    }
+
+    uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.state = state;
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+
+    _changeCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (_handler)
+    {
+        _handler(state);
+    }
+}
+
+// ######################################################################
+// TCPNotifier class:
+
+TCPNotifier::TCPNotifier()
+{
+    _fileDescriptor = -1;
+}
+
+TCPNotifier::~TCPNotifier()
+{
+    close();
+}
+
+bool TCPNotifier::open(void)
+{
+    if (_fileDescriptor != -1)
+    {
+        return true;
+    }
+
+    _fileDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_fileDescriptor == -1)
+    {
+        errorMessage = "TCPNotifier error: Error creating eventfd.";
+        return false;
+    }
+
+    return true;
+}
+
+void TCPNotifier::close(void)
+{
+    if (_fileDescriptor != -1)
+    {
+        ::close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+}
+
+int TCPNotifier::getFileDescriptor(void)
+{
+    return _fileDescriptor;
+}
+
+void TCPNotifier::notify(void)
+{
+    // It fails only if the counter is full, and then the owner is notified already.
+    uint64_t value = 1;
+    ssize_t bytesWrite = ::write(_fileDescriptor, &value, sizeof(value));
+    (void)bytesWrite;
+}
+
+uint64_t TCPNotifier::clear(void)
+{
+    uint64_t value = 0;
+    if (::read(_fileDescriptor, &value, sizeof(value)) != sizeof(value))
+    {
+        return 0;
+    }
+
+    return value;
+}
+
+bool TCPNotifier::wait(int timeoutMs)
+{
+    struct pollfd pollSocket = {_fileDescriptor, POLLIN, 0};
+
+    if (poll(&pollSocket, 1, timeoutMs) <= 0)
+    {
+        return false;
+    }
+
+    return (clear() > 0);
+}
+
+// ######################################################################
+// TCPServer class:
+
+TCPServer::TCPServer()
+{
+    _rxBufferSize = TCPNetworkLinux_DEFAULT_RX_SIZE;
+    _txBufferSize = TCPNetworkLinux_DEFAULT_TX_SIZE;
+    _rxBuffer.reserve(_rxBufferSize);
+    _txBuffer.reserve(_txBufferSize);
+    _serverSocket = -1;
+    _clientSocket = -1;
+    _epollSocket = -1;
+    _notifier = nullptr;
+    _uring = nullptr;
+    _uringAcceptRearm = false;
+    _uringNotifierRearm = false;
+    _maxConnections = 0;
+    _connectionCount = 0;
+    _idleTimeout = 0;
+    _writeTimeout = 0;
+    _heartbeatInterval = 0;
+    _acceptedDispatched = 0;
+    _closedDispatched = 0;
+    _linkMonitor = nullptr;
+    _statsDumpInterval = std::chrono::milliseconds(0);
+    _statsDumpPerConnection = false;
+    _overflowPolicy = TCPOverflowPolicy::DropOldest;
+    _txLowWatermark = 0;
+    _rxLowWatermark = 0;
+    _rxPaused = false;
+}
+
+TCPServer::~TCPServer()
+{
+    _handleServerDisconnection();
+    _deleteClosedConnections();
+}
+
+bool TCPServer::startByIP(const uint16_t port, const char* ip)
+{
+    _port = port;
+    _ip = ip;
+    _unixPath.clear();
+
+    // Define the server address structure
+    struct sockaddr_in serverAddress;
+    serverAddress.sin_family = AF_INET;     // This ensures that the socket will use the Internet Protocol (IPv4)
+    serverAddress.sin_port = htons(port);   // Change port here
+
+    // specify a particular IP address rather than binding to any available network interface.
+    // Convert IP address from text to binary form
+    if (inet_pton(AF_INET, ip, &serverAddress.sin_addr) <= 0) 
+    {
+        errorMessage = "TCPServer error: Invalid IP address/ Address not supported";
+        return false;
+    }
+
+    // Zero out the rest of the struct
+    memset(&(serverAddress.sin_zero), 0, sizeof(serverAddress.sin_zero));
+
+    return _startListening((struct sockaddr*)&serverAddress, sizeof(serverAddress));
+}
+
+bool TCPServer::startByPath(const char* path)
+{
+    _port = 0;
+    _ip = path;
+    _unixPath.clear();
+
+    struct sockaddr_un serverAddress;
+    socklen_t addressLength = TCPNetworkLinuxNamespace::makeUnixAddress(path, serverAddress);
+    if (addressLength == 0)
+    {
+        errorMessage = "TCPServer error: Invalid unix socket path.";
+        return false;
+    }
+
+    // Socket file of a previous run makes bind fail. Remove it only if it is a socket.
+    struct stat fileStatus;
+    if ( (path[0] != '@') && (lstat(path, &fileStatus) == 0) && S_ISSOCK(fileStatus.st_mode) )
+    {
+        unlink(path);
+    }
+
+    if (!_startListening((struct sockaddr*)&serverAddress, addressLength))
+    {
+        return false;
+    }
+
+    _unixPath = path;
+
+    return true;
+}
+
+bool TCPServer::_startListening(const struct sockaddr* address, socklen_t addressLength)
+{
+    bool tcp = (address->sa_family == AF_INET);
+
+    // Server configuration. socket() Returns a file descriptor for the new socket, or -1 for errors.
+    _serverSocket = socket(address->sa_family, SOCK_STREAM, 0);
+    if (_serverSocket == -1) 
+    {
+        errorMessage = "TCPServer error: Error creating server socket: ";
+        return false;
+    }
+
+    // Set SO_REUSEADDR and SO_REUSEPORT options. Option names are not bit flags, so they are set separately.
+    int opt = 1;
+    if ( tcp && ((setsockopt(_serverSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) ||
+                 (setsockopt(_serverSocket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1)) )
+    {
+        errorMessage = "TCPServer error: Error setting socket options.";
+        _handleServerDisconnection();
+        return false;
+    }
+
+    // Buffer sizes are set before listen, so window scaling of accepted sockets uses them. Failures are not fatal.
+    std::string failedOptions;
+    if (!TCPNetworkLinuxNamespace::applySocketOptions(_serverSocket, _socketOptions, failedOptions, tcp))
+    {
+        errorMessage = "TCPServer error: Error setting socket options: " + failedOptions;
+    }
+
+    // Set the server socket to non-blocking mode
+    int flags = fcntl(_serverSocket, F_GETFL, 0);
+    if (flags == -1) 
+    {
+        errorMessage = "TCPServer error: Error getting socket flags for setting socket to non-blockings.";
+        _handleServerDisconnection();
+        return false;
+    }
+
+    if (fcntl(_serverSocket, F_SETFL, flags | O_NONBLOCK) == -1) 
+    {
+        errorMessage = "TCPServer error: Error setting socket to non-blocking.";
+        _handleServerDisconnection();
+        return false;
+    }
+
+    // Bind the socket to the network address and port
+    if (bind(_serverSocket, address, addressLength) == -1) 
+    {
+        errorMessage = "TCPServer error: Bind failed.";
+        _handleServerDisconnection();
+        return false;
+    }
+
+    /*
+    listenBacklog defines the maximum length of the queue of pending connections. 
+    When a client attempts to connect to the server, if the server is not ready to accept the connection immediately, 
+    the connection request will be placed in a queue. listenBacklog specifies the maximum number of connections that 
+    can be queued at any one time.
+    */
+    int backlog = (_socketOptions.listenBacklog == -1) ? TCPNetworkLinux_DEFAULT_LISTEN_BACKLOG : _socketOptions.listenBacklog;
+    // Listen for incoming connections
+    if (listen(_serverSocket, backlog) == -1) {
+        errorMessage = "TCPServer error: Listen failed.";
+        _handleServerDisconnection();
+        return false;
+    }
+
+    return true;
+}
+
+bool TCPServer::startByName(const uint16_t port, const char* InterfaceName)
+{
+    if ( (_linkMonitor != nullptr) && _linkMonitor->isRunning() )
+    {
+        _ip = _linkMonitor->getIPAddress(InterfaceName);
+    }
+    else
+    {
+        _ip = TCPNetworkLinuxNamespace::getIPAddressByInterface(InterfaceName);
+    }
+
+    if(_ip == "")
+    {
+        errorMessage = "TCPServer error: Invalid interface ethernet name.";
+        return false;
+    }
+
+    return startByIP(port, _ip.c_str());
+}
+
+bool TCPServer::_clientConfig(void)
+{
+    // Accept incoming connection
+    struct sockaddr_in clientAddress;
+    socklen_t clientAddressLength = sizeof(clientAddress);
+    memset(&clientAddress, 0, sizeof(clientAddress));
+    
+    _clientSocket = accept(_serverSocket, (struct sockaddr*)&clientAddress, &clientAddressLength);
+    if (_clientSocket == -1) 
+    {
+        if (errno == EWOULDBLOCK || errno == EAGAIN) 
+        {
+            // No pending connections; this is expected in non-blocking mode
+        } 
+        else 
+        {
+            errorMessage = "TCPServer error: Accept client failed";
+        }
+        return false;
+    }
+
+    std::string failedOptions;
+    if (!TCPNetworkLinuxNamespace::applySocketOptions(_clientSocket, _socketOptions, failedOptions, _unixPath.empty()))
+    {
+        errorMessage = "TCPServer error: Error setting socket options: " + failedOptions;
+    }
+
+    _stats.add(TCPStatsCounter::Accepts);
+
+    return true;
+}
+
+void TCPServer::_handleClientDisconnection(void) 
+{
+    if (_clientSocket != -1)
+    {
+        close(_clientSocket);
+        _stats.add(TCPStatsCounter::Disconnects);
+    }
+    _clientSocket = -1;
+
+    for (int fileDescriptor : _rxFileDescriptors)
+    {
+        close(fileDescriptor);
+    }
+    _rxFileDescriptors.clear();
+}
+
+void TCPServer::_handleServerDisconnection(void) 
+{
+    stopEventLoop();
+    _handleClientDisconnection();
+    close(_serverSocket);  
+    _serverSocket = -1;
+
+    // Remove socket file of unix domain server. Abstract names disappear with the socket.
+    if (!_unixPath.empty() && (_unixPath[0] != '@'))
+    {
+        unlink(_unixPath.c_str());
+    }
+    _unixPath.clear();
+}
+
+bool TCPServer::readWrite(char *txBuffer, size_t txSize, char *rxBuffer, size_t rxSize)
+{
+    int bytesRead = read(rxBuffer, rxSize);
+    if( bytesRead == -1)
+    {
+        return false;
+    }
+
+    if(!write(*txBuffer, txSize))
+    {
+        return false;
+    }
+
+    return true;     
+}
+
+int32_t TCPServer::read(char *rxBuffer, const size_t &rxSize)
+{
+    if(rxSize == 0)
+    {
+        errorMessage = "TCPServer error: rxSize is zero value.";
+        #if(TCPNetworkLinux_DEBUG == 1)
+                    std::cout << errorMessage << std::endl;
+        #endif
+        return -1;
+    }
+        
+    // Number of bytes read from the socket.
+    int32_t bytesRead = 0; 
+       
+    if (_unixPath.empty())
+    {
+        bytesRead = recv(_clientSocket, rxBuffer, rxSize, 0);
+    }
+    else
+    {
+        struct iovec segment = {rxBuffer, rxSize};
+        bytesRead = TCPNetworkLinuxNamespace::receiveFileDescriptors(_clientSocket, &segment, 1, _rxFileDescriptors);
+    }
+    
+    if (bytesRead <= 0)
+    {
+        if (bytesRead == 0) 
+        {
+            // Client disconnected
+            errorMessage = "TCPServer error: Client disconnected.";
+            _handleClientDisconnection();
+            return 0;
+        } 
+        else if (bytesRead == -1) 
+        {
+            if (errno != EWOULDBLOCK && errno != EAGAIN) 
+            {
+                errorMessage = "TCPServer error: Error receiving message.";
+                _handleClientDisconnection();
+                #if(TCPNetworkLinux_DEBUG == 1)
+                    std::cout << errorMessage << std::endl;
+                #endif
+                return -1;
+            } 
+            return -1;
+        }
+    }
+
+    if (bytesRead > (int64_t)rxSize)
+    {
+        // Receive proccess was not successed.
+        errorMessage = "TCPServer error: Error receiving message. bytesRead is more than rxSize";
+        #if(TCPNetworkLinux_DEBUG == 1)
+                std::cout << errorMessage << std::endl;
+        #endif
+        return 0;
+    }
+        
+    return bytesRead;     
+}
+
+int32_t TCPServer::read(std::string *data)
+{
+    int32_t bytesRead = available();
+
+    if(bytesRead <= 0)
+    {
+        return bytesRead;
+    }
+    
+    char buffer[bytesRead];
+
+    if((size_t)bytesRead > _rxBufferSize)
+    {
+        bytesRead = _rxBufferSize;
+    }
+    bytesRead = read(buffer, bytesRead);
+
+    if(bytesRead > 0)
+    {
+        data->assign(buffer, bytesRead);
+    }
+    
+    return bytesRead;
+}
+
+int32_t TCPServer::read(void)
+{
+    if (_clientSocket == -1)
+    {
+        return 0;
+    }
+
+    // Receive directly into RX ring buffer. No FIONREAD call and no intermediate buffer.
+    size_t droppedBytes = 0;
+    ssize_t bytesRead;
+
+    if (_overflowPolicy == TCPOverflowPolicy::Backpressure)
+    {
+        // Paused reading starts again when RX buffer is consumed down to low watermark.
+        size_t rxLowWatermark = (_rxLowWatermark > 0) ? _rxLowWatermark : _rxBufferSize / 2;
+        if (_rxPaused && (_rxBuffer.size() > rxLowWatermark))
+        {
+            return 0;
+        }
+        _rxPaused = false;
+
+        // Read only into free space. Unread data stays in socket and TCP flow control slows down the client.
+        if (_rxBuffer.size() >= _rxBufferSize)
+        {
+            _rxPaused = true;
+            _stats.add(TCPStatsCounter::RxPauses, 1);
+            return 0;
+        }
+        bytesRead = _rxBuffer.recvAppend(_clientSocket, _rxBufferSize - _rxBuffer.size(), _unixPath.empty() ? nullptr : &_rxFileDescriptors);
+    }
+    else
+    {
+        bytesRead = _rxBuffer.recvFrom(_clientSocket, _rxBufferSize, &droppedBytes, _unixPath.empty() ? nullptr : &_rxFileDescriptors);
+    }
+    _stats.countRx((bytesRead == -1) ? -errno : bytesRead, droppedBytes, _rxBuffer.size());
+
+    if (bytesRead == 0)
+    {
+        errorMessage = "TCPServer error: Client disconnected.";
+        _handleClientDisconnection();
+        return -1;
+    }
+
+    if (bytesRead == -1)
+    {
+        if (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR)
+        {
+            return 0;
+        }
+
+        errorMessage = "TCPServer error: Error receiving message.";
+        _handleClientDisconnection();
+        #if(TCPNetworkLinux_DEBUG == 1)
+            std::cout << errorMessage << std::endl;
+        #endif
+        return -1;
+    }
+    
+    return bytesRead;
+}
+
+bool TCPServer::write(const char &txBuffer, const size_t &txSize)
+{
+    // Number of bytes write to the socket.
+    int bytesWrite; 
+
+    if (_clientSocket == -1)  // No client connected
+    { 
+        if (_clientConfig()) 
+        {
+            // Set the client socket to non-blocking mode
+            int clientFlags = fcntl(_clientSocket, F_GETFL, 0);
+            if (clientFlags == -1) 
+            {
+                errorMessage = "TCPServer error: Error getting client socket flags.";
+                _handleClientDisconnection();
+                return false;
+            }
+
+            if (fcntl(_clientSocket, F_SETFL, clientFlags | O_NONBLOCK) == -1) 
+            {
+                errorMessage = "TCPServer error: Error setting client socket to non-blocking.";
+                _handleClientDisconnection();
+                return false;
+            }
+        }
+    }
+    else   // Client is connected
+    { 
+        if (!_admitTx(txSize))
+        {
+            return false;
+        }
+
+        // No poll before send: a full socket returns EAGAIN and disconnection is reported by send errors.
+        if (!_txBuffer.empty()) 
+        {
+            // Keep byte order: new data goes behind data that is already queued.
+            if (!_txBuffer.append(&txBuffer, txSize))
+            {
+                errorMessage = "TCPServer error: Memory budget is exceeded.";
+                return false;
+            }
+            _recordTxFrame(txSize);
+            return _flushTxBuffer();
+        }
+
+        bytesWrite = send(_clientSocket, &txBuffer, txSize, MSG_NOSIGNAL);
+        _stats.countTx((bytesWrite == -1) ? -errno : bytesWrite, txSize, 0);
+
+        if (bytesWrite == -1) 
+        {
+            if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
+                errorMessage = "TCPServer error: Error sending message.";
+                _handleClientDisconnection();
+                return false;
+            }
+            bytesWrite = 0;
+        } 
+
+        if (bytesWrite < (int)txSize) 
+        {
+            // Partial write. Queue the unsent tail, it is sent by next write() calls.
+            if (!_txBuffer.append(&txBuffer + bytesWrite, txSize - bytesWrite))
+            {
+                errorMessage = "TCPServer error: Memory budget is exceeded.";
+                _handleClientDisconnection();
+                return false;
+            }
+            _recordTxFrame(txSize);
+        }
+    } 
+
+    return true;     
+}
+
+bool TCPServer::write(const std::string &txBuffer)
+{
+    const char *data = txBuffer.c_str();
+
+    return write(*data, txBuffer.size());
+}
+
+bool TCPServer::write(void)
+{
+    if((_clientSocket == -1) || _txBuffer.empty())
+    {
+        return write(std::string());
+    }
+
+    return _flushTxBuffer();
+}
+
+bool TCPServer::_flushTxBuffer(void)
+{
+    while (!_txBuffer.empty())
+    {
+        // Send both ring segments by one syscall. Only sent bytes are removed from the queue.
+        size_t queuedBytes = _txBuffer.size();
+        ssize_t bytesWrite = _txBuffer.sendTo(_clientSocket);
+        _stats.countTx((bytesWrite == -1) ? -errno : bytesWrite, queuedBytes, queuedBytes);
+
+        if (bytesWrite == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (errno == EWOULDBLOCK || errno == EAGAIN)
+            {
+                return true;
+            }
+
+            errorMessage = "TCPServer error: Error sending message.";
+            _handleClientDisconnection();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TCPServer::write(const struct iovec* buffers, size_t count)
+{
+    if (_clientSocket == -1)
+    {
+        return write(std::string());
+    }
+
+    size_t queuedBytes = _txBuffer.size();
+    size_t offeredBytes = queuedBytes;
+    for (size_t i = 0; i < count; i++)
+    {
+        offeredBytes += buffers[i].iov_len;
+    }
+
+    if (!_admitTx(offeredBytes - queuedBytes))
+    {
+        return false;
+    }
+
+    ssize_t bytesWrite = _txBuffer.sendTo(_clientSocket, buffers, count);
+    _stats.countTx((bytesWrite == -1) ? -errno : bytesWrite, offeredBytes, queuedBytes);
+
+    if (bytesWrite == -1)
+    {
+        errorMessage = (errno == ENOMEM) ? "TCPServer error: Memory budget is exceeded." : "TCPServer error: Error sending message.";
+        _handleClientDisconnection();
+        return false;
+    }
+
+    _recordTxFrame(offeredBytes - queuedBytes);
+
+    return true;
+}
+
+bool TCPServer::sendFileDescriptors(const int* fileDescriptors, size_t count, const char* data, size_t size)
+{
+    if ( (_clientSocket == -1) || _unixPath.empty() )
+    {
+        errorMessage = "TCPServer error: Descriptors can be sent only to a connected unix domain client.";
+        return false;
+    }
+
+    if (!_flushTxBuffer())
+    {
+        return false;
+    }
+
+    // Descriptors can not be queued in TX buffer, so they are sent only behind fully sent data.
+    if (!_txBuffer.empty())
+    {
+        errorMessage = "TCPServer error: TX buffer is not empty. Descriptors are not sent.";
+        return false;
+    }
+
+    ssize_t bytesWrite = TCPNetworkLinuxNamespace::sendFileDescriptors(_clientSocket, data, size, fileDescriptors, count);
+    _stats.countTx((bytesWrite == -1) ? -errno : bytesWrite, size, 0);
+
+    if (bytesWrite == -1)
+    {
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+        {
+            errorMessage = "TCPServer error: Socket is full. Descriptors are not sent.";
+            return false;
+        }
+
+        errorMessage = "TCPServer error: Error sending descriptors.";
+        if (errno != EINVAL)
+        {
+            _handleClientDisconnection();
+        }
+        return false;
+    }
+
+    if ((size_t)bytesWrite < size)
+    {
+        if (!_txBuffer.append(data + bytesWrite, size - bytesWrite))
+        {
+            errorMessage = "TCPServer error: Memory budget is exceeded.";
+            _handleClientDisconnection();
+            return false;
+        }
+        _recordTxFrame(size);
+    }
+
+    return true;
+}
+
+int TCPServer::popFileDescriptor(void)
+{
+    if (_rxFileDescriptors.empty())
+    {
+        return -1;
+    }
+
+    int fileDescriptor = _rxFileDescriptors.front();
+    _rxFileDescriptors.erase(_rxFileDescriptors.begin());
+
+    return fileDescriptor;
+}
+
+size_t TCPServer::getTxQueuedBytes(void)
+{
+    return _txBuffer.size();
+}
+
+void TCPServer::printError(void)
+{
+    printf("%s\n",errorMessage.c_str());
+}
+
+std::string TCPServer::getError(void)
+{
+    return errorMessage;
+}
+
+bool TCPServer::isListening(void)
+{
+    if(_serverSocket == -1)
+        return false;
+
+    return true;
+}
+
+bool TCPServer::isClientConnected(void)
+{
+    // Socket is closed by read, write and wait functions as soon as they observe disconnection.
+    return _clientSocket != -1;
+}
+
+bool TCPServer::checkLinkStatus(const char* port_name)
+{
+    if ( (_linkMonitor != nullptr) && _linkMonitor->isRunning() )
+    {
+        return _linkMonitor->isLinkUp(port_name);
+    }
+
+    std::string carrierPath = std::string("/sys/class/net/") + port_name + "/carrier";
+    std::ifstream carrierFile(carrierPath);
+    if (!carrierFile.is_open()) {
+        errorMessage = "Error opening carrier file for interface: eno1";
+        return false;
+    }
+
+    int status;
+    carrierFile >> status;
+    carrierFile.close();
+    
+    if (status == 1) {
+        return true; // Link is up
+    } else {
+        return false; // Link is down
+    }
+}
+
+void TCPServer::serverClose(void)
+{
+    _handleServerDisconnection();
+}
+
+void TCPServer::clientClose(void)
+{
+    _handleClientDisconnection();
+}
+
+bool TCPServer::clientConnect(void)
+{
+    if (!isClientConnected())  
+    { 
+        if (_clientConfig()) 
+        {
+            // Set the client socket to non-blocking mode
+            int clientFlags = fcntl(_clientSocket, F_GETFL, 0);
+            if (clientFlags == -1) 
+            {
+                errorMessage = "TCPServer error: Error getting client socket flags.";
+                _handleClientDisconnection();
+                return false;
+            }
+
+            if (fcntl(_clientSocket, F_SETFL, clientFlags | O_NONBLOCK) == -1) 
+            {
+                errorMessage = "TCPServer error: Error setting client socket to non-blocking.";
+                _handleClientDisconnection();
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int32_t TCPServer::waitReadable(int timeoutMs)
+{
+    return _wait(TCPNetworkLinux_WAIT_READABLE | TCPNetworkLinux_WAIT_ACCEPT, timeoutMs);
+}
+
+int32_t TCPServer::waitWritable(int timeoutMs)
+{
+    return _wait(TCPNetworkLinux_WAIT_WRITABLE, timeoutMs);
+}
+
+int32_t TCPServer::waitAny(int timeoutMs)
+{
+    return _wait(TCPNetworkLinux_WAIT_ANY, timeoutMs);
+}
+
+int32_t TCPServer::_wait(uint32_t events, int timeoutMs)
+{
+    struct pollfd pollSockets[2];
+
+    int count = _pollPrepare(events, pollSockets, timeoutMs);
+    if (count == -1)
+    {
+        return -1;
+    }
+
+    if (count == 0)
+    {
+        errorMessage = "TCPServer error: No socket to wait for.";
+        return -1;
+    }
+
+    int result = poll(pollSockets, count, timeoutMs);
+    if (result == -1)
+    {
+        if (errno == EINTR)
+        {
+            return 0;
+        }
+        errorMessage = "TCPServer error: poll failed.";
+        return -1;
+    }
+
+    // On timeout no entry is ready, but io_uring event loop may still have work.
+    return _pollComplete(events, pollSockets, count);
+}
+
+int TCPServer::_pollPrepare(uint32_t events, struct pollfd* pollSockets, int &timeoutMs)
+{
+    int count = 0;
+
+    if (_uring != nullptr)
+    {
+        // io_uring descriptor is readable while completion queue has entries.
+        if (events & (TCPNetworkLinux_WAIT_READABLE | TCPNetworkLinux_WAIT_ACCEPT))
+        {
+            // Requests that completions handler queued must reach kernel, else their completions never arrive.
+            if (_uring->enter(0, 0) == -1)
+            {
+                errorMessage = "TCPServer error: io_uring_enter failed.";
+                return -1;
+            }
+
+            pollSockets[count++] = {_uring->ringSocket, POLLIN, 0};
+
+            // Work that runEventLoop() does without a completion must not wait for one.
+            if (_hasIoUringWork())
+            {
+                timeoutMs = 0;
+            }
+        }
+        return count;
+    }
+
+    if (_epollSocket != -1)
+    {
+        // epoll descriptor is readable while event loop has events to handle.
+        if (events & (TCPNetworkLinux_WAIT_READABLE | TCPNetworkLinux_WAIT_ACCEPT))
+        {
+            pollSockets[count++] = {_epollSocket, POLLIN, 0};
+        }
+        return count;
+    }
+
+    if (_clientSocket != -1)
+    {
+        short pollEvents = 0;
+
+        if (events & TCPNetworkLinux_WAIT_READABLE)
+        {
+            pollEvents |= POLLIN | POLLRDHUP;
+        }
+
+        if ( (events & TCPNetworkLinux_WAIT_WRITABLE) || ((events & TCPNetworkLinux_WAIT_PENDING_TX) && !_txBuffer.empty()) )
+        {
+            pollEvents |= POLLOUT;
+        }
+
+        if (pollEvents != 0)
+        {
+            pollSockets[count++] = {_clientSocket, pollEvents, 0};
+        }
+    }
+    else if ( (_serverSocket != -1) && (events & TCPNetworkLinux_WAIT_ACCEPT) )
+    {
+        // Single client mode accepts only when no client is connected.
+        pollSockets[count++] = {_serverSocket, POLLIN, 0};
+    }
+
+    return count;
+}
+
+uint32_t TCPServer::_pollComplete(uint32_t events, const struct pollfd* pollSockets, int count)
+{
+    (void)events;
+
+    uint32_t readyEvents = 0;
+
+    if ( (_uring != nullptr) && (count > 0) && _hasIoUringWork() )
+    {
+        readyEvents |= TCPNetworkLinux_WAIT_READABLE;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        short revents = pollSockets[i].revents;
+
+        if (revents == 0)
+        {
+            continue;
+        }
+
+        if ( (pollSockets[i].fd == _epollSocket) || ((_uring != nullptr) && (pollSockets[i].fd == _uring->ringSocket)) )
+        {
+            readyEvents |= TCPNetworkLinux_WAIT_READABLE;
+        }
+        else if (pollSockets[i].fd == _serverSocket)
+        {
+            readyEvents |= TCPNetworkLinux_WAIT_ACCEPT;
+        }
+        else
+        {
+            // Errors and hang up are reported as requested events, so next read() or write() observes them.
+            if (revents & (POLLERR | POLLHUP | POLLNVAL))
+            {
+                revents |= pollSockets[i].events;
+            }
+
+            if (revents & (POLLIN | POLLRDHUP))
+            {
+                readyEvents |= TCPNetworkLinux_WAIT_READABLE;
+            }
+
+            if (revents & POLLOUT)
+            {
+                readyEvents |= TCPNetworkLinux_WAIT_WRITABLE;
+            }
+        }
+    }
+
+    return readyEvents;
+}
+
+void TCPServer::setLinkMonitor(TCPLinkMonitor* monitor)
+{
+    _linkMonitor = monitor;
+}
+
+std::string TCPServer::getVersion(void)
+{
+    return TCPNetworkLinux_version;
+}
+
+void TCPServer::setTxBufferSize(size_t size)
+{
+    _txBufferSize = size;
+    if (_txBuffer.size() > size)
+    {
+        // Backpressure only lowers the limit. _admitTx() refuses new data until the queue is sent.
+        if (_overflowPolicy == TCPOverflowPolicy::DropOldestFrames)
+        {
+            _txFrames.sync(_txBuffer.size());
+            _stats.add(TCPStatsCounter::TxDroppedBytes, _txFrames.dropOldest(_txBuffer, _txBuffer.size() - size));
+        }
+        else if (_overflowPolicy == TCPOverflowPolicy::DropOldest)
+        {
+            _stats.add(TCPStatsCounter::TxDroppedBytes, _txBuffer.size() - size);
+            _txBuffer.discard(_txBuffer.size() - size);
+        }
+    }
+    _txBuffer.reserve(size);
+}
+
+void TCPServer::setRxBufferSize(size_t size)
+{
+    _rxBufferSize = size;
+
+    // Unread input is kept unless the policy drops bytes. Backpressure keeps reading paused until it is consumed.
+    if ( (_overflowPolicy == TCPOverflowPolicy::DropOldest) && (_rxBuffer.size() > size) )
+    {
+        _stats.add(TCPStatsCounter::RxDroppedBytes, _rxBuffer.size() - size);
+        _rxBuffer.discard(_rxBuffer.size() - size);
+    }
+    _rxBuffer.reserve(size);
+}
+
+int32_t TCPServer::available(void)
+{
+    // Use ioctl to find out how many bytes are available in the receive buffer
+    int32_t bytesAvailable = 0;
+    
+    if( (_serverSocket > 0 ) && (_clientSocket > 0))
+    {   
+        if (ioctl(_clientSocket, FIONREAD, &bytesAvailable) < 0) 
+        {
+            errorMessage = "ioctl failed";
+            #if(TCPNetworkLinux_DEBUG == 1)
+                std::cout << errorMessage << std::endl;
+            #endif
+            return -1;
+        }
+    }
+
+    return bytesAvailable;
+}
+
+void TCPServer::removeFrontRxBuffer(size_t num)
+{
+    _rxBuffer.discard(num);
+}
+
+void TCPServer::removeFrontTxBuffer(size_t size)
+{
+    _txBuffer.discard(size);
+}
+
+void TCPServer::removeAllRxBuffer(void)
+{
+    _rxBuffer.clear();
+}
+
+void TCPServer::removeAllTxBuffer(void)
+{
+    _txBuffer.clear();
+}
+
+std::string TCPServer::popFrontRxBuffer(size_t size)
+{
+    std::string data(std::min(size, _rxBuffer.size()), '\0');
+    _rxBuffer.pop(&data[0], data.size());
+
+    return data;
+}
+
+std::string TCPServer::popAllRxBuffer(void)
+{
+    return popFrontRxBuffer(_rxBuffer.size());
+}
+
+std::string_view TCPServer::peekRxBuffer(void)
+{
+    return _rxBuffer.linearize();
+}
+
+int TCPServer::peekRxBuffer(struct iovec segments[2])
+{
+    return _rxBuffer.readableSegments(segments);
+}
+
+void TCPServer::consumeRxBuffer(size_t size)
+{
+    _rxBuffer.discard(size);
+}
+
+bool TCPServer::pushBackRxBuffer(const char* data, size_t size)
+{
+    if (_overflowPolicy == TCPOverflowPolicy::Backpressure)
+    {
+        if ( !_rxBuffer.empty() && (_rxBuffer.size() + size > _rxBufferSize) )
+        {
+            errorMessage = "TCPServer error: RX buffer is full.";
+            return false;
+        }
+        if (!_rxBuffer.append(data, size))
+        {
+            errorMessage = "TCPServer error: Memory budget is exceeded.";
+            return false;
+        }
+    }
+    else
+    {
+        // Keep only the newest _rxBufferSize bytes. RX data has no recorded frames, so whole frames can not be dropped.
+        _stats.add(TCPStatsCounter::RxDroppedBytes, _rxBuffer.pushDropOldest(data, size, _rxBufferSize));
+    }
+    _stats.max(TCPStatsCounter::RxHighWater, _rxBuffer.size());
+
+    return true;
+}
+
+bool TCPServer::pushBackRxBuffer(const std::string* data)
+{
+    return pushBackRxBuffer(data->c_str(), data->size());
+}
+
+bool TCPServer::pushBackTxBuffer(const char* data, size_t size)
+{
+    if (!_admitTx(size))
+    {
+        return false;
+    }
+
+    if (_overflowPolicy == TCPOverflowPolicy::DropOldestFrames)
+    {
+        // Drop whole queued frames, so the client never receives a cut frame.
+        _txFrames.sync(_txBuffer.size());
+        if (_txBuffer.size() + size > _txBufferSize)
+        {
+            _stats.add(TCPStatsCounter::TxDroppedBytes, _txFrames.dropOldest(_txBuffer, _txBuffer.size() + size - _txBufferSize));
+        }
+        if (_txBuffer.append(data, size))
+        {
+            _txFrames.push(size);
+        }
+        else
+        {
+            _stats.add(TCPStatsCounter::TxDroppedBytes, size);
+        }
+    }
+    else if (_overflowPolicy == TCPOverflowPolicy::Backpressure)
+    {
+        if (!_txBuffer.append(data, size))
+        {
+            errorMessage = "TCPServer error: Memory budget is exceeded.";
+            return false;
+        }
+    }
+    else
+    {
+        // Keep only the newest _txBufferSize bytes.
+        _stats.add(TCPStatsCounter::TxDroppedBytes, _txBuffer.pushDropOldest(data, size, _txBufferSize));
+    }
+    _stats.max(TCPStatsCounter::TxHighWater, _txBuffer.size());
+
+    return true;
+}
+
+bool TCPServer::pushBackTxBuffer(const std::string* data)
+{
+    return pushBackTxBuffer(data->c_str(), data->size());
+}
+
+void TCPServer::setOverflowPolicy(TCPOverflowPolicy policy)
+{
+    _overflowPolicy = policy;
+    _txFrames.clear();
+    _rxPaused = false;
+
+    for (TCPConnection* connection : _connections)
+    {
+        if (connection != nullptr)
+        {
+            _applyOverflowPolicy(connection);
+        }
+    }
+}
+
+TCPOverflowPolicy TCPServer::getOverflowPolicy(void)
+{
+    return _overflowPolicy;
+}
+
+void TCPServer::setLowWatermarks(size_t txLowWatermark, size_t rxLowWatermark)
+{
+    _txLowWatermark = txLowWatermark;
+    _rxLowWatermark = rxLowWatermark;
+
+    for (TCPConnection* connection : _connections)
+    {
+        if (connection != nullptr)
+        {
+            _applyOverflowPolicy(connection);
+        }
+    }
+}
+
+bool TCPServer::_admitTx(size_t size)
+{
+    if (_overflowPolicy != TCPOverflowPolicy::Backpressure)
+    {
+        return true;
+    }
+
+    // Empty queue takes any size, so a message larger than TX buffer is not refused forever.
+    if ( _txBuffer.empty() || (_txBuffer.size() + size <= _txBufferSize) )
+    {
+        return true;
+    }
+
+    errorMessage = "TCPServer error: TX buffer is full.";
+    _stats.add(TCPStatsCounter::TxRefused);
+
+    return false;
+}
+
+void TCPServer::_recordTxFrame(size_t size)
+{
+    if (_overflowPolicy == TCPOverflowPolicy::DropOldestFrames)
+    {
+        // Part of frame that is already sent is found by sync().
+        _txFrames.push(size);
+        _txFrames.sync(_txBuffer.size());
+    }
+}
+
+bool TCPServer::startEventLoop(size_t maxConnections, TCPEventBackend backend)
+{
+    if (_serverSocket == -1)
+    {
+        errorMessage = "TCPServer error: Server is not listening for event loop.";
+        return false;
+    }
+
+    if (isEventLoopRunning())
+    {
+        errorMessage = "TCPServer error: Event loop is already started.";
+        return false;
+    }
+
+    _maxConnections = maxConnections;
+    _connectionCount = 0;
+
+    // io_uring falls back to epoll if kernel does not support it.
+    if ((backend == TCPEventBackend::IoUring) && _startIoUring())
+    {
+        // Submission queue of a new ring is empty.
+        if (_notifier != nullptr)
+        {
+            _armIoUringNotifier();
+        }
+        return true;
+    }
+
+    _epollSocket = epoll_create1(EPOLL_CLOEXEC);
+    if (_epollSocket == -1)
+    {
+        errorMessage = "TCPServer error: Error creating epoll descriptor.";
+        return false;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = _serverSocket;
+
+    if (epoll_ctl(_epollSocket, EPOLL_CTL_ADD, _serverSocket, &event) == -1)
+    {
+        errorMessage = "TCPServer error: Error adding server socket to epoll.";
+        close(_epollSocket);
+        _epollSocket = -1;
+        return false;
+    }
+
+    if ( (_notifier != nullptr) && !_watchNotifier() )
+    {
+        close(_epollSocket);
+        _epollSocket = -1;
+        return false;
+    }
+
+    _events.resize(TCPNetworkLinux_MAX_EVENTS);
+
+    // Connections that were waiting in the backlog before event loop started.
+    _acceptConnections();
+
+    return true;
+}
+
+void TCPServer::stopEventLoop(void)
+{
+    if (!isEventLoopRunning())
+    {
+        return;
+    }
+
+    for (TCPConnection* connection : _connections)
+    {
+        if (connection != nullptr)
+        {
+            _removeConnection(connection, TCPCloseReason::Shutdown);
+        }
+    }
+
+    if (_uring != nullptr)
+    {
+        _stopIoUring();
+    }
+    else
+    {
+        close(_epollSocket);
+        _epollSocket = -1;
+    }
+
+    for (TCPConnection* connection : _readyConnections)
+    {
+        connection->_inReadyList = false;
+    }
+    _readyConnections.clear();
+}
+
+bool TCPServer::isEventLoopRunning(void)
+{
+    return (_epollSocket != -1) || (_uring != nullptr);
+}
+
+TCPEventBackend TCPServer::getEventBackend(void)
+{
+    return (_uring != nullptr) ? TCPEventBackend::IoUring : TCPEventBackend::Epoll;
+}
+
+bool TCPServer::setNotifier(TCPNotifier* notifier)
+{
+    if (notifier == _notifier)
+    {
+        return true;
+    }
+
+    if ( (notifier != nullptr) && (notifier->getFileDescriptor() == -1) )
+    {
+        errorMessage = "TCPServer error: Notifier is not open.";
+        return false;
+    }
+
+    if (_notifier != nullptr)
+    {
+        if (_epollSocket != -1)
+        {
+            epoll_ctl(_epollSocket, EPOLL_CTL_DEL, _notifier->getFileDescriptor(), nullptr);
+        }
+        else if (_uring != nullptr)
+        {
+            // A poll that is not cancelled would report the removed notifier later.
+            struct io_uring_sqe* sqe = _uring->getSqe();
+            if (sqe == nullptr)
+            {
+                errorMessage = "TCPServer error: io_uring submission queue is full.";
+                return false;
+            }
+            _uringNotifierRearm = false;
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = (uint64_t)_notifier | TCPNetworkLinux_URING_NOTIFY;
+            sqe->user_data = TCPNetworkLinux_URING_CANCEL;
+        }
+    }
+
+    _notifier = notifier;
+
+    if (_notifier == nullptr)
+    {
+        return true;
+    }
+
+    if (_uring != nullptr)
+    {
+        _uringNotifierRearm = !_armIoUringNotifier();
+        return true;
+    }
+
+    if (_epollSocket != -1)
+    {
+        return _watchNotifier();
+    }
+
+    return true;
+}
+
+bool TCPServer::_watchNotifier(void)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = _notifier->getFileDescriptor();
+
+    if (epoll_ctl(_epollSocket, EPOLL_CTL_ADD, event.data.fd, &event) == -1)
+    {
+        errorMessage = "TCPServer error: Error adding notifier to epoll.";
+        return false;
+    }
+
+    return true;
+}
+
+int32_t TCPServer::runEventLoop(int timeoutMs)
+{
+    for (TCPConnection* connection : _readyConnections)
+    {
+        connection->_inReadyList = false;
+    }
+    _readyConnections.clear();
+
+    for (TCPConnection* connection : _drainedConnections)
+    {
+        connection->_inDrainedList = false;
+    }
+    _drainedConnections.clear();
+
+    _heartbeatConnections.clear();
+
+    _acceptedConnections.clear();
+    _acceptedDispatched = 0;
+
+    // Closed connections leave resume, unblock and deferred send lists before they are deleted.
+    _rxResumed.erase(std::remove_if(_rxResumed.begin(), _rxResumed.end(), [](TCPConnection* connection) { return !connection->_connected; }), _rxResumed.end());
+    _txUnblocked.erase(std::remove_if(_txUnblocked.begin(), _txUnblocked.end(), [](TCPConnection* connection) { return !connection->_connected; }), _txUnblocked.end());
+    _txDeferred.erase(std::remove_if(_txDeferred.begin(), _txDeferred.end(), [](TCPConnection* connection) { return !connection->_connected; }), _txDeferred.end());
+    _deleteClosedConnections();
+
+    // Connections that write() unblocked between iterations are reported without waiting.
+    _markUnblocked();
+
+    if (!_statsDumpPath.empty())
+    {
+        _dumpStats();
+    }
+
+    // Wake up for next timer expiry. Data read from resumed connections is reported without waiting.
+    int32_t resumedNum = _resumeConnections();
+    int waitMs = ((resumedNum > 0) || !_drainedConnections.empty() || !_rxResumed.empty()) ? 0 : _timers.getTimeout(timeoutMs);
+
+    if (_uring != nullptr)
+    {
+        int32_t completionNum = _runIoUring(waitMs);
+        if (completionNum == -1)
+        {
+            return -1;
+        }
+        _markUnblocked();
+        return completionNum + (int32_t)_timers.advance();
+    }
+
+    if (_epollSocket == -1)
+    {
+        errorMessage = "TCPServer error: Event loop is not started.";
+        return -1;
+    }
+
+    int eventNum = epoll_wait(_epollSocket, _events.data(), (int)_events.size(), waitMs);
+    if (eventNum == -1)
+    {
+        if (errno != EINTR)
+        {
+            errorMessage = "TCPServer error: epoll_wait failed.";
+            return -1;
+        }
+        eventNum = 0;
+    }
+
+    // Activity times of connections use cached time of this iteration.
+    _timers.updateTime();
+
+    for (int i = 0; i < eventNum; i++)
+    {
+        int socket = _events[i].data.fd;
+        uint32_t events = _events[i].events;
+
+        if (socket == _serverSocket)
+        {
+            _acceptConnections();
+            continue;
+        }
+
+        if ( (_notifier != nullptr) && (socket == _notifier->getFileDescriptor()) )
+        {
+            _notifier->clear();
+            continue;
+        }
+
+        TCPConnection* connection = getConnection(socket);
+        if (connection == nullptr)
+        {
+            continue;
+        }
+
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+        {
+            if (connection->_readAll((events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0) > 0)
+            {
+                connection->_lastRxTime = _timers.getTime();
+                _markReady(connection);
+            }
+        }
+
+        if ((events & EPOLLOUT) && connection->_connected && !connection->_txBuffer.empty())
+        {
+            // write() adds the connection to unblock list if it clears blocked state.
+            connection->write();
+
+            if (connection->_connected && connection->_txBuffer.empty())
+            {
+                _markDrained(connection);
+            }
+        }
+
+        if (!connection->_connected)
+        {
+            _removeConnection(connection, TCPCloseReason::Error);
+        }
+    }
+
+    _markUnblocked();
+
+    return resumedNum + eventNum + (int32_t)_timers.advance();
+}
+
+int TCPServer::_resumeConnections(void)
+{
+    int resumedNum = 0;
+
+    // Recv that does not fit into a full submission queue adds its connection to the list again.
+    std::vector<TCPConnection*> resumed;
+    resumed.swap(_rxResumed);
+
+    for (TCPConnection* connection : resumed)
+    {
+        if (_uring != nullptr)
+        {
+            // Cancelled recv is armed again by its last completion if it is still in flight.
+            if (!connection->_rxArmed)
+            {
+                _armIoUringRecv(connection);
+            }
+            continue;
+        }
+
+        // Edge triggered epoll does not report data that arrived while reading was paused.
+        if (connection->_readAll(true) > 0)
+        {
+            connection->_lastRxTime = _timers.getTime();
+            _markReady(connection);
+            resumedNum++;
+        }
+
+        if (!connection->_connected)
+        {
+            _removeConnection(connection, TCPCloseReason::Error);
+        }
+    }
+
+    return resumedNum;
+}
+
+void TCPServer::_applyOverflowPolicy(TCPConnection* connection)
+{
+    connection->_overflowPolicy = _overflowPolicy;
+    connection->_txLowWatermark = (_txLowWatermark > 0) ? _txLowWatermark : connection->_txBufferSize / 2;
+    connection->_rxLowWatermark = (_rxLowWatermark > 0) ? _rxLowWatermark : connection->_rxBufferSize / 2;
+    connection->_txFrames.clear();
+
+    // Paused connection continues when its policy is changed.
+    if (connection->_rxPaused && (_overflowPolicy != TCPOverflowPolicy::Backpressure))
+    {
+        connection->_rxPaused = false;
+        _rxResumed.push_back(connection);
+    }
+}
+
+const std::vector<TCPConnection*>& TCPServer::getAcceptedConnections(void)
+{
+    return _acceptedConnections;
+}
+
+const std::vector<TCPConnection*>& TCPServer::getReadyConnections(void)
+{
+    return _readyConnections;
+}
+
+const std::vector<TCPConnection*>& TCPServer::getDrainedConnections(void)
+{
+    return _drainedConnections;
+}
+
+const std::vector<TCPConnection*>& TCPServer::getHeartbeatConnections(void)
+{
+    return _heartbeatConnections;
+}
+
+void TCPServer::setIdleTimeout(int timeoutMs)
+{
+    _idleTimeout = std::max(timeoutMs, 0);
+
+    for (TCPConnection* connection : _connections)
+    {
+        if (connection != nullptr)
+        {
+            _armConnectionTimers(connection);
+        }
+    }
+}
+
+void TCPServer::setWriteTimeout(int timeoutMs)
+{
+    _writeTimeout = std::max(timeoutMs, 0);
+
+    for (TCPConnection* connection : _connections)
+    {
+        if (connection != nullptr)
+        {
+            _armConnectionTimers(connection);
+        }
+    }
+}
+
+void TCPServer::setHeartbeatInterval(int intervalMs)
+{
+    _heartbeatInterval = std::max(intervalMs, 0);
+
+    for (TCPConnection* connection : _connections)
+    {
+        if (connection != nullptr)
+        {
+            _armConnectionTimers(connection);
+        }
+    }
+}
+
+TCPTimerWheel& TCPServer::getTimerWheel(void)
+{
+    return _timers;
+}
+
+void TCPServer::_armConnectionTimers(TCPConnection* connection)
+{
+    connection->_idleTimeout = _idleTimeout;
+    connection->_writeTimeout = _writeTimeout;
+    connection->_heartbeatInterval = _heartbeatInterval;
+
+    // Timers are armed once per period. I/O only stores its time and expired timers are re-armed from it.
+    if (_idleTimeout > 0)
+    {
+        _timers.armAt(connection->_idleTimer, connection->_lastRxTime + _idleTimeout);
+    }
+    else
+    {
+        connection->_idleTimer.cancel();
+    }
+
+    if (_heartbeatInterval > 0)
+    {
+        _timers.armAt(connection->_heartbeatTimer, connection->_lastTxTime + _heartbeatInterval);
+    }
+    else
+    {
+        connection->_heartbeatTimer.cancel();
+    }
+
+    if (_writeTimeout <= 0)
+    {
+        connection->_writeTimer.cancel();
+    }
+    connection->_updateWriteTimer();
+}
+
+void TCPServer::_onIdleTimer(TCPTimer &timer, void* context)
+{
+    TCPConnection* connection = (TCPConnection*)context;
+    TCPServer* server = connection->_server;
+    uint64_t idleTime = server->_timers.getTime() - connection->_lastRxTime;
+
+    if (idleTime < (uint64_t)connection->_idleTimeout)
+    {
+        server->_timers.arm(timer, connection->_idleTimeout - idleTime);
+        return;
+    }
+
+    connection->errorMessage = "TCPConnection error: Idle timeout.";
+    connection->_connected = false;
+    server->_removeConnection(connection, TCPCloseReason::IdleTimeout);
+}
+
+void TCPServer::_onWriteTimer(TCPTimer &timer, void* context)
+{
+    (void)timer;
+    TCPConnection* connection = (TCPConnection*)context;
+
+    connection->errorMessage = "TCPConnection error: Write timeout.";
+    connection->_connected = false;
+    connection->_server->_removeConnection(connection, TCPCloseReason::WriteTimeout);
+}
+
+void TCPServer::_onHeartbeatTimer(TCPTimer &timer, void* context)
+{
+    TCPConnection* connection = (TCPConnection*)context;
+    TCPServer* server = connection->_server;
+    uint64_t quietTime = server->_timers.getTime() - connection->_lastTxTime;
+
+    if (quietTime < (uint64_t)connection->_heartbeatInterval)
+    {
+        server->_timers.arm(timer, connection->_heartbeatInterval - quietTime);
+        return;
+    }
+
+    server->_heartbeatConnections.push_back(connection);
+    server->_timers.arm(timer, connection->_heartbeatInterval);
+}
+
+const std::vector<TCPConnection*>& TCPServer::getClosedConnections(void)
+{
+    return _closedConnections;
+}
+
+TCPConnection* TCPServer::getConnection(int socket)
+{
+    if (socket < 0 || (size_t)socket >= _connections.size())
+    {
+        return nullptr;
+    }
+
+    return _connections[socket];
+}
+
+size_t TCPServer::getConnectionCount(void)
+{
+    return _connectionCount;
+}
+
+void TCPServer::closeConnection(int socket)
+{
+    TCPConnection* connection = getConnection(socket);
+
+    if (connection != nullptr)
+    {
+        _removeConnection(connection, TCPCloseReason::Local);
+    }
+}
+
+void TCPServer::setSocketOptions(const TCPSocketOptions &options)
+{
+    _socketOptions = options;
+}
+
+TCPSocketOptions TCPServer::getSocketOptions(void)
+{
+    return _socketOptions;
+}
+
+TCPSocketOptions TCPServer::getAppliedSocketOptions(void)
+{
+    return TCPNetworkLinuxNamespace::getSocketOptions(_serverSocket);
+}
+
+TCPStatsSnapshot TCPServer::getStats(void)
+{
+    return _stats.snapshot();
+}
+
+void TCPServer::resetStats(void)
+{
+    _stats.reset();
+}
+
+std::string TCPServer::getStatsPrometheus(bool perConnection)
+{
+    std::string output;
+    std::string labels = "server=\"" + _ip + ":" + std::to_string(_port) + "\"";
+
+    TCPStats::formatPrometheus(output, _stats.snapshot(), labels);
+
+    if (perConnection)
+    {
+        for (TCPConnection* connection : _connections)
+        {
+            if (connection == nullptr)
+            {
+                continue;
+            }
+
+            std::string connectionLabels = labels + ",connection=\"" + connection->getIP() + ":" + std::to_string(connection->getPort()) + "\"";
+            TCPStats::formatPrometheus(output, connection->getStats(), connectionLabels, false);
+        }
+    }
+
+    // Pool is process wide, so its series have no server label.
+    TCPBufferPool::formatPrometheus(output);
+
+    return output;
+}
+
+void TCPServer::setStatsDump(const std::string &path, int intervalMs, bool perConnection)
+{
+    _statsDumpPath = path;
+    _statsDumpInterval = std::chrono::milliseconds(std::max(intervalMs, 0));
+    _statsDumpPerConnection = perConnection;
+    _statsDumpTime = std::chrono::steady_clock::now();
+}
+
+void TCPServer::_dumpStats(void)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now < _statsDumpTime)
+    {
+        return;
+    }
+    _statsDumpTime = now + _statsDumpInterval;
+
+    // Readers never see a partially written file.
+    std::string temporaryPath = _statsDumpPath + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::trunc);
+    if (!file)
+    {
+        errorMessage = "TCPServer error: Error opening statistics dump file.";
+        return;
+    }
+
+    file << getStatsPrometheus(_statsDumpPerConnection);
+    file.close();
+
+    if (!file || (rename(temporaryPath.c_str(), _statsDumpPath.c_str()) == -1))
+    {
+        errorMessage = "TCPServer error: Error writing statistics dump file.";
+    }
+}
+
+void TCPServer::_acceptConnections(void)
+{
+    while (true)
+    {
+        // Unix domain peers fill only the address family.
+        struct sockaddr_in clientAddress;
+        socklen_t clientAddressLength = sizeof(clientAddress);
+        memset(&clientAddress, 0, sizeof(clientAddress));
+
+        int socket = accept4(_serverSocket, (struct sockaddr*)&clientAddress, &clientAddressLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket == -1)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+
+            if (errno != EWOULDBLOCK && errno != EAGAIN)
+            {
+                errorMessage = "TCPServer error: Accept client failed";
+            }
+            return;
+        }
+
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        // EPOLLOUT is edge triggered too, so it only fires when a full socket becomes writable again.
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = socket;
+
+        if (epoll_ctl(_epollSocket, EPOLL_CTL_ADD, socket, &event) == -1)
+        {
+            errorMessage = "TCPServer error: Error adding client socket to epoll.";
+            close(socket);
+            continue;
+        }
+
+        _addConnection(socket, clientAddress);
+    }
+}
+
+TCPConnection* TCPServer::_addConnection(int socket, const struct sockaddr_in &address)
+{
+    if (_connectionCount >= _maxConnections)
+    {
+        errorMessage = "TCPServer error: Maximum number of connections reached.";
+        close(socket);
+        return nullptr;
+    }
+
+    if ((size_t)socket >= _connections.size())
+    {
+        _connections.resize(socket + 1, nullptr);
+    }
+
+    std::string failedOptions;
+    if (!TCPNetworkLinuxNamespace::applySocketOptions(socket, _socketOptions, failedOptions, _unixPath.empty()))
+    {
+        errorMessage = "TCPServer error: Error setting socket options: " + failedOptions;
+    }
+
+    TCPConnection* connection = new TCPConnection(socket, address, _rxBufferSize, _txBufferSize);
+    connection->_serverStats = &_stats;
+    connection->_server = this;
+    connection->_timerWheel = &_timers;
+    connection->_lastRxTime = _timers.getTime();
+    connection->_lastTxTime = _timers.getTime();
+    connection->_idleTimer.setCallback(&TCPServer::_onIdleTimer, connection);
+    connection->_writeTimer.setCallback(&TCPServer::_onWriteTimer, connection);
+    connection->_heartbeatTimer.setCallback(&TCPServer::_onHeartbeatTimer, connection);
+    connection->_rxResumeList = &_rxResumed;
+    connection->_txUnblockList = &_txUnblocked;
+    _applyOverflowPolicy(connection);
+    _armConnectionTimers(connection);
+    _connections[socket] = connection;
+    _connectionCount++;
+    _stats.add(TCPStatsCounter::Accepts);
+    _acceptedConnections.push_back(connection);
+
+    return connection;
+}
+
+void TCPServer::_markReady(TCPConnection* connection)
+{
+    if (!connection->_inReadyList)
+    {
+        connection->_inReadyList = true;
+        _readyConnections.push_back(connection);
+    }
+}
+
+void TCPServer::_markDrained(TCPConnection* connection)
+{
+    if (!connection->_inDrainedList)
+    {
+        connection->_inDrainedList = true;
+        _drainedConnections.push_back(connection);
+    }
+}
+
+void TCPServer::_markUnblocked(void)
+{
+    for (TCPConnection* connection : _txUnblocked)
+    {
+        if (connection->_connected)
+        {
+            _markDrained(connection);
+        }
+    }
+    _txUnblocked.clear();
+}
+
+void TCPServer::_removeConnection(TCPConnection* connection, TCPCloseReason reason)
+{
+    int socket = connection->_socket;
+
+    if (connection->_closeReason == TCPCloseReason::None)
+    {
+        connection->_closeReason = reason;
+    }
+
+    if (socket != -1)
+    {
+        if (_uring != nullptr)
+        {
+            // Finish multishot recv and in flight send of this connection before its descriptor is closed.
+            // Cancel is only a speed up. Shut down socket completes the recv anyway if submission queue is full.
+            shutdown(socket, SHUT_RDWR);
+
+            struct io_uring_sqe* sqe = _uring->getSqe();
+            if (sqe != nullptr)
+            {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->fd = -1;
+                sqe->addr = (uint64_t)connection | TCPNetworkLinux_URING_RECV;
+                sqe->user_data = TCPNetworkLinux_URING_CANCEL;
+            }
+
+            _uring->unregisterFile(connection->_fileSlot);
+            connection->_fileSlot = -1;
+        }
+        else
+        {
+            epoll_ctl(_epollSocket, EPOLL_CTL_DEL, socket, nullptr);
+        }
+        _connections[socket] = nullptr;
+        _connectionCount--;
+        _stats.add(TCPStatsCounter::Disconnects);
+    }
+
+    connection->_close();
+    _closedConnections.push_back(connection);
+}
+
+void TCPServer::_deleteClosedConnections(void)
+{
+    size_t zombieNum = 0;
+
+    for (TCPConnection* connection : _zombieConnections)
+    {
+        if (connection->_uringPending == 0)
+        {
+            delete connection;
+        }
+        else
+        {
+            _zombieConnections[zombieNum++] = connection;
+        }
+    }
+    _zombieConnections.resize(zombieNum);
+
+    for (TCPConnection* connection : _closedConnections)
+    {
+        // io_uring requests may still refer to buffers of this object.
+        if (connection->_uringPending == 0)
+        {
+            delete connection;
+        }
+        else
+        {
+            _zombieConnections.push_back(connection);
+        }
+    }
+    _closedConnections.clear();
+    _closedDispatched = 0;
+}
+
+bool TCPServer::_startIoUring(void)
+{
+    // Registered file slots are indexed by socket descriptor.
+    struct rlimit limit;
+    unsigned fileSlots = TCPNetworkLinux_URING_ENTRIES;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        fileSlots = (unsigned)std::min<rlim_t>(limit.rlim_cur, 65536);
+    }
+
+    _uring = new TCPIoUring();
+    if (!_uring->start(TCPNetworkLinux_URING_ENTRIES, fileSlots))
+    {
+        errorMessage = "TCPServer error: io_uring backend is not available (" + _uring->errorMessage + "). Event loop uses epoll.";
+        delete _uring;
+        _uring = nullptr;
+        return false;
+    }
+
+    // Submission queue of a new ring is empty.
+    _armIoUringAccept();
+    _uring->enter(0, 0);
+
+    return true;
+}
+
+void TCPServer::_stopIoUring(void)
+{
+    // Cancel accept and wait until kernel completes all requests that refer to connection buffers.
+    // Accept does not refer to connection buffers, so closing the ring cancels it if submission queue is full.
+    struct io_uring_sqe* sqe = _uring->getSqe();
+    if (sqe != nullptr)
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = TCPNetworkLinux_URING_ACCEPT;
+        sqe->user_data = TCPNetworkLinux_URING_CANCEL;
+    }
+
+    // Sockets of closed connections are shut down and their requests are cancelled, so all of them complete. There is no timeout.
+    while (true)
+    {
+        bool pending = false;
+        for (TCPConnection* connection : _closedConnections)
+        {
+            pending = pending || (connection->_uringPending > 0);
+        }
+        for (TCPConnection* connection : _zombieConnections)
+        {
+            pending = pending || (connection->_uringPending > 0);
+        }
+
+        if (!pending)
+        {
+            break;
+        }
+
+        if (_uring->enter(1, -1) == -1)
+        {
+            // Ring does not work. Closing it makes the kernel cancel remained requests before buffers are released.
+            errorMessage = "TCPServer error: io_uring_enter failed while stopping.";
+            break;
+        }
+        _handleIoUringCompletions();
+    }
+
+    _txDeferred.clear();
+    delete _uring;
+    _uring = nullptr;
+}
+
+int32_t TCPServer::_runIoUring(int timeoutMs)
+{
+    // Multishot requests that ended while submission queue was full.
+    if (_uringAcceptRearm)
+    {
+        _uringAcceptRearm = !_armIoUringAccept();
+    }
+    if (_uringNotifierRearm && (_notifier != nullptr))
+    {
+        _uringNotifierRearm = !_armIoUringNotifier();
+    }
+
+    _submitIoUringSends();
+
+    // Do not wait if completions are already available, or requests wait for space in submission queue.
+    bool retry = !_txDeferred.empty() || _uringAcceptRearm || _uringNotifierRearm;
+    unsigned waitNum = ((timeoutMs == 0) || retry || _uring->hasCompletion()) ? 0 : 1;
+
+    if (_uring->enter(waitNum, timeoutMs) == -1)
+    {
+        errorMessage = "TCPServer error: io_uring_enter failed.";
+        return -1;
+    }
+
+    // Activity times of connections use cached time of this iteration.
+    _timers.updateTime();
+
+    return _handleIoUringCompletions();
+}
+
+int32_t TCPServer::_handleIoUringCompletions(void)
+{
+    int32_t completionNum = 0;
+    unsigned head = *_uring->cqHead;
+    unsigned tail = __atomic_load_n(_uring->cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++, completionNum++)
+    {
+        struct io_uring_cqe* cqe = &_uring->cqes[head & *_uring->cqMask];
+        uint64_t type = cqe->user_data & TCPNetworkLinux_URING_TYPE_MASK;
+        TCPConnection* connection = (TCPConnection*)(cqe->user_data & ~TCPNetworkLinux_URING_TYPE_MASK);
+        int32_t result = cqe->res;
+        uint32_t flags = cqe->flags;
+        bool more = (flags & IORING_CQE_F_MORE);
+
+        if (type == TCPNetworkLinux_URING_ACCEPT)
+        {
+            if (result >= 0)
+            {
+                struct sockaddr_in clientAddress;
+                socklen_t clientAddressLength = sizeof(clientAddress);
+                memset(&clientAddress, 0, sizeof(clientAddress));
+                getpeername(result, (struct sockaddr*)&clientAddress, &clientAddressLength);
+
+                TCPConnection* newConnection = _addConnection(result, clientAddress);
+                if (newConnection != nullptr)
+                {
+                    newConnection->_txDeferredList = &_txDeferred;
+                    newConnection->_fileSlot = _uring->registerFile(result);
+                    _armIoUringRecv(newConnection);
+                }
+            }
+            else if ((result != -ECANCELED) && (result != -EAGAIN) && (result != -ECONNABORTED))
+            {
+                errorMessage = "TCPServer error: Accept client failed";
+            }
+
+            if (!more && (result != -ECANCELED) && (_serverSocket != -1))
+            {
+                _uringAcceptRearm = !_armIoUringAccept();
+            }
+        }
+        else if (type == TCPNetworkLinux_URING_NOTIFY)
+        {
+            // Completions of a removed notifier only end its poll.
+            if ((void*)connection == (void*)_notifier)
+            {
+                _notifier->clear();
+                if (!more && (result >= 0))
+                {
+                    _uringNotifierRearm = !_armIoUringNotifier();
+                }
+            }
+        }
+        else if (type == TCPNetworkLinux_URING_RECV)
+        {
+            if (flags & IORING_CQE_F_BUFFER)
+            {
+                unsigned bufferId = flags >> IORING_CQE_BUFFER_SHIFT;
+                if ((result > 0) && connection->_connected)
+                {
+                    size_t droppedBytes = 0;
+                    if (connection->_overflowPolicy == TCPOverflowPolicy::Backpressure)
+                    {
+                        // Received data can not go back to the socket. Keep it, recv is not armed again while buffer is full.
+                        connection->_rxBuffer.append(_uring->buffer(bufferId), result);
+                    }
+                    else
+                    {
+                        droppedBytes = connection->_rxBuffer.pushDropOldest(_uring->buffer(bufferId), result, connection->_rxBufferSize);
+                    }
+                    connection->_countRx(result, droppedBytes);
+                }
+                _uring->recycleBuffer(bufferId);
+            }
+            else if ((result != -ENOBUFS) && (result != -ECANCELED))
+            {
+                connection->_countRx(result, 0);
+            }
+
+            if (!more)
+            {
+                connection->_uringPending--;
+                connection->_rxArmed = false;
+            }
+
+            if (connection->_socket == -1)
+            {
+                continue;
+            }
+
+            if (result > 0)
+            {
+                connection->_lastRxTime = _timers.getTime();
+                _markReady(connection);
+            }
+            else if (result == 0)
+            {
+                connection->errorMessage = "TCPConnection error: Client disconnected.";
+                connection->_connected = false;
+                connection->_closeReason = TCPCloseReason::PeerClosed;
+            }
+            else if ((result != -ENOBUFS) && (result != -ECANCELED))
+            {
+                connection->errorMessage = "TCPConnection error: Error receiving message.";
+                connection->_connected = false;
+                connection->_closeReason = TCPCloseReason::Error;
+            }
+
+            if (!connection->_connected)
+            {
+                _removeConnection(connection, TCPCloseReason::Error);
+            }
+            else if ( (connection->_overflowPolicy == TCPOverflowPolicy::Backpressure) && (connection->_rxBuffer.size() >= connection->_rxBufferSize) )
+            {
+                _pauseIoUringRecv(connection);
+            }
+            else if (!more && !connection->_rxPaused)
+            {
+                // Multishot recv stops when provided buffers run out or when a cancelled recv of a pause that is over now completes. Arm it again.
+                _armIoUringRecv(connection);
+            }
+        }
+        else if (type == TCPNetworkLinux_URING_SEND)
+        {
+            connection->_uringPending--;
+            connection->_txInFlight = false;
+
+            if (connection->_socket == -1)
+            {
+                continue;
+            }
+
+            size_t offeredBytes = connection->_txSending.size();
+            connection->_countTx(result, offeredBytes, offeredBytes + connection->_txBuffer.size());
+
+            if (result >= 0)
+            {
+                connection->_txSending.discard(result);
+            }
+
+            if ((result >= 0) || (result == -EAGAIN) || (result == -EINTR))
+            {
+                // Short send: the remainder waits for socket space like EPOLLOUT of epoll backend.
+                connection->_txWaited = connection->_txWaited || ((size_t)std::max(result, 0) < offeredBytes);
+            }
+            else
+            {
+                connection->errorMessage = "TCPConnection error: Error sending message.";
+                connection->_connected = false;
+                connection->_closeReason = TCPCloseReason::Error;
+                _removeConnection(connection, TCPCloseReason::Error);
+                continue;
+            }
+
+            // Remained bytes and data queued meanwhile go in the next batch.
+            connection->write();
+            connection->_releaseIdleBuffers();
+
+            // Like epoll backend, drained is reported only after blocked state or a remainder that waited for socket space.
+            bool unblocked = connection->_unblockTx();
+            bool flushed = connection->_txWaited && connection->_txSending.empty() && connection->_txBuffer.empty();
+            if (flushed)
+            {
+                connection->_txWaited = false;
+            }
+            if (unblocked || flushed)
+            {
+                _markDrained(connection);
+            }
+        }
+    }
+
+    __atomic_store_n(_uring->cqHead, head, __ATOMIC_RELEASE);
+
+    return completionNum;
+}
+
+bool TCPServer::_hasIoUringWork(void)
+{
+    return !_rxResumed.empty() || !_txDeferred.empty() || !_drainedConnections.empty() || !_txUnblocked.empty() ||
+           _uringAcceptRearm || _uringNotifierRearm;
+}
+
+bool TCPServer::_armIoUringNotifier(void)
+{
+    struct io_uring_sqe* sqe = _uring->getSqe();
+    if (sqe == nullptr)
+    {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = _notifier->getFileDescriptor();
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = (uint64_t)_notifier | TCPNetworkLinux_URING_NOTIFY;
+
+    return true;
+}
+
+bool TCPServer::_armIoUringAccept(void)
+{
+    struct io_uring_sqe* sqe = _uring->getSqe();
+    if (sqe == nullptr)
+    {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _serverSocket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = TCPNetworkLinux_URING_ACCEPT;
+
+    return true;
+}
+
+void TCPServer::_armIoUringRecv(TCPConnection* connection)
+{
+    struct io_uring_sqe* sqe = _uring->getSqe();
+    if (sqe == nullptr)
+    {
+        _rxResumed.push_back(connection);
+        return;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = (connection->_fileSlot != -1) ? connection->_fileSlot : connection->_socket;
+    sqe->flags = IOSQE_BUFFER_SELECT | ((connection->_fileSlot != -1) ? IOSQE_FIXED_FILE : 0);
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->buf_group = TCPNetworkLinux_URING_BUFFER_GROUP;
+    sqe->user_data = (uint64_t)connection | TCPNetworkLinux_URING_RECV;
+    connection->_uringPending++;
+    connection->_rxArmed = true;
+
+    if ( (connection->_overflowPolicy == TCPOverflowPolicy::Backpressure) && (connection->_rxBuffer.size() < connection->_rxBufferSize) )
+    {
+        // Multishot recv fills provided buffers faster than the application consumes. One shot recv reads only into free space.
+        sqe->ioprio = 0;
+        sqe->len = (uint32_t)std::min(connection->_rxBufferSize - connection->_rxBuffer.size(), (size_t)UINT32_MAX);
+    }
+}
+
+void TCPServer::_pauseIoUringRecv(TCPConnection* connection)
+{
+    if (connection->_rxPaused)
+    {
+        return;
+    }
+
+    // Multishot recv armed before policy was changed. Buffers that complete before the cancel are still appended.
+    // If submission queue is full, connection is not paused yet and next completion of the recv tries again.
+    if (connection->_rxArmed)
+    {
+        struct io_uring_sqe* sqe = _uring->getSqe();
+        if (sqe == nullptr)
+        {
+            return;
+        }
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = (uint64_t)connection | TCPNetworkLinux_URING_RECV;
+        sqe->user_data = TCPNetworkLinux_URING_CANCEL;
+    }
+
+    connection->_rxPaused = true;
+    connection->_stats.add(TCPStatsCounter::RxPauses);
+    _stats.add(TCPStatsCounter::RxPauses);
+}
+
+void TCPServer::_submitIoUringSends(void)
+{
+    size_t keptNum = 0;
+
+    for (TCPConnection* connection : _txDeferred)
+    {
+        if (!connection->_connected || connection->_txInFlight || (connection->_txSending.empty() && connection->_txBuffer.empty()))
+        {
+            connection->_txDeferred = false;
+            continue;
+        }
+
+        // Submission queue is full. Connection stays in the list and next iteration sends it.
+        struct io_uring_sqe* sqe = _uring->getSqe();
+        if (sqe == nullptr)
+        {
+            _txDeferred[keptNum++] = connection;
+            continue;
+        }
+        connection->_txDeferred = false;
+
+        // Send from a buffer that nobody appends to until the send completes.
+        if (connection->_txSending.empty())
+        {
+            connection->_txSending.swap(connection->_txBuffer);
+        }
+
+        std::string_view data = connection->_txSending.linearize();
+
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = (connection->_fileSlot != -1) ? connection->_fileSlot : connection->_socket;
+        sqe->flags = (connection->_fileSlot != -1) ? IOSQE_FIXED_FILE : 0;
+        sqe->addr = (uint64_t)data.data();
+        sqe->len = (uint32_t)std::min<size_t>(data.size(), UINT32_MAX);
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = (uint64_t)connection | TCPNetworkLinux_URING_SEND;
+
+        connection->_txInFlight = true;
+        connection->_uringPending++;
+    }
+
+    _txDeferred.resize(keptNum);
+}
+
+// ######################################################################
+// TCPShardedServer class:
+
+TCPShardedServer::TCPShardedServer()
+{
+    _running = false;
+    _cpuSteering = false;
+}
+
+TCPShardedServer::~TCPShardedServer()
+{
+    stop();
+}
+
+bool TCPShardedServer::start(const uint16_t port, const char* ip, size_t shardCount, Handler handler, bool cpuSteering,
+                             TCPEventBackend backend, size_t maxConnections)
+{
+    if (!_shards.empty())
+    {
+        errorMessage = "TCPShardedServer error: Server is already started.";
+        return false;
+    }
+
+    if (!handler)
+    {
+        errorMessage = "TCPShardedServer error: Handler is empty.";
+        return false;
+    }
+
+    // CPUs that the process may run on, in ascending order. Shard i is pinned to cpus[i].
+    std::vector<int> cpus;
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &cpuSet))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+
+    if (shardCount == 0)
+    {
+        shardCount = cpus.empty() ? std::max<size_t>(1, std::thread::hardware_concurrency()) : cpus.size();
+    }
+
+    errorMessage = "";
+    _handler = handler;
+
+    // Listening sockets join reuseport group in listen() order, so socket index in group is the shard index.
+    for (size_t i = 0; i < shardCount; i++)
+    {
+        TCPServer* shard = new TCPServer();
+        _shards.push_back(shard);
+        shard->setSocketOptions(_socketOptions);
+
+        if ( !shard->startByIP(port, ip) || !shard->startEventLoop(maxConnections, backend) )
+        {
+            errorMessage = "TCPShardedServer error: Shard " + std::to_string(i) + ": " + shard->errorMessage;
+            stop();
+            return false;
+        }
+    }
+
+    // A connection whose packets are processed by a CPU without shard would be served by a shard of another CPU.
+    _cpuSteering = false;
+    bool steering = false;
+    if (cpuSteering)
+    {
+        long onlineNum = sysconf(_SC_NPROCESSORS_ONLN);
+
+        if ( cpus.empty() || ((long)cpus.size() < onlineNum) )
+        {
+            errorMessage = "TCPShardedServer error: CPU steering is disabled. Process may not run on every online CPU that processes packets.";
+        }
+        else if (shardCount != cpus.size())
+        {
+            errorMessage = "TCPShardedServer error: CPU steering is disabled. Number of shards is not the number of CPUs.";
+        }
+        else
+        {
+            steering = true;
+        }
+    }
+
+    _running = true;
+
+    for (size_t i = 0; i < shardCount; i++)
+    {
+        _threads.emplace_back(&TCPShardedServer::_runShard, this, i);
+    }
+
+    // All shards are pinned before program is attached, so kernel steers only when every shard runs on its CPU.
+    size_t pinnedNum = 0;
+    if (steering)
+    {
+        for (; pinnedNum < shardCount; pinnedNum++)
+        {
+            cpu_set_t shardSet;
+            CPU_ZERO(&shardSet);
+            CPU_SET(cpus[pinnedNum], &shardSet);
+
+            if (pthread_setaffinity_np(_threads[pinnedNum].native_handle(), sizeof(shardSet), &shardSet) != 0)
+            {
+                errorMessage = "TCPShardedServer error: CPU steering is disabled. Error setting CPU affinity of shard " + std::to_string(pinnedNum) + ".";
+                break;
+            }
+        }
+
+        _cpuSteering = (pinnedNum == shardCount) && _attachCpuSteering(cpus);
+    }
+
+    // Without steering, pinned shards run on all allowed CPUs again.
+    if (!_cpuSteering)
+    {
+        for (size_t i = 0; i < pinnedNum; i++)
+        {
+            pthread_setaffinity_np(_threads[i].native_handle(), sizeof(cpuSet), &cpuSet);
+        }
+    }
+
+    return true;
+}
+
+void TCPShardedServer::setSocketOptions(const TCPSocketOptions &options)
+{
+    _socketOptions = options;
+}
+
+void TCPShardedServer::stop(void)
+{
+    _running = false;
+
+    for (std::thread& thread : _threads)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+    _threads.clear();
+
+    for (TCPServer* shard : _shards)
+    {
+        delete shard;
+    }
+    _shards.clear();
+
+    _cpuSteering = false;
+}
+
+bool TCPShardedServer::isRunning(void)
+{
+    return _running;
+}
+
+bool TCPShardedServer::isCpuSteering(void)
+{
+    return _cpuSteering;
+}
+
+size_t TCPShardedServer::getShardCount(void)
+{
+    return _shards.size();
+}
+
+TCPServer* TCPShardedServer::getShard(size_t index)
+{
+    if (index >= _shards.size())
+    {
+        return nullptr;
+    }
+
+    return _shards[index];
+}
+
+void TCPShardedServer::_runShard(size_t index)
+{
+    TCPServer* shard = _shards[index];
+
+    while (_running.load(std::memory_order_relaxed))
+    {
+        if (shard->runEventLoop(TCPNetworkLinux_SHARD_LOOP_TIMEOUT) < 0)
+        {
+            // Error is kept in errorMessage of shard. Avoid busy loop on persistent errors.
+            std::this_thread::sleep_for(std::chrono::milliseconds(TCPNetworkLinux_SHARD_LOOP_TIMEOUT));
+            continue;
+        }
+
+        _handler(*shard, index);
+    }
+}
+
+bool TCPShardedServer::_attachCpuSteering(const std::vector<int> &cpus)
+{
+    // Reuseport program: socket index = shard of the CPU that received the packet. CPU numbers may have gaps, so it is a compare chain.
+    std::vector<struct sock_filter> code;
+    code.push_back({ BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU) });
+    for (size_t i = 0; i < cpus.size(); i++)
+    {
+        code.push_back({ BPF_JMP | BPF_JEQ | BPF_K, 0, 1, (uint32_t)cpus[i] });
+        code.push_back({ BPF_RET | BPF_K, 0, 0, (uint32_t)i });
+    }
+    // Index out of group makes kernel use its default hash selection.
+    code.push_back({ BPF_RET | BPF_K, 0, 0, (uint32_t)cpus.size() });
+
+    struct sock_fprog program;
+    program.len = (unsigned short)code.size();
+    program.filter = code.data();
+
+    // Program is shared by the whole reuseport group, so it is attached to one socket.
+    if ( (code.size() <= BPF_MAXINSNS) && (setsockopt(_shards[0]->_serverSocket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0) )
+    {
+        return true;
+    }
+
+    // Fallback: prefer listening socket whose SO_INCOMING_CPU matches CPU of received packet.
+    for (size_t i = 0; i < _shards.size(); i++)
+    {
+        int cpu = cpus[i];
+        if (setsockopt(_shards[i]->_serverSocket, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == -1)
+        {
+            // Sockets that are already set prefer no CPU again.
+            cpu = -1;
+            for (size_t j = 0; j < i; j++)
+            {
+                setsockopt(_shards[j]->_serverSocket, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu));
+            }
+            errorMessage = "TCPShardedServer error: CPU steering is not supported by kernel.";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ######################################################################
+// TCPWorkerPipeline class:
+
+TCPWorkerPipeline::TCPWorkerPipeline()
+{
+    _server = nullptr;
+    _replies = nullptr;
+    _running = false;
+    _queueCapacity = TCPNetworkLinux_DEFAULT_PIPELINE_QUEUE_SIZE;
+    _acceptNum = 0;
+    _droppedReplies = 0;
+}
+
+TCPWorkerPipeline::~TCPWorkerPipeline()
+{
+    stop();
+}
+
+void TCPWorkerPipeline::setQueueCapacity(size_t capacity)
+{
+    _queueCapacity = std::max<size_t>(capacity, 1);
+}
+
+void TCPWorkerPipeline::setFrameCodec(const TCPFrameCodec &codec)
+{
+    _codec = codec;
+}
+
+bool TCPWorkerPipeline::start(TCPServer &server, size_t workerCount, Handler handler)
+{
+    if (!_workers.empty())
+    {
+        errorMessage = "TCPWorkerPipeline error: Pipeline is already started.";
+        return false;
+    }
+
+    if (!handler)
+    {
+        errorMessage = "TCPWorkerPipeline error: Handler is empty.";
+        return false;
+    }
+
+    if (!server.isEventLoopRunning())
+    {
+        errorMessage = "TCPWorkerPipeline error: Event loop of server is not started.";
+        return false;
+    }
+
+    if (workerCount == 0)
+    {
+        workerCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    errorMessage = "";
+
+    if (!_replyNotifier.open() || !server.setNotifier(&_replyNotifier))
+    {
+        errorMessage = "TCPWorkerPipeline error: Error watching reply notifier. " + server.errorMessage;
+        _replyNotifier.close();
+        return false;
+    }
+
+    _server = &server;
+    _handler = handler;
+    _replies = new TCPMpscQueue<TCPPipelineMessage>(_queueCapacity, &_replyNotifier);
+
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        _Worker* worker = new _Worker();
+        _workers.push_back(worker);
+
+        if (!worker->notifier.open())
+        {
+            errorMessage = "TCPWorkerPipeline error: Worker " + std::to_string(i) + ": " + worker->notifier.errorMessage;
+            stop();
+            return false;
+        }
+        worker->queue = new TCPSpscQueue<TCPPipelineMessage>(_queueCapacity, &worker->notifier);
+    }
+
+    _running = true;
+
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        _workers[i]->thread = std::thread(&TCPWorkerPipeline::_runWorker, this, i);
+    }
+
+    return true;
+}
+
+int32_t TCPWorkerPipeline::run(int timeoutMs)
+{
+    if (_server == nullptr)
+    {
+        errorMessage = "TCPWorkerPipeline error: Pipeline is not started.";
+        return -1;
+    }
+
+    // Workers do not notify when their queue has space, so stalled connections are polled.
+    if ( !_stalled.empty() && ((timeoutMs < 0) || (timeoutMs > 1)) )
+    {
+        timeoutMs = 1;
+    }
+
+    int32_t eventNum = _server->runEventLoop(timeoutMs);
+    if (eventNum < 0)
+    {
+        errorMessage = _server->errorMessage;
+        return -1;
+    }
+
+    for (TCPConnection* connection : _server->getAcceptedConnections())
+    {
+        size_t socket = (size_t)connection->getSocket();
+        if (socket >= _generations.size())
+        {
+            _generations.resize(socket + 1, 0);
+        }
+        _generations[socket] = ++_acceptNum;
+    }
+
+    // Stalled frames are older than frames of this iteration, but both wait in the same RX buffer, so order is kept.
+    std::vector<std::pair<int, uint64_t>> stalled;
+    stalled.swap(_stalled);
+
+    for (const std::pair<int, uint64_t> &entry : stalled)
+    {
+        TCPConnection* connection = _findConnection(entry.first, entry.second);
+        if (connection != nullptr)
+        {
+            _dispatch(connection);
+        }
+    }
+
+    for (TCPConnection* connection : _server->getReadyConnections())
+    {
+        _dispatch(connection);
+    }
+
+    _sendReplies();
+
+    return eventNum;
+}
+
+bool TCPWorkerPipeline::reply(TCPPipelineMessage &&message)
+{
+    return (_replies != nullptr) && _replies->push(std::move(message));
+}
+
+void TCPWorkerPipeline::stop(void)
+{
+    _running = false;
+
+    for (_Worker* worker : _workers)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->notifier.notify();
+            worker->thread.join();
+        }
+        delete worker->queue;
+        delete worker;
+    }
+    _workers.clear();
+
+    if (_server != nullptr)
+    {
+        _server->setNotifier(nullptr);
+        _server = nullptr;
+    }
+
+    delete _replies;
+    _replies = nullptr;
+    _replyNotifier.close();
+
+    _generations.clear();
+    _stalled.clear();
+    _pendingReplies.clear();
+}
+
+bool TCPWorkerPipeline::isRunning(void)
+{
+    return _running;
+}
+
+size_t TCPWorkerPipeline::getWorkerCount(void)
+{
+    return _workers.size();
+}
+
+uint64_t TCPWorkerPipeline::getDroppedReplies(void)
+{
+    return _droppedReplies;
+}
+
+void TCPWorkerPipeline::_runWorker(size_t index)
+{
+    _Worker* worker = _workers[index];
+    TCPPipelineMessage message;
+
+    while (_running.load(std::memory_order_relaxed))
+    {
+        if (worker->queue->pop(message))
+        {
+            _handler(*this, index, message);
+            continue;
+        }
+
+        // Queue is drained. The I/O thread notifies when it goes non empty and stop() notifies too.
+        worker->notifier.wait(-1);
+    }
+}
+
+bool TCPWorkerPipeline::_dispatch(TCPConnection* connection)
+{
+    int socket = connection->getSocket();
+    uint64_t generation = ((size_t)socket < _generations.size()) ? _generations[socket] : 0;
+    _Worker* worker = _workers[(size_t)socket % _workers.size()];
+    std::string_view frame;
+
+    while (true)
+    {
+        ssize_t frameBytes = _codec.decode(connection, frame);
+        if (frameBytes == 0)
+        {
+            return true;
+        }
+
+        if (frameBytes < 0)
+        {
+            errorMessage = "TCPWorkerPipeline error: " + _codec.errorMessage;
+            _server->closeConnection(socket);
+            return true;
+        }
+
+        TCPPipelineMessage message;
+        message.socket = socket;
+        message.generation = generation;
+        message.payload.assign(frame.data(), frame.size());
+
+        if (!worker->queue->push(std::move(message)))
+        {
+            // Frames stay in RX buffer until worker has space.
+            std::pair<int, uint64_t> entry(socket, generation);
+            if (std::find(_stalled.begin(), _stalled.end(), entry) == _stalled.end())
+            {
+                _stalled.push_back(entry);
+            }
+            return false;
+        }
+
+        connection->consumeRxBuffer(frameBytes);
+    }
+}
+
+TCPConnection* TCPWorkerPipeline::_findConnection(int socket, uint64_t generation)
+{
+    uint64_t current = ((size_t)socket < _generations.size()) ? _generations[socket] : 0;
+    if (current != generation)
+    {
+        return nullptr;
+    }
+
+    TCPConnection* connection = _server->getConnection(socket);
+    if ( (connection == nullptr) || !connection->isConnected() )
+    {
+        return nullptr;
+    }
+
+    return connection;
+}
+
+void TCPWorkerPipeline::_sendReplies(void)
+{
+    TCPPipelineMessage message;
+    while (_replies->pop(message))
+    {
+        _pendingReplies.push_back(std::move(message));
+    }
+
+    if (_pendingReplies.empty())
+    {
+        return;
+    }
+
+    // Group replies by connection. Stable sort keeps order of replies of one connection.
+    std::stable_sort(_pendingReplies.begin(), _pendingReplies.end(), [](const TCPPipelineMessage &a, const TCPPipelineMessage &b)
+    {
+        return (a.socket < b.socket) || ((a.socket == b.socket) && (a.generation < b.generation));
+    });
+
+    size_t keptNum = 0;
+    size_t first = 0;
+
+    while (first < _pendingReplies.size())
+    {
+        size_t last = first + 1;
+        while ( (last < _pendingReplies.size()) && (_pendingReplies[last].socket == _pendingReplies[first].socket) &&
+                (_pendingReplies[last].generation == _pendingReplies[first].generation) )
+        {
+            last++;
+        }
+
+        TCPConnection* connection = _findConnection(_pendingReplies[first].socket, _pendingReplies[first].generation);
+        bool kept = false;
+
+        if (connection != nullptr)
+        {
+            _frames.clear();
+            for (size_t i = first; i < last; i++)
+            {
+                _frames.push_back({(void*)_pendingReplies[i].payload.data(), _pendingReplies[i].payload.size()});
+            }
+
+            // All replies of the connection are encoded in one pass and sent by one write.
+            if (!_codec.write(connection, _frames.data(), _frames.size()))
+            {
+                // Backpressure refused the batch. It is sent again after TX queue drains.
+                kept = connection->isConnected() && connection->isTxBlocked();
+                if (!kept)
+                {
+                    errorMessage = "TCPWorkerPipeline error: " + _codec.errorMessage;
+                }
+            }
+        }
+
+        if (kept)
+        {
+            for (size_t i = first; i < last; i++)
+            {
+                if (keptNum != i)
+                {
+                    _pendingReplies[keptNum] = std::move(_pendingReplies[i]);
+                }
+                keptNum++;
+            }
+        }
+        else if (connection == nullptr || !connection->isConnected())
+        {
+            _droppedReplies += last - first;
+        }
+
+        first = last;
+    }
+
+    _pendingReplies.resize(keptNum);
+}
+
+// ##########################################################################################
+// TCPClient class:
+
+bool TCPClient::start(int port, const char* ip)
+{
+    _port = port;
+    _ip = ip;
+    _unix = false;
+
+    // Define the server address
+    struct sockaddr_in serverAddress;
+    memset(&serverAddress, 0, sizeof(serverAddress));
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_port = htons(port);
+
+    if (inet_pton(AF_INET, ip, &serverAddress.sin_addr) <= 0) {
+        errorMessage = "Invalid address or address not supported";
+        return false;
+    }
+
+    return _connect((struct sockaddr*)&serverAddress, sizeof(serverAddress));
+}
+
+bool TCPClient::startByPath(const char* path)
+{
+    _port = 0;
+    _ip = path;
+    _unix = true;
+
+    struct sockaddr_un serverAddress;
+    socklen_t addressLength = TCPNetworkLinuxNamespace::makeUnixAddress(path, serverAddress);
+    if (addressLength == 0)
+    {
+        errorMessage = "Invalid unix socket path.";
+        return false;
+    }
+
+    return _connect((struct sockaddr*)&serverAddress, addressLength);
+}
+
+bool TCPClient::_connect(const struct sockaddr* address, socklen_t addressLength)
+{
+    // Create a socket
+    clientSocket = socket(address->sa_family, SOCK_STREAM, 0);
+    if (clientSocket == -1) 
+    {
+        errorMessage = "Error creating socket.";
+        return false;
+    }
+
+    // Set socket to non-blocking
+    int flags = fcntl(clientSocket, F_GETFL, 0);
+    if (flags == -1) 
+    {
+        errorMessage = "Error getting socket flags.";
+        handleClientDisconnection();
+        return false;
+    }
+
+    if (fcntl(clientSocket, F_SETFL, flags | O_NONBLOCK) == -1) 
+    {
+        errorMessage = "Error setting socket to non-blocking.";
+        handleClientDisconnection();
+        return false;
+    }
+
+    // Buffer sizes are set before connect, so window scaling uses them. Failures are not fatal.
+    std::string failedOptions;
+    if (!TCPNetworkLinuxNamespace::applySocketOptions(clientSocket, _socketOptions, failedOptions, !_unix))
+    {
+        errorMessage = "Error setting socket options: " + failedOptions;
+    }
+
+    _connectDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(_connectTimeout, 0));
+
+    // Connect to the server (non-blocking). Handshake is completed by updateConnect() or waitConnect().
+    // Unix domain connect does not return EINPROGRESS. EAGAIN means backlog of server is full.
+    if (connect(clientSocket, address, addressLength) == -1) 
+    {
+        if (errno != EINPROGRESS) 
+        {
+            errorMessage = std::string("Connect failed: ") + strerror(errno);
+            handleClientDisconnection();
+            _connectState = TCPConnectState::Failed;
+            return false;
+        }
+
+        _connectState = TCPConnectState::Connecting;
+        return true;
+    }
+
+    _connectState = TCPConnectState::Connected;
+    return true;
+}
+
+bool TCPClient::update(char *txBuffer, int txSize, char *rxBuffer, int rxSize)
+{
+    if (updateConnect() != TCPConnectState::Connected)
+    {
+        // Nothing to do until handshake is completed.
+        return _connectState == TCPConnectState::Connecting;
+    }
+
+    if (txBuffer && txSize > 0) 
+    {
+        bytesSent = send(clientSocket, txBuffer, txSize, 0);
+        if (bytesSent == -1) 
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) 
+            {
+                errorMessage = "Send failed.";
+                handleClientDisconnection();
+                return false;
+            }
+        } 
+        else 
+        {
+            // std::cout << "Message sent to server." << std::endl;
+        }
+    }
+
+    if (rxBuffer && rxSize > 0) 
+    {
+        // Receive the echoed message (non-blocking)
+        bytesRead = recv(clientSocket, rxBuffer, rxSize, 0);
+        if (bytesRead == -1) 
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) 
+            {
+                errorMessage = "Receive failed.";
+                handleClientDisconnection();
+                return false;
+            }
+        } 
+        else if (bytesRead == 0) 
+        {
+            errorMessage = "Server disconnected.";
+            handleClientDisconnection();
+            return false;
+        } 
+        else 
+        {
+            // receive successed.
+        }
+    }
+    
+    return true;
+}
+
+int32_t TCPClient::read(char *rxBuffer, size_t rxSize)
+{
+    if (updateConnect() != TCPConnectState::Connected)
+    {
+        return (_connectState == TCPConnectState::Connecting) ? 0 : -1;
+    }
+
+    if (_unix)
+    {
+        struct iovec segment = {rxBuffer, rxSize};
+        bytesRead = TCPNetworkLinuxNamespace::receiveFileDescriptors(clientSocket, &segment, 1, _rxFileDescriptors);
+    }
+    else
+    {
+        bytesRead = recv(clientSocket, rxBuffer, rxSize, MSG_DONTWAIT);
+    }
+
+    if (bytesRead == -1)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        {
+            return 0;
+        }
+
+        errorMessage = "Receive failed.";
+        handleClientDisconnection();
+        return -1;
+    }
+
+    if ( (bytesRead == 0) && (rxSize > 0) )
+    {
+        errorMessage = "Server disconnected.";
+        handleClientDisconnection();
+        return -1;
+    }
+
+    return (int32_t)bytesRead;
+}
+
+void TCPClient::handleClientDisconnection(void) 
+{
+    if (clientSocket != -1)
+    {
+        close(clientSocket);
+    }
+    clientSocket = -1;
+    _txBuffer.clear();
+    _connectState = TCPConnectState::Disconnected;
+
+    for (int fileDescriptor : _rxFileDescriptors)
+    {
+        close(fileDescriptor);
+    }
+    _rxFileDescriptors.clear();
+}
+
+void TCPClient::clientClose(void)
+{
+    handleClientDisconnection();
+}
+
+void TCPClient::printError(void)
+{
+    printf("%s\n",errorMessage.c_str());
+}
+
+bool TCPClient::isClientConnected(void)
+{
+    return updateConnect() == TCPConnectState::Connected;
+}
+
+void TCPClient::setConnectTimeout(int timeoutMs)
+{
+    _connectTimeout = timeoutMs;
+}
+
+TCPConnectState TCPClient::getConnectState(void)
+{
+    return _connectState;
+}
+
+TCPConnectState TCPClient::updateConnect(int timeoutMs)
+{
+    if (_connectState != TCPConnectState::Connecting)
+    {
+        return _connectState;
+    }
+
+    int remainingTime = connectRemainingTime();
+    if ( (timeoutMs < 0) || ((remainingTime >= 0) && (remainingTime < timeoutMs)) )
+    {
+        timeoutMs = remainingTime;
+    }
+
+    struct pollfd pollSocket = {clientSocket, POLLOUT, 0};
+    int result = poll(&pollSocket, 1, timeoutMs);
+
+    if ( (result == -1) && (errno != EINTR) )
+    {
+        errorMessage = "Poll error.";
+        handleClientDisconnection();
+        _connectState = TCPConnectState::Failed;
+        return _connectState;
+    }
+
+    if (result > 0)
+    {
+        completeConnect();
+    }
+    else if (connectRemainingTime() == 0)
+    {
+        errorMessage = "Connection timeout.";
+        handleClientDisconnection();
+        _connectState = TCPConnectState::Failed;
+    }
+
+    return _connectState;
+}
+
+int32_t TCPClient::waitConnect(TCPClient* const* clients, size_t count, int timeoutMs)
+{
+    std::vector<struct pollfd> pollSockets;
+    std::vector<TCPClient*> connecting;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (clients[i]->_connectState != TCPConnectState::Connecting)
+        {
+            continue;
+        }
+
+        int remainingTime = clients[i]->connectRemainingTime();
+        if ( (remainingTime >= 0) && ((timeoutMs < 0) || (remainingTime < timeoutMs)) )
+        {
+            timeoutMs = remainingTime;
+        }
+
+        pollSockets.push_back({clients[i]->clientSocket, POLLOUT, 0});
+        connecting.push_back(clients[i]);
+    }
+
+    if (connecting.empty())
+    {
+        return 0;
+    }
+
+    int result = poll(pollSockets.data(), pollSockets.size(), timeoutMs);
+
+    if ( (result == -1) && (errno != EINTR) )
+    {
+        return -1;
+    }
+
+    int32_t connectingNum = 0;
+
+    for (size_t i = 0; i < connecting.size(); i++)
+    {
+        if ((result > 0) && (pollSockets[i].revents != 0))
+        {
+            connecting[i]->completeConnect();
+        }
+        else if (connecting[i]->connectRemainingTime() == 0)
+        {
+            connecting[i]->errorMessage = "Connection timeout.";
+            connecting[i]->handleClientDisconnection();
+            connecting[i]->_connectState = TCPConnectState::Failed;
+        }
+
+        connectingNum += (connecting[i]->_connectState == TCPConnectState::Connecting);
+    }
+
+    return connectingNum;
+}
+
+int32_t TCPClient::waitReadable(int timeoutMs)
+{
+    return _wait(TCPNetworkLinux_WAIT_READABLE, timeoutMs);
+}
+
+int32_t TCPClient::waitWritable(int timeoutMs)
+{
+    return _wait(TCPNetworkLinux_WAIT_WRITABLE, timeoutMs);
+}
+
+int32_t TCPClient::waitAny(int timeoutMs)
+{
+    return _wait(TCPNetworkLinux_WAIT_ANY, timeoutMs);
+}
+
+int32_t TCPClient::_wait(uint32_t events, int timeoutMs)
+{
+    struct pollfd pollSocket;
+
+    int count = _pollPrepare(events, &pollSocket, timeoutMs);
+    if (count <= 0)
+    {
+        return -1;
+    }
+
+    int result = poll(&pollSocket, count, timeoutMs);
+    if ( (result == -1) && (errno != EINTR) )
+    {
+        errorMessage = "Poll error.";
+        return -1;
+    }
+
+    // Completion also runs on timeout, so connect deadline is checked.
+    if (result == -1)
+    {
+        pollSocket.revents = 0;
+    }
+
+    return _pollComplete(events, &pollSocket, count);
+}
+
+int TCPClient::_pollPrepare(uint32_t events, struct pollfd* pollSockets, int &timeoutMs)
+{
+    if (clientSocket == -1)
+    {
+        errorMessage = "Client is not connected.";
+        return -1;
+    }
+
+    short pollEvents = 0;
+
+    if (_connectState == TCPConnectState::Connecting)
+    {
+        // Socket becomes writable when handshake is completed or failed.
+        pollEvents = POLLOUT;
+
+        int remainingTime = connectRemainingTime();
+        if ( (remainingTime >= 0) && ((timeoutMs < 0) || (remainingTime < timeoutMs)) )
+        {
+            timeoutMs = remainingTime;
+        }
+    }
+    else
+    {
+        if (events & TCPNetworkLinux_WAIT_READABLE)
+        {
+            pollEvents |= POLLIN | POLLRDHUP;
+        }
+
+        if ( (events & TCPNetworkLinux_WAIT_WRITABLE) || ((events & TCPNetworkLinux_WAIT_PENDING_TX) && !_txBuffer.empty()) )
+        {
+            pollEvents |= POLLOUT;
+        }
+    }
+
+    pollSockets[0] = {clientSocket, pollEvents, 0};
+
+    return 1;
+}
+
+uint32_t TCPClient::_pollComplete(uint32_t events, const struct pollfd* pollSockets, int count)
+{
+    short revents = (count > 0) ? pollSockets[0].revents : 0;
+    uint32_t readyEvents = 0;
+
+    if (_connectState == TCPConnectState::Connecting)
+    {
+        if (revents != 0)
+        {
+            completeConnect();
+        }
+        else if (connectRemainingTime() == 0)
+        {
+            errorMessage = "Connection timeout.";
+            handleClientDisconnection();
+            _connectState = TCPConnectState::Failed;
+        }
+
+        if (_connectState == TCPConnectState::Connecting)
+        {
+            return 0;
+        }
+
+        readyEvents |= TCPNetworkLinux_WAIT_CONNECT;
+
+        if (_connectState == TCPConnectState::Failed)
+        {
+            return readyEvents;
+        }
+
+        // Writability of completed connect is reported only if it is requested.
+        if ( !(events & TCPNetworkLinux_WAIT_WRITABLE) && !((events & TCPNetworkLinux_WAIT_PENDING_TX) && !_txBuffer.empty()) )
+        {
+            revents &= ~POLLOUT;
+        }
+    }
+
+    // Errors and hang up are reported as requested events, so next read() or write() observes them.
+    if (revents & (POLLERR | POLLHUP | POLLNVAL))
+    {
+        revents |= pollSockets[0].events;
+    }
+
+    if (revents & (POLLIN | POLLRDHUP))
+    {
+        readyEvents |= TCPNetworkLinux_WAIT_READABLE;
+    }
+
+    if (revents & POLLOUT)
+    {
+        readyEvents |= TCPNetworkLinux_WAIT_WRITABLE;
+    }
+
+    return readyEvents;
+}
+
+void TCPClient::setSocketOptions(const TCPSocketOptions &options)
+{
+    _socketOptions = options;
+}
+
+TCPSocketOptions TCPClient::getAppliedSocketOptions(void)
+{
+    return TCPNetworkLinuxNamespace::getSocketOptions(clientSocket);
+}
+
+int TCPClient::connectRemainingTime(void)
+{
+    if (_connectTimeout < 0)
+    {
+        return -1;
+    }
+
+    auto remainingTime = std::chrono::duration_cast<std::chrono::milliseconds>(_connectDeadline - std::chrono::steady_clock::now());
+
+    return (int)std::max<int64_t>(remainingTime.count(), 0);
+}
+
+void TCPClient::completeConnect(void)
+{
+    int socketError = 0;
+    socklen_t length = sizeof(socketError);
+
+    if (getsockopt(clientSocket, SOL_SOCKET, SO_ERROR, &socketError, &length) == -1)
+    {
+        socketError = errno;
+    }
+
+    if (socketError != 0)
+    {
+        errorMessage = std::string("Connect failed: ") + strerror(socketError);
+        handleClientDisconnection();
+        _connectState = TCPConnectState::Failed;
+        return;
+    }
+
+    _connectState = TCPConnectState::Connected;
+}
+
+std::string TCPClient::getVersion(void)
+{
+    return TCPNetworkLinux_version;
+}
+
+void TCPClient::pushBackTxBuffer(const char* data, size_t size)
+{
+    _txBuffer.append(data, size);
+}
+
+bool TCPClient::write(void)
+{
+    return write(nullptr, 0);
+}
+
+bool TCPClient::write(const struct iovec* buffers, size_t count)
+{
+    if ( (clientSocket == -1) || (_connectState == TCPConnectState::Failed) )
+    {
+        errorMessage = "Client is not connected.";
+        return false;
+    }
+
+    if (updateConnect() == TCPConnectState::Connecting)
+    {
+        // Queue data until handshake is completed.
+        size_t totalBytes = _txBuffer.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            totalBytes += buffers[i].iov_len;
+        }
+        if (!_txBuffer.reserve(totalBytes))
+        {
+            errorMessage = "Memory budget is exceeded.";
+            return false;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            _txBuffer.append((const char*)buffers[i].iov_base, buffers[i].iov_len);
+        }
+        return true;
+    }
+
+    if (_connectState != TCPConnectState::Connected)
+    {
+        return false;
+    }
+
+    if (_txBuffer.sendTo(clientSocket, buffers, count) == -1)
+    {
+        errorMessage = (errno == ENOMEM) ? "Memory budget is exceeded." : "Send failed.";
+        handleClientDisconnection();
+        return false;
+    }
+
+    return true;
+}
+
+bool TCPClient::sendFileDescriptors(const int* fileDescriptors, size_t count, const char* data, size_t size)
+{
+    if (!_unix || (updateConnect() != TCPConnectState::Connected))
+    {
+        errorMessage = "Descriptors can be sent only on connected unix domain client.";
+        return false;
+    }
+
+    if (!_txBuffer.empty() && !write())
+    {
+        return false;
+    }
+
+    // Descriptors can not be queued in TX buffer, so they are sent only behind fully sent data.
+    if (!_txBuffer.empty())
+    {
+        errorMessage = "TX buffer is not empty. Descriptors are not sent.";
+        return false;
+    }
+
+    ssize_t bytesWrite = TCPNetworkLinuxNamespace::sendFileDescriptors(clientSocket, data, size, fileDescriptors, count);
+
+    if (bytesWrite == -1)
+    {
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+        {
+            errorMessage = "Socket is full. Descriptors are not sent.";
+            return false;
+        }
+
+        errorMessage = "Send failed.";
+        if (errno != EINVAL)
+        {
+            handleClientDisconnection();
+        }
+        return false;
+    }
+
+    if ((size_t)bytesWrite < size)
+    {
+        if (!_txBuffer.append(data + bytesWrite, size - bytesWrite))
+        {
+            errorMessage = "Memory budget is exceeded.";
+            handleClientDisconnection();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int TCPClient::popFileDescriptor(void)
+{
+    if (_rxFileDescriptors.empty())
+    {
+        return -1;
+    }
+
+    int fileDescriptor = _rxFileDescriptors.front();
+    _rxFileDescriptors.erase(_rxFileDescriptors.begin());
+
+    return fileDescriptor;
+}
+
+size_t TCPClient::getTxQueuedBytes(void)
+{
+    return _txBuffer.size();
+}
+
+// ##########################################################################################
+// TCPWaitSet class:
+
+void TCPWaitSet::add(TCPServer* server, uint32_t events)
+{
+    _Member* member = _find(server, nullptr);
+    if (member != nullptr)
+    {
+        member->events = events;
+        return;
+    }
+
+    _members.push_back({server, nullptr, events, 0, 0, 0});
+}
+
+void TCPWaitSet::add(TCPClient* client, uint32_t events)
+{
+    _Member* member = _find(nullptr, client);
+    if (member != nullptr)
+    {
+        member->events = events;
+        return;
+    }
+
+    _members.push_back({nullptr, client, events, 0, 0, 0});
+}
+
+void TCPWaitSet::remove(TCPServer* server)
+{
+    _Member* member = _find(server, nullptr);
+    if (member != nullptr)
+    {
+        _members.erase(_members.begin() + (member - _members.data()));
+    }
+}
+
+void TCPWaitSet::remove(TCPClient* client)
+{
+    _Member* member = _find(nullptr, client);
+    if (member != nullptr)
+    {
+        _members.erase(_members.begin() + (member - _members.data()));
+    }
+}
+
+void TCPWaitSet::clear(void)
+{
+    _members.clear();
+}
+
+size_t TCPWaitSet::size(void)
+{
+    return _members.size();
+}
+
+int32_t TCPWaitSet::wait(int timeoutMs)
+{
+    _pollSockets.clear();
+
+    for (_Member &member : _members)
+    {
+        struct pollfd pollSockets[2];
+        int count;
+
+        member.readyEvents = 0;
+        member.pollIndex = _pollSockets.size();
+
+        if (member.server != nullptr)
+        {
+            count = member.server->_pollPrepare(member.events, pollSockets, timeoutMs);
+        }
+        else if (member.client->clientSocket != -1)
+        {
+            count = member.client->_pollPrepare(member.events, pollSockets, timeoutMs);
+        }
+        else
+        {
+            count = 0;
+        }
+
+        if (count == -1)
+        {
+            errorMessage = "TCPWaitSet error: " + ((member.server != nullptr) ? member.server->errorMessage : member.client->errorMessage);
+            return -1;
+        }
+
+        member.pollCount = count;
+        _pollSockets.insert(_pollSockets.end(), pollSockets, pollSockets + count);
+    }
+
+    if (_pollSockets.empty())
+    {
+        errorMessage = "TCPWaitSet error: No socket to wait for.";
+        return -1;
+    }
+
+    int result = poll(_pollSockets.data(), _pollSockets.size(), timeoutMs);
+    if ( (result == -1) && (errno != EINTR) )
+    {
+        errorMessage = "TCPWaitSet error: poll failed.";
+        return -1;
+    }
+
+    int32_t readyNum = 0;
+
+    for (_Member &member : _members)
+    {
+        if (member.pollCount == 0)
+        {
+            continue;
+        }
+
+        struct pollfd* pollSockets = &_pollSockets[member.pollIndex];
+
+        if (result == -1)
+        {
+            pollSockets->revents = 0;
+        }
+
+        // Completion runs on timeout too, so connect deadlines of clients and io_uring work of servers are checked.
+        if (member.server != nullptr)
+        {
+            member.readyEvents = member.server->_pollComplete(member.events, pollSockets, member.pollCount);
+        }
+        else
+        {
+            member.readyEvents = member.client->_pollComplete(member.events, pollSockets, member.pollCount);
+        }
+
+        readyNum += (member.readyEvents != 0);
+    }
+
+    return readyNum;
+}
+
+uint32_t TCPWaitSet::getReadyEvents(TCPServer* server)
+{
+    _Member* member = _find(server, nullptr);
+    return (member != nullptr) ? member->readyEvents : 0;
+}
+
+uint32_t TCPWaitSet::getReadyEvents(TCPClient* client)
+{
+    _Member* member = _find(nullptr, client);
+    return (member != nullptr) ? member->readyEvents : 0;
+}
+
+TCPWaitSet::_Member* TCPWaitSet::_find(const TCPServer* server, const TCPClient* client)
+{
+    for (_Member &member : _members)
+    {
+        if ( (member.server == server) && (member.client == client) )
+        {
+            return &member;
+        }
+    }
+
+    return nullptr;
+}
+
+
+// ##########################################################################################
+// TCPClientPool class:
+
+TCPClientPool::TCPClientPool()
+{
+    _port = 0;
+    _unix = false;
+    _connectTimeout = TCPNetworkLinux_DEFAULT_CONNECT_TIMEOUT;
+    _reconnectInterval = TCPNetworkLinux_DEFAULT_RECONNECT_INTERVAL;
+    _rxBufferSize = TCPNetworkLinux_DEFAULT_POOL_RX_SIZE;
+    _cursor = 0;
+    _reconnectCount = 0;
+}
+
+TCPClientPool::~TCPClientPool()
+{
+    close();
+}
+
+bool TCPClientPool::start(int port, const char* ip, size_t connectionCount)
+{
+    struct in_addr address;
+    if (inet_pton(AF_INET, ip, &address) <= 0)
+    {
+        errorMessage = "TCPClientPool error: Invalid IP address/ Address not supported";
+        return false;
+    }
+
+    _port = port;
+    _address = ip;
+    _unix = false;
+
+    return _start(connectionCount);
+}
+
+bool TCPClientPool::startByPath(const char* path, size_t connectionCount)
+{
+    struct sockaddr_un address;
+    if (TCPNetworkLinuxNamespace::makeUnixAddress(path, address) == 0)
+    {
+        errorMessage = "TCPClientPool error: Invalid unix socket path.";
+        return false;
+    }
+
+    _port = 0;
+    _address = path;
+    _unix = true;
+
+    return _start(connectionCount);
+}
+
+bool TCPClientPool::_start(size_t connectionCount)
+{
+    if (!_members.empty())
+    {
+        errorMessage = "TCPClientPool error: Pool is already started.";
+        return false;
+    }
+
+    if (connectionCount == 0)
+    {
+        errorMessage = "TCPClientPool error: Number of connections is zero.";
+        return false;
+    }
+
+    errorMessage = "";
+
+    for (size_t i = 0; i < connectionCount; i++)
+    {
+        _Member* member = new _Member();
+        member->rxBuffer.reserve(_rxBufferSize);
+        member->outstandingRequests = 0;
+        member->events = 0;
+        _members.push_back(member);
+    }
+    _pollSockets.resize(connectionCount);
+
+    // All connects are started before any of them is waited for.
+    for (size_t i = 0; i < connectionCount; i++)
+    {
+        _open(i);
+    }
+
+    return true;
+}
+
+void TCPClientPool::close(void)
+{
+    for (_Member* member : _members)
+    {
+        delete member;
+    }
+    _members.clear();
+    _pollSockets.clear();
+
+    _cursor = 0;
+    _reconnectCount = 0;
+}
+
+void TCPClientPool::setSocketOptions(const TCPSocketOptions &options)
+{
+    _socketOptions = options;
+}
+
+void TCPClientPool::setConnectTimeout(int timeoutMs)
+{
+    _connectTimeout = timeoutMs;
+}
+
+void TCPClientPool::setReconnectInterval(int intervalMs)
+{
+    _reconnectInterval = std::max(intervalMs, 0);
+}
+
+void TCPClientPool::setRxBufferSize(size_t size)
+{
+    _rxBufferSize = std::max<size_t>(size, 1);
+
+    for (_Member* member : _members)
+    {
+        member->rxBuffer.reserve(_rxBufferSize);
+    }
+}
+
+int32_t TCPClientPool::update(int timeoutMs)
+{
+    if (_members.empty())
+    {
+        errorMessage = "TCPClientPool error: Pool is not started.";
+        return -1;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < _members.size(); i++)
+    {
+        _Member* member = _members[i];
+
+        if ( (member->client.clientSocket == -1) && (now >= member->retryTime) )
+        {
+            _open(i);
+            _reconnectCount++;
+        }
+
+        if (member->client.clientSocket == -1)
+        {
+            // Wake up when failed connection is opened again. poll() skips negative descriptors.
+            int retryTime = (int)std::chrono::duration_cast<std::chrono::milliseconds>(member->retryTime - now).count() + 1;
+            if ( (timeoutMs < 0) || (retryTime < timeoutMs) )
+            {
+                timeoutMs = retryTime;
+            }
+
+            _pollSockets[i] = {-1, 0, 0};
+            continue;
+        }
+
+        // Connection with full RX buffer is not read until its data is consumed.
+        member->events = TCPNetworkLinux_WAIT_PENDING_TX;
+        if (member->rxBuffer.size() < _rxBufferSize)
+        {
+            member->events |= TCPNetworkLinux_WAIT_READABLE;
+        }
+
+        member->client._pollPrepare(member->events, &_pollSockets[i], timeoutMs);
+    }
+
+    int result = poll(_pollSockets.data(), _pollSockets.size(), timeoutMs);
+    if ( (result == -1) && (errno != EINTR) )
+    {
+        errorMessage = std::string("TCPClientPool error: poll failed: ") + strerror(errno);
+        return -1;
+    }
+
+    int32_t readyNum = 0;
+
+    for (size_t i = 0; i < _members.size(); i++)
+    {
+        _Member* member = _members[i];
+
+        if (_pollSockets[i].fd == -1)
+        {
+            continue;
+        }
+
+        if (result == -1)
+        {
+            _pollSockets[i].revents = 0;
+        }
+
+        // Completion runs on timeout too, so connect deadlines are checked.
+        uint32_t readyEvents = member->client._pollComplete(member->events, &_pollSockets[i], 1);
+
+        if (readyEvents & TCPNetworkLinux_WAIT_WRITABLE)
+        {
+            member->client.write();
+        }
+
+        if (readyEvents & TCPNetworkLinux_WAIT_READABLE)
+        {
+            readyNum += (_receive(member) > 0);
+        }
+
+        if (member->client.clientSocket == -1)
+        {
+            _fail(i);
+        }
+    }
+
+    return readyNum;
+}
+
+int32_t TCPClientPool::waitConnected(int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeoutMs, 0));
+
+    while (true)
+    {
+        int waitTime = -1;
+        if (timeoutMs >= 0)
+        {
+            auto remainingTime = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            waitTime = (int)std::max<int64_t>(remainingTime.count(), 0);
+        }
+
+        if (update(waitTime) == -1)
+        {
+            return -1;
+        }
+
+        size_t connectedNum = getConnectedCount();
+        if ( (connectedNum == _members.size()) || ((timeoutMs >= 0) && (std::chrono::steady_clock::now() >= deadline)) )
+        {
+            return (int32_t)connectedNum;
+        }
+    }
+}
+
+int32_t TCPClientPool::select(void)
+{
+    size_t count = _members.size();
+    int32_t selected = -1;
+
+    for (size_t n = 0; n < count; n++)
+    {
+        size_t i = (_cursor + n) % count;
+        _Member* member = _members[i];
+
+        if (member->client._connectState != TCPConnectState::Connected)
+        {
+            continue;
+        }
+
+        if (selected == -1)
+        {
+            selected = (int32_t)i;
+            continue;
+        }
+
+        _Member* best = _members[selected];
+        if ( (member->outstandingRequests < best->outstandingRequests) ||
+             ((member->outstandingRequests == best->outstandingRequests) && (member->client._txBuffer.size() < best->client._txBuffer.size())) )
+        {
+            selected = (int32_t)i;
+        }
+    }
+
+    if (count > 0)
+    {
+        _cursor = (_cursor + 1) % count;
+    }
 
-TCPServer::TCPServer()
-{
-    _rxBufferSize = TCPNetworkLinux_DEFAULT_RX_SIZE;
-    _txBufferSize = TCPNetworkLinux_DEFAULT_TX_SIZE;
-    _serverSocket = -1;
-    _clientSocket = -1;
+    return selected;
 }
 
-bool TCPServer::startByIP(const uint16_t port, const char* ip)
+int32_t TCPClientPool::send(const char* data, size_t size)
 {
-    _port = port;
-    _ip = ip;
+    // A failed connection is not connected anymore, so every attempt selects another connection.
+    for (size_t attempt = 0; attempt < _members.size(); attempt++)
+    {
+        int32_t index = select();
+        if (index == -1)
+        {
+            break;
+        }
 
-    // Server configuration. socket() Returns a file descriptor for the new socket, or -1 for errors.
-    _serverSocket = socket(AF_INET, SOCK_STREAM, 0);
-    if (_serverSocket == -1) 
+        if (send((size_t)index, data, size))
+        {
+            return index;
+        }
+    }
+
+    errorMessage = "TCPClientPool error: No connection is connected.";
+    return -1;
+}
+
+bool TCPClientPool::send(size_t index, const char* data, size_t size)
+{
+    if (index >= _members.size())
     {
-        errorMessage = "TCPServer error: Error creating server socket: ";
+        errorMessage = "TCPClientPool error: Invalid connection index.";
         return false;
     }
 
-    // Set SO_REUSEADDR option
-    int opt = 1;
-    if (setsockopt(_serverSocket, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt)) == -1) 
+    _Member* member = _members[index];
+    bool open = (member->client.clientSocket != -1);
+    struct iovec buffer = {(void*)data, size};
+
+    if (!member->client.write(&buffer, 1))
     {
-        errorMessage = "TCPServer error: Error setting socket options.";
-        _handleServerDisconnection();
+        if (open && (member->client.clientSocket == -1))
+        {
+            _fail(index);
+        }
+        else
+        {
+            errorMessage = "TCPClientPool error: Connection " + std::to_string(index) + ": " + member->client.errorMessage;
+        }
         return false;
     }
 
-    // Set the server socket to non-blocking mode
-    int flags = fcntl(_serverSocket, F_GETFL, 0);
-    if (flags == -1) 
+    member->outstandingRequests++;
+    return true;
+}
+
+std::string_view TCPClientPool::getRxData(size_t index)
+{
+    if (index >= _members.size())
     {
-        errorMessage = "TCPServer error: Error getting socket flags for setting socket to non-blockings.";
-        _handleServerDisconnection();
+        return std::string_view();
+    }
+
+    return _members[index]->rxBuffer.linearize();
+}
+
+void TCPClientPool::consume(size_t index, size_t size, size_t completedRequests)
+{
+    if (index >= _members.size())
+    {
+        return;
+    }
+
+    _Member* member = _members[index];
+    member->rxBuffer.discard(std::min(size, member->rxBuffer.size()));
+    member->outstandingRequests -= std::min(completedRequests, member->outstandingRequests);
+}
+
+size_t TCPClientPool::getOutstandingRequests(size_t index)
+{
+    return (index < _members.size()) ? _members[index]->outstandingRequests : 0;
+}
+
+size_t TCPClientPool::getOutstandingBytes(size_t index)
+{
+    return (index < _members.size()) ? _members[index]->client._txBuffer.size() : 0;
+}
+
+TCPConnectState TCPClientPool::getConnectState(size_t index)
+{
+    return (index < _members.size()) ? _members[index]->client._connectState : TCPConnectState::Disconnected;
+}
+
+TCPClient* TCPClientPool::getClient(size_t index)
+{
+    return (index < _members.size()) ? &_members[index]->client : nullptr;
+}
+
+size_t TCPClientPool::getConnectionCount(void)
+{
+    return _members.size();
+}
+
+size_t TCPClientPool::getConnectedCount(void)
+{
+    size_t connectedNum = 0;
+
+    for (_Member* member : _members)
+    {
+        connectedNum += (member->client._connectState == TCPConnectState::Connected);
+    }
+
+    return connectedNum;
+}
+
+size_t TCPClientPool::getReconnectCount(void)
+{
+    return _reconnectCount;
+}
+
+void TCPClientPool::_open(size_t index)
+{
+    _Member* member = _members[index];
+
+    // Data of previous stream is not valid on a new stream.
+    member->rxBuffer.clear();
+    member->outstandingRequests = 0;
+
+    member->client.setSocketOptions(_socketOptions);
+    member->client.setConnectTimeout(_connectTimeout);
+
+    bool started = _unix ? member->client.startByPath(_address.c_str()) : member->client.start(_port, _address.c_str());
+    if (!started)
+    {
+        _fail(index);
+    }
+}
+
+size_t TCPClientPool::_receive(_Member* member)
+{
+    size_t receivedBytes = 0;
+
+    while (member->rxBuffer.size() < _rxBufferSize)
+    {
+        struct iovec segment = member->rxBuffer.writable();
+        size_t size = std::min(segment.iov_len, _rxBufferSize - member->rxBuffer.size());
+
+        int32_t bytesRead = member->client.read((char*)segment.iov_base, size);
+        if (bytesRead <= 0)
+        {
+            break;
+        }
+
+        member->rxBuffer.commit(bytesRead);
+        receivedBytes += bytesRead;
+
+        // Short read means socket is drained.
+        if ((size_t)bytesRead < size)
+        {
+            break;
+        }
+    }
+
+    return receivedBytes;
+}
+
+void TCPClientPool::_fail(size_t index)
+{
+    _Member* member = _members[index];
+
+    // Requests of a failed stream are lost. Received data stays until the connection is opened again.
+    errorMessage = "TCPClientPool error: Connection " + std::to_string(index) + ": " + member->client.errorMessage;
+    member->outstandingRequests = 0;
+    member->retryTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(_reconnectInterval);
+}
+
+#if TCPNetworkLinux_COROUTINES
+
+// ##########################################################################################
+// TCPFramePool class:
+
+// Free lists of coroutine frames of one thread. Index of list is size class.
+struct TCPNetworkLinux_FrameCache
+{
+    struct Node
+    {
+        Node* next;
+    };
+
+    Node* lists[TCPNetworkLinux_FRAME_POOL_MAX_SIZE / TCPNetworkLinux_FRAME_POOL_ALIGN] = {};
+    size_t heapAllocations = 0;
+    size_t cachedFrames = 0;
+
+    ~TCPNetworkLinux_FrameCache()
+    {
+        TCPFramePool::release();
+    }
+};
+
+static thread_local TCPNetworkLinux_FrameCache TCPNetworkLinux_frameCache;
+
+void* TCPFramePool::allocate(size_t size)
+{
+    TCPNetworkLinux_FrameCache &cache = TCPNetworkLinux_frameCache;
+
+    if ( (size == 0) || (size > TCPNetworkLinux_FRAME_POOL_MAX_SIZE) )
+    {
+        cache.heapAllocations++;
+        return ::operator new(size);
+    }
+
+    size_t index = (size - 1) / TCPNetworkLinux_FRAME_POOL_ALIGN;
+    TCPNetworkLinux_FrameCache::Node* node = cache.lists[index];
+    if (node != nullptr)
+    {
+        cache.lists[index] = node->next;
+        cache.cachedFrames--;
+        return node;
+    }
+
+    // Frames of the same size class are interchangeable, so memory is allocated with full class size.
+    cache.heapAllocations++;
+    return ::operator new((index + 1) * TCPNetworkLinux_FRAME_POOL_ALIGN);
+}
+
+void TCPFramePool::deallocate(void* pointer, size_t size) noexcept
+{
+    if ( (size == 0) || (size > TCPNetworkLinux_FRAME_POOL_MAX_SIZE) )
+    {
+        ::operator delete(pointer);
+        return;
+    }
+
+    TCPNetworkLinux_FrameCache &cache = TCPNetworkLinux_frameCache;
+    size_t index = (size - 1) / TCPNetworkLinux_FRAME_POOL_ALIGN;
+
+    TCPNetworkLinux_FrameCache::Node* node = static_cast<TCPNetworkLinux_FrameCache::Node*>(pointer);
+    node->next = cache.lists[index];
+    cache.lists[index] = node;
+    cache.cachedFrames++;
+}
+
+size_t TCPFramePool::getHeapAllocations(void)
+{
+    return TCPNetworkLinux_frameCache.heapAllocations;
+}
+
+size_t TCPFramePool::getCachedFrames(void)
+{
+    return TCPNetworkLinux_frameCache.cachedFrames;
+}
+
+void TCPFramePool::release(void)
+{
+    TCPNetworkLinux_FrameCache &cache = TCPNetworkLinux_frameCache;
+
+    for (TCPNetworkLinux_FrameCache::Node* &list : cache.lists)
+    {
+        while (list != nullptr)
+        {
+            TCPNetworkLinux_FrameCache::Node* next = list->next;
+            ::operator delete(list);
+            list = next;
+        }
+    }
+
+    cache.cachedFrames = 0;
+}
+
+// ##########################################################################################
+// TCPTask class:
+
+TCPTask TCPTask::promise_type::get_return_object(void) noexcept
+{
+    return TCPTask(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+TCPTask::~TCPTask()
+{
+    if (_handle != nullptr)
+    {
+        _handle.destroy();
+    }
+}
+
+TCPTask::TCPTask(TCPTask &&other) noexcept : _handle(other._handle)
+{
+    other._handle = nullptr;
+}
+
+TCPTask& TCPTask::operator=(TCPTask &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (_handle != nullptr)
+        {
+            _handle.destroy();
+        }
+
+        _handle = other._handle;
+        other._handle = nullptr;
+    }
+
+    return *this;
+}
+
+bool TCPTask::isDone(void)
+{
+    return (_handle == nullptr) || _handle.done();
+}
+
+std::coroutine_handle<> TCPTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+{
+    // Symmetric transfer: the task runs now and resumes awaiter by its final awaiter without stack growth.
+    _handle.promise()._continuation = awaiter;
+    return _handle;
+}
+
+void TCPTask::await_resume(void)
+{
+    if ( (_handle != nullptr) && _handle.promise()._exception )
+    {
+        std::rethrow_exception(_handle.promise()._exception);
+    }
+}
+
+std::coroutine_handle<> TCPTask::_FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+{
+    promise_type &promise = handle.promise();
+
+    if (promise._scheduler != nullptr)
+    {
+        // Nobody awaits a spawned task, so its exception can not be delivered.
+        if (promise._exception)
+        {
+            std::terminate();
+        }
+
+        promise._scheduler->_finishTask(&promise);
+        handle.destroy();
+        return std::noop_coroutine();
+    }
+
+    if (promise._continuation)
+    {
+        return promise._continuation;
+    }
+
+    return std::noop_coroutine();
+}
+
+// ##########################################################################################
+// TCPAsyncOperation class:
+
+TCPAsyncOperation::TCPAsyncOperation(_Type type, TCPScheduler* scheduler, int socket, std::string* errorMessage, char* data, size_t size)
+{
+    _type = type;
+    _scheduler = scheduler;
+    _socket = socket;
+    _errorMessage = errorMessage;
+    _data = data;
+    _size = size;
+    _done = 0;
+    _result = -1;
+    _handle = nullptr;
+    _pending = false;
+}
+
+TCPAsyncOperation::~TCPAsyncOperation()
+{
+    if (_pending)
+    {
+        _scheduler->_unwatch(this);
+    }
+}
+
+bool TCPAsyncOperation::await_suspend(std::coroutine_handle<> handle)
+{
+    if (_socket == -1)
+    {
+        _fail("Socket is not open.", 0);
         return false;
     }
 
-    if (fcntl(_serverSocket, F_SETFL, flags | O_NONBLOCK) == -1) 
+    // Completed without blocking. The coroutine continues without a trip through the scheduler.
+    if (_attempt())
     {
-        errorMessage = "TCPServer error: Error setting socket to non-blocking.";
-        _handleServerDisconnection();
         return false;
     }
 
-    // Define the server address structure
-    struct sockaddr_in serverAddress;
-    serverAddress.sin_family = AF_INET;     // This ensures that the socket will use the Internet Protocol (IPv4)
-    serverAddress.sin_port = htons(port);   // Change port here
+    _handle = handle;
 
-    // specify a particular IP address rather than binding to any available network interface.
-    // Convert IP address from text to binary form
-    if (inet_pton(AF_INET, ip, &serverAddress.sin_addr) <= 0) 
+    if (!_scheduler->_watch(this))
     {
-        errorMessage = "TCPServer error: Invalid IP address/ Address not supported";
-        _handleServerDisconnection();
+        _fail("Another operation of same direction is pending on the socket", EBUSY);
         return false;
     }
 
-    // Zero out the rest of the struct
-    memset(&(serverAddress.sin_zero), 0, sizeof(serverAddress.sin_zero));
+    return true;
+}
+
+bool TCPAsyncOperation::_attempt(void)
+{
+    ssize_t bytes;
+
+    switch (_type)
+    {
+        case _Type::ReadSome:
+            while (true)
+            {
+                bytes = recv(_socket, _data, _size, 0);
+                if (bytes >= 0)
+                {
+                    _result = bytes;
+                    return true;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    return false;
+                }
+                if (errno != EINTR)
+                {
+                    _fail("Receive failed", errno);
+                    return true;
+                }
+            }
+
+        case _Type::ReadExact:
+            while (_done < _size)
+            {
+                size_t requested = _size - _done;
+                bytes = recv(_socket, _data + _done, requested, 0);
+                if (bytes > 0)
+                {
+                    _done += bytes;
+
+                    // Short read means the socket is drained. The socket stays in epoll, so next data raises a new edge.
+                    if ( ((size_t)bytes < requested) )
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+                if (bytes == 0)
+                {
+                    if (_done == 0)
+                    {
+                        _result = 0;
+                        return true;
+                    }
+                    _fail("Peer closed before all data received.", 0);
+                    return true;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    return false;
+                }
+                if (errno != EINTR)
+                {
+                    _fail("Receive failed", errno);
+                    return true;
+                }
+            }
+            _result = _size;
+            return true;
+
+        case _Type::WriteAll:
+            while (_done < _size)
+            {
+                bytes = send(_socket, _data + _done, _size - _done, MSG_NOSIGNAL);
+                if (bytes >= 0)
+                {
+                    _done += bytes;
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    return false;
+                }
+                if (errno != EINTR)
+                {
+                    _fail("Send failed", errno);
+                    return true;
+                }
+            }
+            _result = _size;
+            return true;
+
+        case _Type::Accept:
+            while (true)
+            {
+                int socket = accept4(_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (socket >= 0)
+                {
+                    _result = socket;
+                    return true;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    return false;
+                }
+                // Connection aborted before accept. Try next pending connection.
+                if ( (errno != EINTR) && (errno != ECONNABORTED) )
+                {
+                    _fail("Accept failed", errno);
+                    return true;
+                }
+            }
+
+        case _Type::Connect:
+        {
+            // Called only after socket is writable or failed. SO_ERROR has the result of handshake.
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (getsockopt(_socket, SOL_SOCKET, SO_ERROR, &error, &length) == -1)
+            {
+                error = errno;
+            }
 
-    // Bind the socket to the network address and port
-    if (bind(_serverSocket, (struct sockaddr*)&serverAddress, sizeof(serverAddress)) == -1) 
-    {
-        errorMessage = "TCPServer error: Bind failed.";
-        _handleServerDisconnection();
-        return false;
-    }
+            if (error != 0)
+            {
+                _fail("Connect failed", error);
+                return true;
+            }
 
-    /*
-    MAX_CONNECTIONS defines the maximum length of the queue of pending connections. 
-    When a client attempts to connect to the server, if the server is not ready to accept the connection immediately, 
-    the connection request will be placed in a queue. MAX_CONNECTIONS specifies the maximum number of connections that 
-    can be queued at any one time.
-    */
-    int MAX_CONNECTIONS = 10;
-    // Listen for incoming connections
-    if (listen(_serverSocket, MAX_CONNECTIONS) == -1) {
-        errorMessage = "TCPServer error: Listen failed.";
-        _handleServerDisconnection();
-        return false;
+            _result = 0;
+            return true;
+        }
     }
 
     return true;
 }
 
-bool TCPServer::startByName(const uint16_t port, const char* InterfaceName)
+void TCPAsyncOperation::_fail(const char* text, int error)
 {
-    _ip = TCPNetworkLinuxNamespace::getIPAddressByInterface(InterfaceName);
+    _result = -1;
 
-    if(_ip == "")
+    *_errorMessage = (_type == _Type::Accept) ? "TCPAsyncListener error: " : "TCPAsyncConnection error: ";
+    *_errorMessage += text;
+    if (error != 0)
     {
-        errorMessage = "TCPServer error: Invalid interface ethernet name.";
-        return false;
+        *_errorMessage += std::string(": ") + strerror(error);
     }
+}
 
-    return startByIP(port, _ip.c_str());
+TCPAcceptOperation::TCPAcceptOperation(TCPScheduler* scheduler, int socket, std::string* errorMessage, const TCPSocketOptions* socketOptions, bool unixSocket) :
+    TCPAsyncOperation(_Type::Accept, scheduler, socket, errorMessage, nullptr, 0)
+{
+    _socketOptions = socketOptions;
+    _unix = unixSocket;
 }
 
-bool TCPServer::_clientConfig(void)
+TCPAsyncConnection TCPAcceptOperation::await_resume(void)
 {
-    // Accept incoming connection
-    struct sockaddr_in clientAddress;
-    socklen_t clientAddressLength = sizeof(clientAddress);
-    
-    _clientSocket = accept(_serverSocket, (struct sockaddr*)&clientAddress, &clientAddressLength);
-    if (_clientSocket == -1) 
+    if (_result < 0)
     {
-        if (errno == EWOULDBLOCK || errno == EAGAIN) 
-        {
-            // No pending connections; this is expected in non-blocking mode
-        } 
-        else 
-        {
-            errorMessage = "TCPServer error: Accept client failed";
-        }
-        return false;
+        return TCPAsyncConnection(*_scheduler);
     }
 
-    return true;
+    return TCPAsyncConnection(*_scheduler, (int)_result, *_socketOptions, _unix, *_errorMessage);
 }
 
-void TCPServer::_handleClientDisconnection(void) 
+TCPConnectOperation::TCPConnectOperation(TCPAsyncConnection* connection, const struct sockaddr* address, socklen_t addressLength, int timeoutMs) :
+    TCPAsyncOperation(_Type::Connect, connection->_scheduler, connection->_socket, &connection->errorMessage, nullptr, 0)
 {
-    close(_clientSocket);
-    _clientSocket = -1;
-}
+    _connection = connection;
+    _timeoutMs = timeoutMs;
+    _addressLength = 0;
 
-void TCPServer::_handleServerDisconnection(void) 
-{
-    _handleClientDisconnection();
-    close(_serverSocket);  
-    _serverSocket = -1;
+    if (address != nullptr)
+    {
+        memcpy(&_address, address, addressLength);
+        _addressLength = addressLength;
+    }
 }
 
-bool TCPServer::readWrite(char *txBuffer, size_t txSize, char *rxBuffer, size_t rxSize)
+bool TCPConnectOperation::await_suspend(std::coroutine_handle<> handle)
 {
-    int bytesRead = read(rxBuffer, rxSize);
-    if( bytesRead == -1)
+    // Socket was not created. errorMessage is set by connect().
+    if (_socket == -1)
     {
+        _result = -1;
         return false;
     }
 
-    if(!write(*txBuffer, txSize))
+    // Socket is added to epoll after connect, since a socket that is not connected reports hang up.
+    // EINTR means handshake continues in background like EINPROGRESS.
+    if (::connect(_socket, (struct sockaddr*)&_address, _addressLength) == -1)
     {
-        return false;
+        if ( (errno != EINPROGRESS) && (errno != EINTR) )
+        {
+            _fail("Connect failed", errno);
+            return false;
+        }
+
+        if (!_scheduler->_addSocket(_socket, *_errorMessage))
+        {
+            _result = -1;
+            return false;
+        }
+
+        _handle = handle;
+        _scheduler->_watch(this);
+
+        if (_timeoutMs > 0)
+        {
+            _timer.setCallback(&TCPConnectOperation::_onTimeout, this);
+            _scheduler->_timers.arm(_timer, _timeoutMs);
+        }
+        return true;
     }
 
-    return true;     
+    _result = _scheduler->_addSocket(_socket, *_errorMessage) ? 0 : -1;
+    return false;
 }
 
-int32_t TCPServer::read(char *rxBuffer, const size_t &rxSize)
+bool TCPConnectOperation::await_resume(void)
 {
-    if(rxSize == 0)
+    _timer.cancel();
+
+    if (_result != 0)
     {
-        errorMessage = "TCPServer error: rxSize is zero value.";
-        #if(TCPNetworkLinux_DEBUG == 1)
-                    std::cout << errorMessage << std::endl;
-        #endif
-        return -1;
+        _connection->close();
+        return false;
     }
-        
-    // Number of bytes read from the socket.
-    int32_t bytesRead = 0; 
-       
-    bytesRead = recv(_clientSocket, rxBuffer, rxSize, 0);
-    
-    if (bytesRead <= 0)
+
+    return true;
+}
+
+void TCPConnectOperation::_onTimeout(TCPTimer &timer, void* context)
+{
+    (void)timer;
+    TCPConnectOperation* operation = (TCPConnectOperation*)context;
+
+    if (!operation->_pending)
     {
-        if (bytesRead == 0) 
-        {
-            // // Client disconnected
-            // errorMessage = "TCPServer error: Error Client disconnected.";
-            // _handleClientDisconnection();
-            // return 0;
-        } 
-        else if (bytesRead == -1) 
-        {
-            if (errno != EWOULDBLOCK && errno != EAGAIN) 
-            {
-                errorMessage = "TCPServer error: Error receiving message.";
-                _handleClientDisconnection();
-                #if(TCPNetworkLinux_DEBUG == 1)
-                    std::cout << errorMessage << std::endl;
-                #endif
-                return -1;
-            } 
-            return -1;
-        }
+        return;
     }
 
-    if (bytesRead > (int64_t)rxSize)
+    operation->_scheduler->_unwatch(operation);
+    operation->_fail("Connect timed out", ETIMEDOUT);
+    operation->_scheduler->_readyList.push_back(operation->_handle);
+}
+
+// ##########################################################################################
+// TCPScheduler class:
+
+TCPScheduler::TCPScheduler()
+{
+    _tasks = nullptr;
+    _taskCount = 0;
+    _stopped = false;
+    _closing = false;
+
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll == -1)
     {
-        // Receive proccess was not successed.
-        errorMessage = "TCPServer error: Error receiving message. bytesRead is more than rxSize";
-        #if(TCPNetworkLinux_DEBUG == 1)
-                std::cout << errorMessage << std::endl;
-        #endif
-        return 0;
+        errorMessage = std::string("TCPScheduler error: Error creating epoll instance: ") + strerror(errno);
     }
-        
-    return bytesRead;     
 }
 
-int32_t TCPServer::read(std::string *data)
+TCPScheduler::~TCPScheduler()
 {
-    int32_t bytesRead = available();
+    _closing = true;
 
-    if(bytesRead <= 0)
+    // Destroying a frame destroys its connections, pending operations and awaited sub tasks.
+    while (_tasks != nullptr)
     {
-        return bytesRead;
+        TCPTask::promise_type* task = _tasks;
+        _finishTask(task);
+        std::coroutine_handle<TCPTask::promise_type>::from_promise(*task).destroy();
     }
-    
-    char buffer[bytesRead];
 
-    if((size_t)bytesRead > _rxBufferSize)
+    _readyList.clear();
+
+    if (_epoll != -1)
     {
-        bytesRead = _rxBufferSize;
+        close(_epoll);
     }
-    bytesRead = read(buffer, bytesRead);
+}
 
-    if(bytesRead > 0)
+void TCPScheduler::spawn(TCPTask task)
+{
+    if (task._handle == nullptr)
     {
-        data->assign(buffer, bytesRead);
+        return;
     }
-    
-    return bytesRead;
+
+    TCPTask::promise_type &promise = task._handle.promise();
+    promise._scheduler = this;
+    promise._previous = nullptr;
+    promise._next = _tasks;
+    if (_tasks != nullptr)
+    {
+        _tasks->_previous = &promise;
+    }
+    _tasks = &promise;
+    _taskCount++;
+
+    _readyList.push_back(task._handle);
+    task._handle = nullptr;
 }
 
-int32_t TCPServer::read(void)
+bool TCPScheduler::run(void)
 {
-    std::string data;
-
-    int32_t bytesRead = read(&data);    
+    _stopped = false;
 
-    if(bytesRead > 0)
+    while (!_stopped && (_taskCount > 0))
     {
-        pushBackRxBuffer(data.c_str(), data.size());
+        if (runOnce(-1) < 0)
+        {
+            return false;
+        }
     }
-    
-    return bytesRead;
+
+    return true;
 }
 
-bool TCPServer::write(const char &txBuffer, const size_t &txSize)
+int32_t TCPScheduler::runOnce(int timeoutMs)
 {
-    // Number of bytes write to the socket.
-    int bytesWrite; 
+    if (_epoll == -1)
+    {
+        errorMessage = "TCPScheduler error: Epoll instance is not created.";
+        return -1;
+    }
 
-    if (_clientSocket == -1)  // No client connected
-    { 
-        if (_clientConfig()) 
-        {
-            // Set the client socket to non-blocking mode
-            int clientFlags = fcntl(_clientSocket, F_GETFL, 0);
-            if (clientFlags == -1) 
-            {
-                errorMessage = "TCPServer error: Error getting client socket flags.";
-                _handleClientDisconnection();
-                return false;
-            }
+    struct epoll_event events[TCPNetworkLinux_MAX_EVENTS];
 
-            if (fcntl(_clientSocket, F_SETFL, clientFlags | O_NONBLOCK) == -1) 
-            {
-                errorMessage = "TCPServer error: Error setting client socket to non-blocking.";
-                _handleClientDisconnection();
-                return false;
-            }
+    // Ready tasks do not wait. Otherwise wake up for next timer expiry.
+    int waitMs = _readyList.empty() ? _timers.getTimeout(timeoutMs) : 0;
+
+    int eventNum = epoll_wait(_epoll, events, TCPNetworkLinux_MAX_EVENTS, waitMs);
+    if (eventNum == -1)
+    {
+        if (errno != EINTR)
+        {
+            errorMessage = std::string("TCPScheduler error: epoll_wait failed: ") + strerror(errno);
+            return -1;
         }
+        eventNum = 0;
     }
-    else   // Client is connected
-    { 
-        struct pollfd pfd;
-        pfd.fd = _clientSocket;
-        pfd.events = POLLOUT | POLLHUP;
 
-        int pollRes = poll(&pfd, 1, 0);
+    for (int i = 0; i < eventNum; i++)
+    {
+        size_t socket = (size_t)events[i].data.fd;
+        uint32_t flags = events[i].events;
 
-        if (pollRes == -1) 
+        if (socket >= _watches.size())
         {
-            errorMessage = "TCPServer error: Poll error.";
-            _handleClientDisconnection();
-            return false;
+            continue;
         }
 
-        if (pfd.revents & POLLHUP) 
+        _Watch &watch = _watches[socket];
+
+        if ( (watch.read != nullptr) && (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && watch.read->_attempt() )
         {
-            errorMessage = "TCPServer error: Client disconnected.";
-            _handleClientDisconnection();
-            return false;
+            watch.read->_pending = false;
+            _readyList.push_back(watch.read->_handle);
+            watch.read = nullptr;
         }
 
-        if (pfd.revents & POLLOUT) 
+        if ( (watch.write != nullptr) && (flags & (EPOLLOUT | EPOLLHUP | EPOLLERR)) && watch.write->_attempt() )
         {
-            bytesWrite = send(_clientSocket, &txBuffer, txSize, 0);
-
-            if (bytesWrite == -1) 
-            {
-                if (errno != EWOULDBLOCK && errno != EAGAIN) {
-                    errorMessage = "TCPServer error: Error sending message.";
-                    _handleClientDisconnection();
-                    return false;
-                }
-            } 
-            else if (bytesWrite < (int)txSize) 
-            {
-                errorMessage = "TCPServer error: Partial write. Not all data was sent.";
-                return false;
-                // Handle partial send if needed
-                // Optionally, implement logic to retry sending the remaining data
-            }
+            watch.write->_pending = false;
+            _readyList.push_back(watch.write->_handle);
+            watch.write = nullptr;
         }
-    } 
+    }
 
-    return true;     
+    // Expired timers queue their coroutines.
+    _timers.advance();
+
+    // Coroutines that become ready while resuming are queued in _readyList for next iteration.
+    _runList.swap(_readyList);
+
+    for (std::coroutine_handle<> handle : _runList)
+    {
+        handle.resume();
+    }
+
+    int32_t resumedNum = (int32_t)_runList.size();
+    _runList.clear();
+
+    return resumedNum;
 }
 
-bool TCPServer::write(const std::string &txBuffer)
+void TCPScheduler::stop(void)
 {
-    const char *data = txBuffer.c_str();
+    _stopped = true;
+}
 
-    return write(*data, txBuffer.size());
+size_t TCPScheduler::getTaskCount(void)
+{
+    return _taskCount;
 }
 
-bool TCPServer::write(void)
+TCPTimerWheel& TCPScheduler::getTimerWheel(void)
+{
+    return _timers;
+}
+
+void TCPScheduler::_SleepAwaiter::await_suspend(std::coroutine_handle<> awaiter)
+{
+    handle = awaiter;
+    timer.setCallback(&_SleepAwaiter::_onTimer, this);
+    scheduler->_timers.arm(timer, delayMs);
+}
+
+void TCPScheduler::_SleepAwaiter::_onTimer(TCPTimer &timer, void* context)
 {
-    std::string data(_txBuffer.begin(), _txBuffer.begin() + _txBuffer.size());
-    if(!write(data))
+    (void)timer;
+    _SleepAwaiter* awaiter = (_SleepAwaiter*)context;
+    awaiter->scheduler->_readyList.push_back(awaiter->handle);
+}
+
+bool TCPScheduler::_addSocket(int socket, std::string &errorMessage)
+{
+    // Socket stays registered for both directions, so events are not missed between operations.
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = socket;
+
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, socket, &event) == -1)
     {
+        errorMessage = std::string("TCPScheduler error: Error adding socket to epoll: ") + strerror(errno);
         return false;
     }
-    _txBuffer.clear();
+
+    if ((size_t)socket >= _watches.size())
+    {
+        _watches.resize(socket + 1, {nullptr, nullptr});
+    }
+
+    _watches[socket] = {nullptr, nullptr};
 
     return true;
 }
 
-void TCPServer::printError(void)
+void TCPScheduler::_removeSocket(int socket)
 {
-    printf("%s\n",errorMessage.c_str());
-}
+    if ( (socket < 0) || ((size_t)socket >= _watches.size()) )
+    {
+        return;
+    }
 
-std::string TCPServer::getError(void)
-{
-    return errorMessage;
+    _Watch &watch = _watches[socket];
+    TCPAsyncOperation* operations[2] = {watch.read, watch.write};
+    watch = {nullptr, nullptr};
+
+    if (_closing)
+    {
+        return;
+    }
+
+    for (TCPAsyncOperation* operation : operations)
+    {
+        if (operation != nullptr)
+        {
+            operation->_pending = false;
+            operation->_fail("Socket is closed", ECANCELED);
+            _readyList.push_back(operation->_handle);
+        }
+    }
 }
 
-bool TCPServer::isListening(void)
+bool TCPScheduler::_watch(TCPAsyncOperation* operation)
 {
-    if(_serverSocket == -1)
+    bool read = (operation->_type == TCPAsyncOperation::_Type::ReadSome) ||
+                (operation->_type == TCPAsyncOperation::_Type::ReadExact) ||
+                (operation->_type == TCPAsyncOperation::_Type::Accept);
+
+    TCPAsyncOperation* &slot = read ? _watches[operation->_socket].read : _watches[operation->_socket].write;
+    if (slot != nullptr)
+    {
         return false;
+    }
+
+    slot = operation;
+    operation->_pending = true;
 
     return true;
 }
 
-bool TCPServer::isClientConnected(void)
+void TCPScheduler::_unwatch(TCPAsyncOperation* operation)
+{
+    _Watch &watch = _watches[operation->_socket];
+
+    if (watch.read == operation)
+    {
+        watch.read = nullptr;
+    }
+    if (watch.write == operation)
+    {
+        watch.write = nullptr;
+    }
+
+    operation->_pending = false;
+}
+
+void TCPScheduler::_finishTask(TCPTask::promise_type* task)
 {
-    // Check if the socket is valid
-    if (_clientSocket == -1) 
+    if (task->_previous != nullptr)
     {
-        return false; // No client connected
+        task->_previous->_next = task->_next;
     }
-
-    // recv() with MSG_PEEK:
-    // Allows you to check if the client has disconnected without actually consuming any data from the socket buffer.
-    // If recv() returns 0, it means the client has disconnected.
-    // If recv() returns a negative value and errno is set to ECONNRESET or EPIPE, it means there’s been an error like the connection being reset by the client.
-
-    // Use recv to check if the client has disconnected
-    char buffer[1];
-    ssize_t recvRes = recv(_clientSocket, buffer, sizeof(buffer), MSG_PEEK);
-    if (recvRes == 0) 
+    else
     {
-        // Client disconnected
-        errorMessage = "Client disconnected.";
-        _handleClientDisconnection();
-        #if (TCPNetworkLinux_DEBUG == 1)
-            std::cout << errorMessage << std::endl;
-        #endif
-        return false;
+        _tasks = task->_next;
     }
-    else if (recvRes < 0) 
+
+    if (task->_next != nullptr)
     {
-        // Error occurred during recv
-        if (errno == ECONNRESET || errno == EPIPE) 
-        {
-            errorMessage = "TCPServer error: Connection reset by peer.";
-            _handleClientDisconnection();
-            #if (TCPNetworkLinux_DEBUG == 1)
-                std::cout << errorMessage << std::endl;
-            #endif
-            return false;
-        }
+        task->_next->_previous = task->_previous;
     }
 
-    // Connection is still alive
-    return true;  
+    task->_previous = nullptr;
+    task->_next = nullptr;
+    _taskCount--;
 }
 
-bool TCPServer::checkLinkStatus(const char* port_name)
+// ##########################################################################################
+// TCPAsyncConnection class:
+
+TCPAsyncConnection::TCPAsyncConnection(TCPScheduler &scheduler)
 {
-    std::string carrierPath = std::string("/sys/class/net/") + port_name + "/carrier";
-    std::ifstream carrierFile(carrierPath);
-    if (!carrierFile.is_open()) {
-        errorMessage = "Error opening carrier file for interface: eno1";
-        return false;
+    _scheduler = &scheduler;
+    _socket = -1;
+    _unix = false;
+}
+
+TCPAsyncConnection::TCPAsyncConnection(TCPScheduler &scheduler, int socket, const TCPSocketOptions &options, bool unixSocket, std::string &listenerErrorMessage)
+{
+    _scheduler = &scheduler;
+    _socket = socket;
+    _unix = unixSocket;
+    _socketOptions = options;
+
+    // Failures of options are not fatal.
+    std::string failedOptions;
+    if (!TCPNetworkLinuxNamespace::applySocketOptions(_socket, _socketOptions, failedOptions, !_unix))
+    {
+        errorMessage = "TCPAsyncConnection error: Error setting socket options: " + failedOptions;
     }
 
-    int status;
-    carrierFile >> status;
-    carrierFile.close();
-    
-    if (status == 1) {
-        return true; // Link is up
-    } else {
-        return false; // Link is down
+    if (!_scheduler->_addSocket(_socket, listenerErrorMessage))
+    {
+        ::close(_socket);
+        _socket = -1;
     }
 }
 
-void TCPServer::serverClose(void)
+TCPAsyncConnection::~TCPAsyncConnection()
 {
-    _handleServerDisconnection();
+    close();
 }
 
-void TCPServer::clientClose(void)
+TCPAsyncConnection::TCPAsyncConnection(TCPAsyncConnection &&other) noexcept
 {
-    _handleClientDisconnection();
+    errorMessage = std::move(other.errorMessage);
+    _scheduler = other._scheduler;
+    _socket = other._socket;
+    _unix = other._unix;
+    _socketOptions = other._socketOptions;
+
+    other._socket = -1;
 }
 
-bool TCPServer::clientConnect(void)
+TCPAsyncConnection& TCPAsyncConnection::operator=(TCPAsyncConnection &&other) noexcept
 {
-    if (!isClientConnected())  
-    { 
-        if (_clientConfig()) 
-        {
-            // Set the client socket to non-blocking mode
-            int clientFlags = fcntl(_clientSocket, F_GETFL, 0);
-            if (clientFlags == -1) 
-            {
-                errorMessage = "TCPServer error: Error getting client socket flags.";
-                _handleClientDisconnection();
-                return false;
-            }
+    if (this != &other)
+    {
+        close();
 
-            if (fcntl(_clientSocket, F_SETFL, clientFlags | O_NONBLOCK) == -1) 
-            {
-                errorMessage = "TCPServer error: Error setting client socket to non-blocking.";
-                _handleClientDisconnection();
-                return false;
-            }
-        }
+        errorMessage = std::move(other.errorMessage);
+        _scheduler = other._scheduler;
+        _socket = other._socket;
+        _unix = other._unix;
+        _socketOptions = other._socketOptions;
+
+        other._socket = -1;
     }
 
-    return true;
+    return *this;
 }
 
-std::string TCPServer::getVersion(void)
+TCPConnectOperation TCPAsyncConnection::connect(uint16_t port, const char* ip, int timeoutMs)
 {
-    return TCPNetworkLinux_version;
-}
+    struct sockaddr_in serverAddress;
+    memset(&serverAddress, 0, sizeof(serverAddress));
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_port = htons(port);
 
-void TCPServer::setTxBufferSize(size_t size)
-{
-    _txBufferSize = size;
-}
+    if (inet_pton(AF_INET, ip, &serverAddress.sin_addr) <= 0)
+    {
+        close();
+        errorMessage = "TCPAsyncConnection error: Invalid IP address/ Address not supported";
+        return TCPConnectOperation(this, nullptr, 0, 0);
+    }
 
-void TCPServer::setRxBufferSize(size_t size)
-{
-    _rxBufferSize = size;
+    return _connect((struct sockaddr*)&serverAddress, sizeof(serverAddress), timeoutMs);
 }
 
-int32_t TCPServer::available(void)
+TCPConnectOperation TCPAsyncConnection::connectByPath(const char* path, int timeoutMs)
 {
-    // Use ioctl to find out how many bytes are available in the receive buffer
-    int32_t bytesAvailable = 0;
-    
-    if( (_serverSocket > 0 ) && (_clientSocket > 0))
-    {   
-        if (ioctl(_clientSocket, FIONREAD, &bytesAvailable) < 0) 
-        {
-            errorMessage = "ioctl failed";
-            #if(TCPNetworkLinux_DEBUG == 1)
-                std::cout << errorMessage << std::endl;
-            #endif
-            return -1;
-        }
+    struct sockaddr_un serverAddress;
+    socklen_t addressLength = TCPNetworkLinuxNamespace::makeUnixAddress(path, serverAddress);
+    if (addressLength == 0)
+    {
+        close();
+        errorMessage = "TCPAsyncConnection error: Invalid unix socket path.";
+        return TCPConnectOperation(this, nullptr, 0, 0);
     }
 
-    return bytesAvailable;
+    return _connect((struct sockaddr*)&serverAddress, addressLength, timeoutMs);
 }
 
-void TCPServer::removeFrontRxBuffer(size_t num)
+TCPConnectOperation TCPAsyncConnection::_connect(const struct sockaddr* address, socklen_t addressLength, int timeoutMs)
 {
-    for(size_t i = 0; i < num ; i++)
+    close();
+
+    _unix = (address->sa_family == AF_UNIX);
+    _socket = socket(address->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (_socket == -1)
     {
-        if(_rxBuffer.empty())
-            return;
+        errorMessage = std::string("TCPAsyncConnection error: Error creating socket: ") + strerror(errno);
+        return TCPConnectOperation(this, nullptr, 0, 0);
+    }
 
-        _rxBuffer.pop_front();
+    // Buffer sizes are set before connect, so window scaling uses them. Failures are not fatal.
+    std::string failedOptions;
+    if (!TCPNetworkLinuxNamespace::applySocketOptions(_socket, _socketOptions, failedOptions, !_unix))
+    {
+        errorMessage = "TCPAsyncConnection error: Error setting socket options: " + failedOptions;
     }
+
+    return TCPConnectOperation(this, address, addressLength, timeoutMs);
 }
 
-void TCPServer::removeFrontTxBuffer(size_t size)
+TCPAsyncOperation TCPAsyncConnection::readSome(char* data, size_t size)
 {
-    for(size_t i = 0; i < size ; i++)
-    {
-        if(_txBuffer.empty())
-            return;
+    return TCPAsyncOperation(TCPAsyncOperation::_Type::ReadSome, _scheduler, _socket, &errorMessage, data, size);
+}
 
-        _txBuffer.pop_front();
-    }
+TCPAsyncOperation TCPAsyncConnection::readExact(char* data, size_t size)
+{
+    return TCPAsyncOperation(TCPAsyncOperation::_Type::ReadExact, _scheduler, _socket, &errorMessage, data, size);
 }
 
-void TCPServer::removeAllRxBuffer(void)
+TCPAsyncOperation TCPAsyncConnection::writeAll(const char* data, size_t size)
 {
-    _rxBuffer.clear();
+    return TCPAsyncOperation(TCPAsyncOperation::_Type::WriteAll, _scheduler, _socket, &errorMessage, const_cast<char*>(data), size);
 }
 
-void TCPServer::removeAllTxBuffer(void)
+TCPAsyncOperation TCPAsyncConnection::writeAll(const std::string &data)
 {
-    _txBuffer.clear();
+    return writeAll(data.data(), data.size());
 }
 
-std::string TCPServer::popFrontRxBuffer(size_t size)
+bool TCPAsyncConnection::setSocketOptions(const TCPSocketOptions &options)
 {
-    std::string data;
+    _socketOptions = options;
 
-    for(size_t i = 0; i < size ; i++)
+    if (_socket == -1)
     {
-        if(_rxBuffer.empty())
-            return data;
+        return true;
+    }
 
-        data.push_back(_rxBuffer.front());
-        _rxBuffer.pop_front();
+    std::string failedOptions;
+    if (!TCPNetworkLinuxNamespace::applySocketOptions(_socket, _socketOptions, failedOptions, !_unix))
+    {
+        errorMessage = "TCPAsyncConnection error: Error setting socket options: " + failedOptions;
+        return false;
     }
 
-    return data;
+    return true;
 }
 
-std::string TCPServer::popAllRxBuffer(void)
+void TCPAsyncConnection::close(void)
 {
-    std::string data(_rxBuffer.begin(), _rxBuffer.end());
-    _rxBuffer.clear();
+    if (_socket == -1)
+    {
+        return;
+    }
 
-    return data;
+    _scheduler->_removeSocket(_socket);
+    ::close(_socket);
+    _socket = -1;
 }
 
-void TCPServer::pushBackRxBuffer(const char* data, size_t size)
+bool TCPAsyncConnection::isOpen(void)
 {
-    // empty space size of rx buffer.
-    int64_t emptySize;
+    return _socket != -1;
+}
 
-    emptySize = (int64_t)(_rxBuffer.size() + size) - (int64_t)_rxBufferSize;
+int TCPAsyncConnection::getSocket(void)
+{
+    return _socket;
+}
 
-    if(emptySize > 0)
-    {
-        removeFrontRxBuffer(emptySize);
-    }
+// ##########################################################################################
+// TCPAsyncListener class:
 
-    // Append the char array to the deque
-    _rxBuffer.insert(_rxBuffer.end(), data, data + size);
+TCPAsyncListener::TCPAsyncListener(TCPScheduler &scheduler)
+{
+    _scheduler = &scheduler;
+    _socket = -1;
+    _unix = false;
 }
 
-void TCPServer::pushBackRxBuffer(const std::string* data)
+TCPAsyncListener::~TCPAsyncListener()
 {
-    pushBackRxBuffer(data->c_str(), data->size());
+    close();
 }
 
-void TCPServer::pushBackTxBuffer(const char* data, size_t size)
+bool TCPAsyncListener::startByIP(uint16_t port, const char* ip)
 {
-    // empty space size of rx buffer.
-    int64_t emptySize;
+    close();
 
-    emptySize = (int64_t)(_txBuffer.size() + size) - (int64_t)_txBufferSize;
+    struct sockaddr_in serverAddress;
+    memset(&serverAddress, 0, sizeof(serverAddress));
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_port = htons(port);
 
-    if(emptySize > 0)
+    if (inet_pton(AF_INET, ip, &serverAddress.sin_addr) <= 0)
     {
-        removeFrontTxBuffer(emptySize);
+        errorMessage = "TCPAsyncListener error: Invalid IP address/ Address not supported";
+        return false;
     }
 
-    // Append the char array to the deque
-    _txBuffer.insert(_txBuffer.end(), data, data + size);
-
-}
-
-void TCPServer::pushBackTxBuffer(const std::string* data)
-{
-    pushBackTxBuffer(data->c_str(), data->size());
+    return _startListening((struct sockaddr*)&serverAddress, sizeof(serverAddress));
 }
 
-// ##########################################################################################
-// TCPClient class:
-
-bool TCPClient::start(int port, const char* ip)
+bool TCPAsyncListener::startByPath(const char* path)
 {
-    _port = port;
-    _ip = ip;
+    close();
 
-    // Create a socket
-    clientSocket = socket(AF_INET, SOCK_STREAM, 0);
-    if (clientSocket == -1) 
+    struct sockaddr_un serverAddress;
+    socklen_t addressLength = TCPNetworkLinuxNamespace::makeUnixAddress(path, serverAddress);
+    if (addressLength == 0)
     {
-        errorMessage = "Error creating socket.";
+        errorMessage = "TCPAsyncListener error: Invalid unix socket path.";
         return false;
     }
 
-    // Set socket to non-blocking
-    int flags = fcntl(clientSocket, F_GETFL, 0);
-    if (flags == -1) 
+    // Socket file of a previous run makes bind fail. Remove it only if it is a socket.
+    struct stat fileStatus;
+    if ( (path[0] != '@') && (lstat(path, &fileStatus) == 0) && S_ISSOCK(fileStatus.st_mode) )
     {
-        errorMessage = "Error getting socket flags.";
-        handleClientDisconnection();
-        return false;
+        unlink(path);
     }
 
-    if (fcntl(clientSocket, F_SETFL, flags | O_NONBLOCK) == -1) 
+    if (!_startListening((struct sockaddr*)&serverAddress, addressLength))
     {
-        errorMessage = "Error setting socket to non-blocking.";
-        handleClientDisconnection();
         return false;
     }
 
-    // Define the server address
-    struct sockaddr_in serverAddress;
-    memset(&serverAddress, 0, sizeof(serverAddress));
-    serverAddress.sin_family = AF_INET;
-    serverAddress.sin_port = htons(port);
-    serverAddress.sin_addr.s_addr = inet_addr(ip);
+    if (path[0] != '@')
+    {
+        _unixPath = path;
+    }
 
-    if (inet_pton(AF_INET, ip, &serverAddress.sin_addr) <= 0) {
-        errorMessage = "Invalid address or address not supported";
-        handleClientDisconnection();
+    return true;
+}
+
+bool TCPAsyncListener::_startListening(const struct sockaddr* address, socklen_t addressLength)
+{
+    _unix = (address->sa_family == AF_UNIX);
+
+    _socket = socket(address->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (_socket == -1)
+    {
+        errorMessage = std::string("TCPAsyncListener error: Error creating socket: ") + strerror(errno);
         return false;
     }
 
-    // Connect to the server (non-blocking)
-    if (connect(clientSocket, (struct sockaddr*)&serverAddress, sizeof(serverAddress)) == -1) 
+    int opt = 1;
+    if ( !_unix && (setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) )
     {
-        if (errno != EINPROGRESS) 
-        {
-            errorMessage = "Connect failed.";
-            handleClientDisconnection();
-            return false;
-        }
+        errorMessage = std::string("TCPAsyncListener error: Error setting socket options: ") + strerror(errno);
+        close();
+        return false;
     }
 
-    // // Wait for the connection to be established (using select or epoll can be more efficient)
-    // fd_set writeSet;
-    // FD_ZERO(&writeSet);
-    // FD_SET(clientSocket, &writeSet);
-
-    // struct timeval timeout;
-    // timeout.tv_sec = 10; // 10 seconds timeout
-    // timeout.tv_usec = 0;
-
-    // int selectResult = select(clientSocket + 1, nullptr, &writeSet, nullptr, &timeout);
-    // if (selectResult == -1) 
-    // {
-    //     errorMessage = "Select error.";
-    //     handleClientDisconnection();
-    //     return false;
-    // } 
-    // else if (selectResult == 0) 
-    // {
-    //     errorMessage = "Connection timeout.";
-    //     handleClientDisconnection();
-    //     return false;
-    // }
+    // Buffer sizes are set before listen, so window scaling of accepted sockets uses them. Failures are not fatal.
+    std::string failedOptions;
+    if (!TCPNetworkLinuxNamespace::applySocketOptions(_socket, _socketOptions, failedOptions, !_unix))
+    {
+        errorMessage = "TCPAsyncListener error: Error setting socket options: " + failedOptions;
+    }
 
-    return true;
-}
+    if (bind(_socket, address, addressLength) == -1)
+    {
+        errorMessage = std::string("TCPAsyncListener error: Bind failed: ") + strerror(errno);
+        close();
+        return false;
+    }
 
-bool TCPClient::update(char *txBuffer, int txSize, char *rxBuffer, int rxSize)
-{
-    if (txBuffer && txSize > 0) 
+    int backlog = (_socketOptions.listenBacklog == -1) ? TCPNetworkLinux_DEFAULT_LISTEN_BACKLOG : _socketOptions.listenBacklog;
+    if (listen(_socket, backlog) == -1)
     {
-        bytesSent = send(clientSocket, txBuffer, txSize, 0);
-        if (bytesSent == -1) 
-        {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) 
-            {
-                errorMessage = "Send failed.";
-                handleClientDisconnection();
-                return false;
-            }
-        } 
-        else 
-        {
-            // std::cout << "Message sent to server." << std::endl;
-        }
+        errorMessage = std::string("TCPAsyncListener error: Listen failed: ") + strerror(errno);
+        close();
+        return false;
     }
 
-    if (rxBuffer && rxSize > 0) 
+    if (!_scheduler->_addSocket(_socket, errorMessage))
     {
-        // Receive the echoed message (non-blocking)
-        bytesRead = recv(clientSocket, rxBuffer, rxSize, 0);
-        if (bytesRead == -1) 
-        {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) 
-            {
-                errorMessage = "Receive failed.";
-                handleClientDisconnection();
-                return false;
-            }
-        } 
-        else if (bytesRead == 0) 
-        {
-            errorMessage = "Server disconnected.";
-            handleClientDisconnection();
-            return false;
-        } 
-        else 
-        {
-            // receive successed.
-        }
+        close();
+        return false;
     }
-    
-    return true;
-}
 
-void TCPClient::handleClientDisconnection(void) 
-{
-    close(clientSocket);
-    clientSocket = -1;
+    return true;
 }
 
-void TCPClient::clientClose(void)
+void TCPAsyncListener::setSocketOptions(const TCPSocketOptions &options)
 {
-    handleClientDisconnection();
+    _socketOptions = options;
 }
 
-void TCPClient::printError(void)
+TCPAcceptOperation TCPAsyncListener::accept(void)
 {
-    printf("%s\n",errorMessage.c_str());
+    return TCPAcceptOperation(_scheduler, _socket, &errorMessage, &_socketOptions, _unix);
 }
 
-bool TCPClient::isClientConnected(void)
+void TCPAsyncListener::close(void)
 {
-    if(clientSocket == -1)
-        return false;
+    if (_socket != -1)
+    {
+        _scheduler->_removeSocket(_socket);
+        ::close(_socket);
+        _socket = -1;
+    }
 
-    return true;
+    // Remove socket file of unix domain listener. Abstract names disappear with the socket.
+    if (!_unixPath.empty())
+    {
+        unlink(_unixPath.c_str());
+        _unixPath.clear();
+    }
 }
 
-std::string TCPClient::getVersion(void)
+bool TCPAsyncListener::isOpen(void)
 {
-    return TCPNetworkLinux_version;
+    return _socket != -1;
 }
 
-
-
-
-
-
+#endif
@@ -19,20 +19,163 @@
 #include <cerrno>               // For error handling.
 #include <sys/socket.h>         // For socket programming.
 #include <netinet/in.h>         // For sockaddr_in structure.
+#include <netinet/tcp.h>        // For TCP level socket options
 #include <arpa/inet.h>          // Include this header for inet_pton. For inet_pton function to convert IP addresses.
 #include <fcntl.h>              // Include this header for fcntl
 #include <poll.h>               // Used to monitor multiple file descriptors
 #include <fstream>
-#include <deque>                // Modern standard library for double-ended queue
 #include <sys/ioctl.h>          // For ioctl
 #include <ifaddrs.h>            // For getifaddrs
 #include <net/if.h>             // For IFF_UP, IFF_RUNNING
+#include <sys/syscall.h>        // For io_uring syscalls
+#include <sys/utsname.h>        // For kernel version check
+#include <sys/resource.h>       // For getrlimit
+#include <sys/epoll.h>          // For epoll event loop
+#include <linux/io_uring.h>     // For io_uring event loop backend
+#include <vector>               // For connection table and event lists
+#include <algorithm>            // For std::min, std::copy
+#include <string_view>          // For zero copy views of buffered data
+#include <sys/uio.h>            // For iovec structure
+#include <climits>              // For IOV_MAX
+#include <sys/mman.h>           // For memfd_create, mmap of mirrored ring buffers
+#include <sys/un.h>             // For unix domain socket address
+#include <sys/stat.h>           // For removal of stale unix socket files
+#include <linux/filter.h>       // For reuseport CPU steering BPF program
+#include <thread>               // For sharded server worker threads
+#include <sched.h>              // For CPUs that sharded server threads may run on
+#include <atomic>               // For sharded server running flag
+#include <chrono>               // For sharded server error back off
+#include <functional>           // For sharded server handler
+#include <deque>                // For frame sizes of lossy TX buffers
+#include <mutex>                // For chunks of TCPBufferPool that are released by other threads
+#include <new>                  // For std::bad_alloc of pooled connection objects
+#include <sys/eventfd.h>        // For wakeups of TCPNotifier
+#include <pthread.h>            // For pthread_setaffinity_np
+#include <linux/netlink.h>      // For link monitor netlink socket
+#include <linux/rtnetlink.h>    // For link and address messages of link monitor
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>          // For SSE2/AVX2 delimiter scan
+#endif
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>            // For coroutine async API
+#include <exception>            // For exceptions of coroutine tasks
+#endif
 
 // ############################################################################################
 // Define Macros:
 
 #define TCPNetworkLinux_DEBUG       0
 
+// Default maximum number of connections handled by the TCPServer event loop.
+#define TCPNetworkLinux_DEFAULT_MAX_CONNECTIONS     1024
+
+// Number of provided receive buffers and size of each buffer for io_uring backend. Number must be power of two.
+#define TCPNetworkLinux_URING_BUFFER_NUM            256
+#define TCPNetworkLinux_URING_BUFFER_SIZE           16384
+
+// Default maximum payload size of TCPFrameCodec frames.
+#define TCPNetworkLinux_DEFAULT_MAX_FRAME_SIZE      1048576
+
+// Default deadline of TCPClient non blocking connect. [ms]
+#define TCPNetworkLinux_DEFAULT_CONNECT_TIMEOUT     10000
+
+// Default wait time before a failed TCPClientPool connection is opened again. [ms]
+#define TCPNetworkLinux_DEFAULT_RECONNECT_INTERVAL  1000
+
+// Default maximum size of RX buffer of every TCPClientPool connection. [bytes]
+#define TCPNetworkLinux_DEFAULT_POOL_RX_SIZE        65536
+
+// Default listen backlog of TCPServer.
+#define TCPNetworkLinux_DEFAULT_LISTEN_BACKLOG      10
+
+// Maximum wait time of one event loop iteration in TCPShardedServer worker threads. [ms]
+#define TCPNetworkLinux_SHARD_LOOP_TIMEOUT          100
+
+// Events of wait functions and TCPWaitSet. They can be combined by bitwise or.
+#define TCPNetworkLinux_WAIT_READABLE               0x01    // Data or disconnection is pending on the socket.
+#define TCPNetworkLinux_WAIT_WRITABLE               0x02    // Socket accepts more data.
+#define TCPNetworkLinux_WAIT_ACCEPT                 0x04    // Connection is pending on the listening socket.
+#define TCPNetworkLinux_WAIT_CONNECT                0x08    // Client connect is completed or failed.
+#define TCPNetworkLinux_WAIT_PENDING_TX             0x10    // Writable, only while TX buffer has queued data. Reported as TCPNetworkLinux_WAIT_WRITABLE.
+#define TCPNetworkLinux_WAIT_ANY                    0x1D    // READABLE | ACCEPT | CONNECT | PENDING_TX
+
+// Maximum number of file descriptors of one SCM_RIGHTS message on unix domain sockets. (SCM_MAX_FD of kernel)
+#define TCPNetworkLinux_MAX_FILE_DESCRIPTORS        253
+
+// Maximum number of interfaces in TCPLinkMonitor table.
+#define TCPNetworkLinux_LINK_MONITOR_MAX_INTERFACES 64
+
+// Maximum wait time of one TCPLinkMonitor thread iteration and of initial table dump. [ms]
+#define TCPNetworkLinux_LINK_MONITOR_TIMEOUT        100
+
+// Cache line size. Producer and consumer indexes of TCPSpscQueue and TCPMpscQueue are kept on separate lines. [bytes]
+#define TCPNetworkLinux_CACHE_LINE_SIZE             64
+
+// Default capacity of worker queues and reply queue of TCPWorkerPipeline. [messages]
+#define TCPNetworkLinux_DEFAULT_PIPELINE_QUEUE_SIZE 4096
+
+// Number of levels of TCPTimerWheel. Every level has 64 slots and level L slot covers 64^L ms, so 4 levels cover 2^24 ms. (about 4.6 hours)
+// Longer timers are placed in the last level and placed again when they are cascaded.
+#define TCPNetworkLinux_TIMER_WHEEL_LEVELS          4
+
+// Coroutine async API (TCPScheduler, TCPTask, TCPAsyncConnection, TCPAsyncListener) is available. It needs C++20. (eg: -std=c++20)
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define TCPNetworkLinux_COROUTINES                  1
+#else
+#define TCPNetworkLinux_COROUTINES                  0
+#endif
+
+// Coroutine frames up to this size are recycled by TCPFramePool. Larger frames use global operator new. [bytes]
+#define TCPNetworkLinux_FRAME_POOL_MAX_SIZE         4096
+
+// Size class granularity of TCPFramePool. Power of two. [bytes]
+#define TCPNetworkLinux_FRAME_POOL_ALIGN            64
+
+// Smallest and largest chunk of TCPBufferPool. Powers of two. Larger storage is allocated from heap and counted in memory budget. [bytes]
+#define TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK       256
+#define TCPNetworkLinux_BUFFER_POOL_MAX_CHUNK       65536
+
+// Minimum slab size of TCPBufferPool. Power of two. Slabs of large chunks hold 16 chunks. [bytes]
+#define TCPNetworkLinux_BUFFER_POOL_SLAB_SIZE       1048576
+
+// ############################################################################################
+// Socket options:
+
+/**
+ * Socket tuning options of listening, accepted and client sockets.
+ * Value -1 keeps kernel default and the option is not set.
+ */
+struct TCPSocketOptions
+{
+    // TCP_NODELAY. 1 disables Nagle's algorithm, so small segments are sent immediately.
+    int noDelay = -1;
+
+    // TCP_CORK. 1 holds partial segments until uncorked or 200 ms passed.
+    int cork = -1;
+
+    // SO_SNDBUF and SO_RCVBUF in bytes. Kernel doubles requested values for bookkeeping overhead.
+    int sendBufferSize = -1;
+    int receiveBufferSize = -1;
+
+    // TCP_QUICKACK. 1 sends ACKs immediately. Kernel may clear it later, so it is applied again on every socket.
+    int quickAck = -1;
+
+    // TCP_NOTSENT_LOWAT in bytes. Socket is writable only if unsent data is less than it.
+    int notSentLowat = -1;
+
+    // SO_BUSY_POLL in microseconds. Blocking receive busy polls device queue. Values above net.core.busy_read need CAP_NET_ADMIN.
+    int busyPoll = -1;
+
+    // Listen backlog of server socket. It is limited by net.core.somaxconn.
+    int listenBacklog = TCPNetworkLinux_DEFAULT_LISTEN_BACKLOG;
+
+    // Profile for small request/response messages: no Nagle delay, immediate ACKs, busy polling and small unsent queue.
+    static TCPSocketOptions lowLatency(void);
+
+    // Profile for large transfers: Nagle enabled and large kernel buffers.
+    static TCPSocketOptions bulkThroughput(void);
+};
+
 // ############################################################################################
 // General Functions:
 
@@ -43,278 +186,3689 @@ namespace TCPNetworkLinuxNamespace
     // Return ethernet ip address by hardware interface port name(eg: eth0) 
     std::string getIPAddressByInterface(const std::string& interfaceName);
 
+    /**
+     * Set socket options that are not -1. listenBacklog is not applied here.
+     * All options are tried even if one of them fails.
+     * @param errorMessage: names of options that failed.
+     * @param tcpLevel: false skips TCP level options. (eg: unix domain sockets)
+     * @return true if all options are set.
+     */
+    bool applySocketOptions(int socket, const TCPSocketOptions &options, std::string &errorMessage, bool tcpLevel = true);
+
+    /**
+     * Read current values of socket options from kernel. (values actually applied)
+     * listenBacklog can not be read and it is -1. Options that can not be read are -1.
+     */
+    TCPSocketOptions getSocketOptions(int socket);
+
+    /**
+     * Fill unix domain socket address. Path that starts with '@' is in abstract namespace (no file in filesystem).
+     * @return address length. return 0 if path is empty or too long.
+     */
+    socklen_t makeUnixAddress(const char* path, struct sockaddr_un &address);
+
+    /**
+     * Send data with file descriptors (SCM_RIGHTS) on unix domain socket by one sendmsg call.
+     * Descriptors are attached to the first byte, so they are sent only if at least one byte is sent.
+     * @param count: number of descriptors. Maximum is TCPNetworkLinux_MAX_FILE_DESCRIPTORS.
+     * @return number of bytes sent. return -1 if there is any error. (errno is set)
+     */
+    ssize_t sendFileDescriptors(int socket, const char* data, size_t size, const int* fileDescriptors, size_t count);
+
+    /**
+     * Receive data into buffers by one recvmsg call and append received file descriptors (SCM_RIGHTS) to a list.
+     * Received descriptors are close on exec. Caller owns them.
+     * @return number of bytes received. return 0 if peer closed, -1 if there is any error. (errno is set)
+     */
+    ssize_t receiveFileDescriptors(int socket, const struct iovec* buffers, size_t count, std::vector<int> &fileDescriptors);
+
 }
 
 // ############################################################################################
-// TCPServer class:
+// Event loop backends:
 
-// TCP/IP Object for server
-class TCPServer
+/**
+ * I/O backend of TCPServer event loop.
+ * Epoll: edge triggered epoll. One recv/send syscall per ready connection.
+ * IoUring: io_uring with multishot accept, multishot recv into provided buffer ring, batched sends and registered files.
+ * If kernel does not support these features, event loop falls back to Epoll at runtime.
+ */
+enum class TCPEventBackend
 {
-    public:
+    Epoll,
+    IoUring
+};
 
-        // Server Port number on which the server listens. eg: 8080
-        int _port; 
+/**
+ * Length header format of TCPFrameCodec frames.
+ * Fixed16/Fixed32: unsigned 2 or 4 byte payload length in big (BE) or little (LE) endian.
+ * Varint: unsigned LEB128 payload length. (7 bits per byte, high bit set on every byte except the last)
+ */
+enum class TCPFrameHeader
+{
+    Fixed16BE,
+    Fixed16LE,
+    Fixed32BE,
+    Fixed32LE,
+    Varint
+};
 
-        // Server IP address on which the server listens.. Replace with your interface's IP address. eg: "192.168.1.100"                         
-        std::string _ip;  
+/**
+ * Implementation of delimiter scan of TCPDelimiterFramer.
+ * SSE2 and AVX2 are available only on x86 CPUs that support them. Scalar is available everywhere.
+ */
+enum class TCPScanImplementation
+{
+    Scalar,
+    SSE2,
+    AVX2
+};
 
-        // Server interface port name on which the server listens. eg: eth0.
-        std::string _portName; 
+/**
+ * Connection state of TCPClient.
+ * Connecting: non blocking connect is in progress. Connected: handshake is completed.
+ * Failed: connect is refused, timed out or any error accured. Disconnected: not started or closed.
+ */
+enum class TCPConnectState
+{
+    Disconnected,
+    Connecting,
+    Connected,
+    Failed
+};
 
-        // Last error accured for TCPServer object.
-        std::string errorMessage;
+/**
+ * Reason of closing of an event loop connection.
+ * None: connection is open. PeerClosed: peer closed the connection. Error: receive or send failed.
+ * Local: closed by TCPServer::closeConnection(). Shutdown: closed by TCPServer::stopEventLoop().
+ * IdleTimeout: nothing received during idle timeout. WriteTimeout: queued TX data was not sent before write timeout.
+ */
+enum class TCPCloseReason
+{
+    None,
+    PeerClosed,
+    Error,
+    Local,
+    Shutdown,
+    IdleTimeout,
+    WriteTimeout
+};
 
-        // Default constructor. init some variables.
-        TCPServer();
+/**
+ * Policy of TX and RX buffers when data exceeds buffer size (high watermark).
+ * DropOldest: oldest bytes are trimmed. Latest data wins, but the byte stream can be cut in the middle of a message.
+ * DropOldestFrames: like DropOldest, but TX drops whole oldest frames. Every enqueue call is one frame and a frame that is partly sent is kept.
+ * RX has no frame boundaries and trims bytes.
+ * Backpressure: nothing is dropped. Enqueue is refused above high watermark and RX stops reading from the socket while its buffer is full,
+ * so the TCP window closes and the peer slows down. Reading and writing continue when the buffer drops to the low watermark.
+ */
+enum class TCPOverflowPolicy
+{
+    DropOldest,
+    DropOldestFrames,
+    Backpressure
+};
 
-        /** 
-        * Configures and sets up the server.
-        * Set port number and ip address.
-        * Server start listening in non blocking mode.
-        * @param port: port number for server listening.
-        * @param ip: ip address for certain ethernet port.
-        * @return true if successed.
-        */
-        bool startByIP(const uint16_t port, const char* ip);      
+// io_uring state of a TCPServer event loop. It is defined in TCPNetworkLinux.cpp.
+struct TCPIoUring;
 
-        /** 
-        * Configures and sets up the server.
-        * Set port number and interface name.
-        * Server start listening in non blocking mode.
-        * @param port: port number for server listening.
-        * @param InterfaceName: ethernet port name. eg: eth0, en0.
-        * @return true if successed.
-        */
-        bool startByName(const uint16_t port, const char* InterfaceName);             
-        
-        /// @brief Print last error accured for server.
-        void printError(void);
+// Owner of event loop connections. It is defined below.
+class TCPServer;
 
-        // Reteurn last error accured for server.
-        std::string getError(void);
+// ############################################################################################
+// TCPBufferPool class:
+
+/**
+ * Occupancy of TCPBufferPool. Values are process wide.
+ */
+struct TCPBufferPoolStats
+{
+    size_t budgetBytes = 0;         // Memory budget. 0 means unlimited.
+    size_t reservedBytes = 0;       // Memory taken from system by slabs and large chunks.
+    size_t usedBytes = 0;           // Bytes of chunks in use.
+    size_t slabs = 0;               // Number of slabs.
+    uint64_t refusals = 0;          // Allocations refused by memory budget.
+};
+
+/**
+ * Slab allocator of ring buffer storage and connection objects.
+ * Chunks have power of two sizes from TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK to TCPNetworkLinux_BUFFER_POOL_MAX_CHUNK and they are cut 
+ * from slabs of the calling thread, so allocation and release need no lock. A chunk that is released by another thread goes back to 
+ * its owner thread at the next allocation of that thread. Slabs of a thread that exited are shared by threads without their own slabs.
+ * Empty slabs go back to system except one spare slab per size class, so memory follows active data rather than connection count.
+ * Memory taken from system (slabs and larger chunks) does not exceed the process wide memory budget.
+ */
+class TCPBufferPool
+{
+    public:
 
         /**
-         * Return status of server listening.
-         * @return true if server is listening.
-         *  */ 
-        bool isListening(void);
+         * Allocate chunk of chunkSize(size) bytes.
+         * @param force: allocate even if memory budget is exceeded. It is used for objects that can not fail.
+         * @return pointer to chunk. return nullptr if memory budget does not allow it or system is out of memory.
+         */
+        static void* allocate(size_t size, bool force = false);
+
+        // Release chunk of allocate(). size must be the size given to allocate(). Any thread may call it.
+        static void deallocate(void* pointer, size_t size) noexcept;
+
+        // Return chunk size for certain size. It is size rounded up to power of two and at least TCPNetworkLinux_BUFFER_POOL_MIN_CHUNK.
+        static size_t chunkSize(size_t size);
 
         /**
-         * Return status of client connection.
-         * @return true if client is connected.
-         *  */ 
-        bool isClientConnected(void);
+         * Set process wide memory budget. Allocations that need more memory from system fail above it. 0 means unlimited. (default)
+         * Memory that is already taken is not released by a lower budget.
+         */
+        static void setMemoryBudget(size_t bytes);
+
+        // Return process wide memory budget. 0 means unlimited.
+        static size_t getMemoryBudget(void);
+
+        // Return process wide occupancy.
+        static TCPBufferPoolStats getStats(void);
 
         /**
-         * Check ethernet physically cable connected to certain port.
-         * @return true if ethernet port connected physically.
-         *  */ 
-        bool checkLinkStatus(const char* port_name);   
+         * Append occupancy in Prometheus text exposition format.
+         * @param withHeader: also write # HELP and # TYPE lines.
+         */
+        static void formatPrometheus(std::string &output, bool withHeader = true);
+
+        // Return spare slabs of calling thread to system.
+        static void release(void);
+};
+
+// ############################################################################################
+// TCPRingBuffer class:
+
+/**
+ * Byte ring buffer with power of two capacity. It is used for RX/TX buffers of TCPServer and TCPConnection.
+ * Data is pushed and popped in bulk by memcpy. Readable and writable regions are exposed as at most two iovec segments,
+ * so sockets can read/write directly into the storage.
+ * Storage is a TCPBufferPool chunk, so growth fails when memory budget is exceeded.
+ * In mirrored mode the storage is mapped twice back to back (memfd), so readable and writable regions are always contiguous.
+ */
+class TCPRingBuffer
+{
+    public:
+
+        // Default constructor. No storage is allocated.
+        TCPRingBuffer();
+
+        // Destructor. Release storage.
+        ~TCPRingBuffer();
+
+        TCPRingBuffer(const TCPRingBuffer&) = delete;
+        TCPRingBuffer& operator=(const TCPRingBuffer&) = delete;
 
         /**
-         * readWrite or send/recieve operation. 
-         * Send txBuffer, receive and store in rxBuffer.
+         * Make capacity at least certain size. Capacity is rounded up to power of two. Stored data is kept.
          * @return true if successed.
-         * */ 
-        bool readWrite(char *txBuffer = nullptr, size_t txSize = 0, char *rxBuffer = nullptr, size_t rxSize = 0);
+         */
+        bool reserve(size_t capacity);
 
         /**
-         * read or recieve operation.
-         * Receive and store in a rxBuffer char array.
-         * @param rxSize: number of character for read.
-         * @return number of bytes that read. return -1 if there is any error.
-         *  */  
-        int32_t read(char *rxBuffer, const size_t &rxSize);
+         * Enable or disable mirrored mapping of storage. Capacity is rounded up to page size in mirrored mode. Stored data is kept.
+         * @return true if successed. The buffer remains in previous mode if it fails.
+         */
+        bool setMirrored(bool enable);
 
-        /**
-         * read or recieve operation.
-         * Receive and store all data(max size = rxBufferSize) in a rxBuffer string.
-         * @return number of bytes that read. return -1 if there is any error.
-         *  */ 
-        int32_t read(std::string *rxBuffer);
+        // Return true if storage is mirrored.
+        bool isMirrored(void) const;
 
-        /**
-         * read or recieve operation.
-         * Receive and append all data  in to the deque rxbuffer of server. *Hint: max size of deque of rxBuffer is limited to rxBufferSize.
-         * @return number of bytes that read. return -1 if there is any error.
-         *  */ 
-        int32_t read(void);
+        // Return number of stored bytes.
+        size_t size(void) const;
+
+        // Return storage capacity.
+        size_t capacity(void) const;
+
+        // Return number of free bytes.
+        size_t space(void) const;
 
         /**
-         * Write or send operation.
-         * @param txBuffer: pointer to the char array.
-         * @param txSize: number of char that want to send.
-         * @return true if successed.
-         *  */  
-        bool write(const char &txBuffer, const size_t &txSize);
+         * Return storage to TCPBufferPool if no data is stored. Next push allocates storage again. Mirrored storage is kept.
+         */
+        void release(void);
+
+        // Return true if no data is stored.
+        bool empty(void) const;
 
         /**
-         * Write or send operation.
-         * @param txBuffer: pointer to the string that want to send.
-         * @return true if successed.
-         *  */  
-        bool write(const std::string &txBuffer);
+         * Push back certain number of bytes. Only bytes that fit in free space are pushed.
+         * @return number of bytes pushed.
+         */
+        size_t push(const char* data, size_t size);
 
         /**
-         * Write or send operation.
-         * Write all data on TX buffer then remove tx elements.
-         * @return true if successed.
-         *  */  
-        bool write(void);
+         * Push back certain number of bytes and remove oldest bytes so that stored size does not exceed limit.
+         * @return number of dropped bytes. (old stored bytes plus front of data if data is bigger than limit)
+         */
+        size_t pushDropOldest(const char* data, size_t size, size_t limit);
 
-        // Close server socket.
-        void serverClose(void);
+        /**
+         * Pop front certain number of bytes into data array.
+         * @return number of bytes popped.
+         */
+        size_t pop(char* data, size_t size);
 
-        // Close client socket.
-        void clientClose(void);
+        /**
+         * Remove certain number of bytes that start at certain offset from front. Bytes before the range are moved, so it is cheap for small offset.
+         */
+        void erase(size_t offset, size_t size);
 
         /**
-         * Try to connect to any client socket.
-         * @return true if client connected.
+         * Copy front certain number of bytes into data array without removing them.
+         * @return number of bytes copied.
          */
-        bool clientConnect(void);
+        size_t peek(char* data, size_t size) const;
 
-        // Return library version.
-        std::string getVersion(void);
+        // Remove certain number of bytes from front.
+        void discard(size_t size);
 
-        // Set transmit buffer size. 
-        void setTxBufferSize(size_t size = 1000);
+        // Remove all data.
+        void clear(void);
 
-        // Set receive buffer size.
-        void setRxBufferSize(size_t size = 1000);
+        // Exchange storage and data with other ring buffer without copy.
+        void swap(TCPRingBuffer &other);
 
-        // Return number of character available for read on the server socket.
-        int32_t available(void);
+        /**
+         * Return readable region as two segments. Second segment is empty if data is contiguous.
+         * @return number of non empty segments.
+         */
+        int readableSegments(struct iovec segments[2]) const;
 
-        // Remove certain number character from front of RX deque buffer.
-        void removeFrontRxBuffer(size_t num);
+        /**
+         * Return writable (free) region as two segments. Second segment is empty if free space is contiguous.
+         * @return number of non empty segments.
+         */
+        int writableSegments(struct iovec segments[2]) const;
 
-        // Remove certain number character from front of TX deque buffer.
-        void removeFrontTxBuffer(size_t size);
+        // Mark certain number of bytes written into writable region as stored data.
+        void commit(size_t size);
 
-        // Remove all data from RX deque buffer.
-        void removeAllRxBuffer(void);
+        // Return first contiguous readable region. It is all stored data in mirrored mode.
+        std::string_view readable(void) const;
 
-        // Remove all data from TX deque buffer.
-        void removeAllTxBuffer(void);
+        // Return first contiguous writable region. It is all free space in mirrored mode.
+        struct iovec writable(void) const;
 
-        /**
-         * Pop front certain number elements from RX buffer and remove them.
-         * @return string that pop front.
-         *  */
-        std::string popFrontRxBuffer(size_t size);
+        // Move stored data to be contiguous in storage and return view of all of it.
+        std::string_view linearize(void);
 
         /**
-         * Pop front all elements from RX buffer and remove them.
-         * @return string that pop front.
-         *  */
-        std::string popAllRxBuffer(void);
+         * Receive from socket directly into free region of storage (readv into at most two segments).
+         * At most limit bytes are received and only the newest limit bytes are kept. Capacity grows to twice the limit,
+         * so a full limit of fresh data always fits in place before the oldest bytes are trimmed.
+         * @param droppedBytes: number of old bytes trimmed by limit is added to it if it is not nullptr.
+         * @param fileDescriptors: if it is not nullptr, recvmsg is used and received file descriptors (SCM_RIGHTS) are appended to it.
+         * @return number of bytes received. return 0 if peer closed, -1 if there is any error (errno is set). Zero limit fails with EAGAIN.
+         */
+        ssize_t recvFrom(int socket, size_t limit, size_t* droppedBytes = nullptr, std::vector<int>* fileDescriptors = nullptr);
 
         /**
-         * Push back certain number character from char array to RX buffer.
+         * Receive at most certain number of bytes from socket behind stored data. Nothing is dropped and capacity grows if it is needed.
+         * @param size: maximum number of bytes.
+         * @param fileDescriptors: if it is not nullptr, recvmsg is used and received file descriptors (SCM_RIGHTS) are appended to it.
+         * @return number of bytes received. return 0 if peer closed, -1 if there is any error (errno is set). Zero size fails with EAGAIN.
          */
-        void pushBackRxBuffer(const char* data, size_t size);
+        ssize_t recvAppend(int socket, size_t size, std::vector<int>* fileDescriptors = nullptr);
 
         /**
-         * Push back certain string to RX buffer.
+         * Send stored data to socket by one sendmsg call over both segments. Sent bytes are removed from front.
+         * @return number of bytes sent. return -1 if there is any error (errno is set).
          */
-        void pushBackRxBuffer(const std::string* data);
+        ssize_t sendTo(int socket);
 
         /**
-         * Push back certain number character from char array to TX buffer.
+         * Send stored data followed by certain list of buffers by sendmsg calls of at most IOV_MAX segments.
+         * All of them are sent by one syscall if count + 2 <= IOV_MAX and the socket accepts all data.
+         * Unsent bytes of buffers are appended behind stored data, so byte order is kept.
+         * @return number of bytes sent. return -1 if there is any error (errno is set). errno is ENOMEM if unsent bytes can not be stored.
          */
-        void pushBackTxBuffer(const char* data, size_t size);
+        ssize_t sendTo(int socket, const struct iovec* buffers, size_t count);
 
         /**
-         * Push back certain string to TX buffer.
+         * Push back all bytes of data. Capacity grows if free space is not enough, nothing is dropped.
+         * @return true if successed.
          */
-        void pushBackTxBuffer(const std::string* data);
+        bool append(const char* data, size_t size);
 
-    
     private:
 
-        std::deque<char> _txBuffer;        // TX deque buffer.
-        std::deque<char> _rxBuffer;        // RX deque buffer.
+        char* _data;                // Storage pointer.
+        size_t _capacity;           // Storage capacity. Power of two.
+        size_t _readIndex;          // Free running read index.
+        size_t _writeIndex;         // Free running write index.
+        bool _mirrored;             // Storage is mapped twice back to back.
 
-        size_t _txBufferSize;              // Max size for tx deque buffer.
-        size_t _rxBufferSize;              // Max size for rx deque buffer.
-        
-        // Integer representing the server's socket descriptor.
-        int _serverSocket;             
-
-        // Integer representing the client's socket descriptor. 
-        int _clientSocket;                            
+        // Allocate new storage with certain capacity and mode, move stored data into it.
+        bool _reallocate(size_t capacity, bool mirrored);
 
-        /**
-         * Accepts a client connection. [ Non blocking mode.]
-         * @return true if successfully connected to a client
-         *  */ 
-        bool _clientConfig(void);                
-        
-        // Handles client disconnection
-        void _handleClientDisconnection(void);  
+        // Release storage.
+        void _release(char* data, size_t capacity, bool mirrored);
 
-        // Handles server disconnection
-        void _handleServerDisconnection(void);
+        // Reserve space for certain buffers behind stored data. First offset bytes of buffers are not counted. (errno is ENOMEM if failed)
+        bool _reserveTail(const struct iovec* buffers, size_t count, size_t offset);
 
+        // Receive into free segments and commit received bytes.
+        ssize_t _receive(int socket, struct iovec segments[2], std::vector<int>* fileDescriptors);
 };
 
 // ############################################################################################
-// TCPClient class:
+// TCPFrameTracker class:
 
-class TCPClient
+/**
+ * Frame sizes of data queued in a TCPRingBuffer. It lets lossy TX buffers drop whole oldest frames. (TCPOverflowPolicy::DropOldestFrames)
+ * Every enqueue is recorded as one frame. Bytes that leave front of the buffer (sent or discarded) are found by buffer size.
+ */
+class TCPFrameTracker
 {
     public:
 
-        // Destructor
-        ~TCPClient() {
-            clientClose();
-        }
+        // Default constructor.
+        TCPFrameTracker();
 
-        /*
-        Configures and sets up the client.
-        Set port and ip address.
-        Client connection is in non blocking mode.
-        */
-        bool start(int port, const char* ip);                 
-        
-        // Update send/recieve operation. 
-        // Send txBuffer, receive and store in rxBuffer.
+        /**
+         * Record a frame behind recorded frames. Part of it may be sent already, and sync() finds that part.
+         * @param size: size of frame as it is offered to the buffer.
+         */
+        void push(size_t size);
+
+        /**
+         * Forget bytes that left front of the buffer.
+         * @param bufferedBytes: number of bytes stored in the buffer now.
+         */
+        void sync(size_t bufferedBytes);
+
+        /**
+         * Remove whole oldest frames from buffer until at least certain number of bytes are removed or no frame remains. 
+         * Frame at front that is partly sent is kept. Call sync() before it.
+         * @return number of removed bytes.
+         */
+        size_t dropOldest(TCPRingBuffer &buffer, size_t size);
+
+        // Forget all frames.
+        void clear(void);
+
+    private:
+
+        // Sizes of recorded frames from oldest.
+        std::deque<size_t> _frames;
+
+        // Number of bytes of recorded frames that are still in the buffer.
+        size_t _bytes;
+
+        // Number of bytes of front frame that left the buffer.
+        size_t _frontSent;
+
+        // Front frame must be kept. It is partly sent or it holds bytes that were not recorded.
+        bool _frontLocked;
+};
+
+// ############################################################################################
+// TCPStats class:
+
+// Hot path counters of TCPStats.
+enum class TCPStatsCounter : size_t
+{
+    RxBytes,            // Bytes received.
+    RxCalls,            // Receive syscalls or completions.
+    RxEagain,           // Receive calls that would block.
+    RxDroppedBytes,     // Received bytes dropped by RX buffer overflow trimming.
+    RxHighWater,        // Maximum RX buffer size. (gauge)
+    RxPauses,           // Times that reading stopped since RX buffer was full. (TCPOverflowPolicy::Backpressure)
+    TxBytes,            // Bytes sent.
+    TxCalls,            // Send syscalls or completions.
+    TxEagain,           // Send calls that would block.
+    TxPartialWrites,    // Send calls that accepted only part of offered data.
+    TxDroppedBytes,     // Queued bytes dropped by TX buffer overflow trimming.
+    TxHighWater,        // Maximum TX queue size. (gauge)
+    TxRefused,          // Enqueue calls refused since TX queue was full. (TCPOverflowPolicy::Backpressure)
+    Accepts,            // Accepted connections.
+    Disconnects,        // Closed connections.
+    Count
+};
+
+// Copy of all counters of TCPStats at one time.
+struct TCPStatsSnapshot
+{
+    uint64_t counters[(size_t)TCPStatsCounter::Count] = {};
+
+    // Return value of certain counter.
+    uint64_t operator[](TCPStatsCounter counter) const { return counters[(size_t)counter]; }
+};
+
+/**
+ * Hot path statistics of a connection or server.
+ * Counters are relaxed atomics with one writer (thread of the event loop that owns the object), 
+ * so updates are plain load/store without lock prefix and any thread can read a snapshot.
+ */
+class TCPStats
+{
+    public:
+
+        // Constructor. All counters are zero.
+        TCPStats();
+
+        // Add value to certain counter. Only owner thread may call it.
+        void add(TCPStatsCounter counter, uint64_t value = 1);
+
+        // Raise certain gauge to value if value is bigger. Only owner thread may call it.
+        void max(TCPStatsCounter counter, uint64_t value);
+
+        /**
+         * Count one receive call.
+         * @param bytesRead: result of receive call or negative errno value. -EAGAIN counts RxEagain.
+         * @param droppedBytes: bytes dropped by RX buffer trimming.
+         * @param bufferedBytes: RX buffer size after the call.
+         */
+        void countRx(ssize_t bytesRead, size_t droppedBytes, size_t bufferedBytes);
+
+        /**
+         * Count one send call.
+         * @param bytesWrite: result of send call or negative errno value. -EAGAIN counts TxEagain.
+         * @param offeredBytes: bytes that were offered to the kernel.
+         * @param queuedBytes: TX queue size before the call.
+         */
+        void countTx(ssize_t bytesWrite, size_t offeredBytes, size_t queuedBytes);
+
+        // Return value of certain counter.
+        uint64_t get(TCPStatsCounter counter) const;
+
+        // Return copy of all counters.
+        TCPStatsSnapshot snapshot(void) const;
+
+        // Set all counters to zero.
+        void reset(void);
+
+        /**
+         * Append counters in Prometheus text exposition format.
+         * @param snapshot: counters.
+         * @param labels: label list without braces. eg: server="127.0.0.1:8080"
+         * @param withHeader: also write # HELP and # TYPE lines.
+         */
+        static void formatPrometheus(std::string &output, const TCPStatsSnapshot &snapshot, const std::string &labels, bool withHeader = true);
+
+    private:
+
+        std::atomic<uint64_t> _counters[(size_t)TCPStatsCounter::Count];
+};
+
+// ############################################################################################
+// TCPTimer class:
+
+class TCPTimerWheel;
+
+/**
+ * Timer of a TCPTimerWheel. It is an intrusive list node, so arm, re-arm and cancel do not allocate.
+ * Embed it in the object that it belongs to. A destroyed timer is canceled.
+ */
+class TCPTimer
+{
+    public:
+
+        /**
+         * Expiry callback. It is called by TCPTimerWheel::advance(). The timer is disarmed before the call, so it can be armed again.
+         * @param context: pointer that is set with the callback.
+         */
+        using Callback = void (*)(TCPTimer &timer, void* context);
+
+        // Default constructor. Timer without callback.
+        TCPTimer();
+
+        // Constructor. Timer with certain callback.
+        TCPTimer(Callback callback, void* context);
+
+        // Destructor. Cancel timer.
+        ~TCPTimer();
+
+        TCPTimer(const TCPTimer&) = delete;
+        TCPTimer& operator=(const TCPTimer&) = delete;
+
+        // Set expiry callback. It can be nullptr.
+        void setCallback(Callback callback, void* context);
+
+        // Return true if timer is armed on a wheel.
+        bool isArmed(void);
+
+        // Return expiry time of armed timer on clock of its wheel. [ms]
+        uint64_t getExpiry(void);
+
+        // Cancel timer if it is armed.
+        void cancel(void);
+
+    private:
+
+        friend class TCPTimerWheel;
+
+        // Wheel of armed timer. nullptr if timer is not armed.
+        TCPTimerWheel* _wheel;
+
+        // Neighbours in slot list.
+        TCPTimer* _previous;
+        TCPTimer* _next;
+
+        // Expiry time on clock of wheel. [ms]
+        uint64_t _expiry;
+
+        // Level and slot of the wheel that holds the timer.
+        uint8_t _level;
+        uint8_t _slot;
+
+        Callback _callback;
+        void* _context;
+};
+
+// ############################################################################################
+// TCPTimerWheel class:
+
+/**
+ * Hierarchical timing wheel with 1 ms resolution. (TCPNetworkLinux_TIMER_WHEEL_LEVELS levels of 64 slots)
+ * Arm, re-arm and cancel are O(1). Timers of upper levels are moved to lower levels (cascaded) when time reaches their slot.
+ * Occupied slots are tracked by bitmaps, so advance() jumps over empty slots and getTimeout() finds next expiry without scanning timers.
+ * Clock is steady clock in milliseconds since the wheel is created. Use one wheel per thread.
+ */
+class TCPTimerWheel
+{
+    public:
+
+        // Default constructor. Start clock.
+        TCPTimerWheel();
+
+        // Destructor. Cancel all timers.
+        ~TCPTimerWheel();
+
+        TCPTimerWheel(const TCPTimerWheel&) = delete;
+        TCPTimerWheel& operator=(const TCPTimerWheel&) = delete;
+
+        /**
+         * Arm timer to expire certain time after cached time. An armed timer is moved. (re-arm)
+         * @param delayMs: delay in milliseconds. Zero or negative delay expires at next advance().
+         */
+        void arm(TCPTimer &timer, int64_t delayMs);
+
+        // Arm timer to expire at certain time on wheel clock. Past time expires at next advance(). [ms]
+        void armAt(TCPTimer &timer, uint64_t expiry);
+
+        // Cancel timer if it is armed on this wheel.
+        void cancel(TCPTimer &timer);
+
+        /**
+         * Update cached time, expire due timers and call their callbacks.
+         * @return number of expired timers.
+         */
+        size_t advance(void);
+
+        // Read clock into cached time. Event loops call it once after waiting, so hot paths use getTime() without clock reads.
+        void updateTime(void);
+
+        // Return cached time. [ms]
+        uint64_t getTime(void);
+
+        /**
+         * Return wait time until next expiry or next cascade of an upper level. It is never later than the first expiry.
+         * @param maxTimeoutMs: maximum wait time. -1 means no limit.
+         * @return wait time in milliseconds. return maxTimeoutMs if it is earlier or no timer is armed.
+         */
+        int getTimeout(int maxTimeoutMs);
+
+        // Return number of armed timers.
+        size_t size(void);
+
+    private:
+
+        // Slot lists. Index is level and slot.
+        TCPTimer* _slots[TCPNetworkLinux_TIMER_WHEEL_LEVELS][64];
+
+        // Bitmaps of non empty slots of every level.
+        uint64_t _occupied[TCPNetworkLinux_TIMER_WHEEL_LEVELS];
+
+        // Last processed tick. [ms]
+        uint64_t _tick;
+
+        // Cached time. [ms]
+        uint64_t _time;
+
+        // Start of wheel clock.
+        std::chrono::steady_clock::time_point _start;
+
+        // Number of armed timers.
+        size_t _count;
+
+        // Put timer into slot of its expiry. Expiry earlier than minimum is placed at minimum.
+        void _insert(TCPTimer &timer, uint64_t minimum);
+
+        // Remove timer from its slot.
+        void _unlink(TCPTimer &timer);
+
+        // Move timers of current slot of certain level to lower levels.
+        void _cascade(size_t level);
+};
+
+// ############################################################################################
+// TCPConnection class:
+
+/**
+ * One accepted client connection owned by the TCPServer event loop.
+ * Every connection has its own RX/TX ring buffers. Objects are created and destroyed by TCPServer.
+ */
+class TCPConnection
+{
+    public:
+
+        // Last error accured for this connection.
+        std::string errorMessage;
+
+        // Return socket descriptor of the connection. It is also the connection id in the TCPServer table.
+        int getSocket(void);
+
+        // Return client IP address of the connection. It is empty for unix domain connections.
+        std::string getIP(void);
+
+        // Return client port number of the connection. It is 0 for unix domain connections.
+        uint16_t getPort(void);
+
+        // Return values of socket options that kernel applied on the connection socket.
+        TCPSocketOptions getAppliedSocketOptions(void);
+
+        // Return snapshot of hot path statistics of the connection.
+        TCPStatsSnapshot getStats(void);
+
+        /**
+         * Return status of connection.
+         * @return false after the peer closed the connection or an error accured.
+         *  */ 
+        bool isConnected(void);
+
+        // Return reason of closing. It is TCPCloseReason::None while connection is open.
+        TCPCloseReason getCloseReason(void);
+
+        /**
+         * Write or send operation.
+         * Send as much of the TX buffer as the socket accepts and remove the sent elements.
+         * The remained data is sent automatically by the event loop when the socket is writable again.
+         * @return true if successed.
+         *  */  
+        bool write(void);
+
+        /**
+         * Write or send operation.
+         * Queue data behind pending TX data without dropping and send as much as the socket accepts.
+         * With TCPOverflowPolicy::Backpressure, data that does not fit in TX buffer is refused while TX data is queued.
+         * It returns false, the connection stays connected and isTxBlocked() is true.
+         * @return true if successed.
+         *  */  
+        bool write(const char* data, size_t size);
+
+        /**
+         * Write or send operation.
+         * Queue string behind pending TX data without dropping and send as much as the socket accepts.
+         * It is refused like write(data, size) by backpressure.
+         * @return true if successed.
+         *  */  
+        bool write(const std::string &data);
+
+        /**
+         * Vectored write or send operation.
+         * Send pending TX data and certain list of buffers by one sendmsg call. Unsent bytes are queued in TX buffer.
+         * It is refused like write(data, size) by backpressure.
+         * @param buffers: list of buffers.
+         * @param count: number of buffers.
+         * @return true if successed.
+         *  */  
+        bool write(const struct iovec* buffers, size_t count);
+
+        /**
+         * Return true if backpressure refused TX data and TX queue did not drop to low watermark yet.
+         * The event loop reports the connection by getDrainedConnections() and TCPHandler::onWritable() when it is cleared.
+         */
+        bool isTxBlocked(void);
+
+        /**
+         * Return true if reading stopped since RX buffer is full. (TCPOverflowPolicy::Backpressure)
+         * The event loop reads again after RX data is consumed down to low watermark.
+         */
+        bool isRxPaused(void);
+
+        /**
+         * Send data with file descriptors (SCM_RIGHTS). Unix domain sockets only.
+         * Queued TX data is sent first. Descriptors are not sent if the socket does not accept queued data or first byte of data.
+         * Unsent tail of data is queued in TX buffer.
+         * @param fileDescriptors: list of descriptors. They stay open and owned by caller.
+         * @param count: number of descriptors. Maximum is TCPNetworkLinux_MAX_FILE_DESCRIPTORS.
+         * @param size: size of data. It must be at least one byte.
+         * @return true if descriptors are sent.
+         */
+        bool sendFileDescriptors(const int* fileDescriptors, size_t count, const char* data, size_t size);
+
+        /**
+         * Pop oldest received file descriptor. Unix domain sockets only.
+         * Descriptors are received by read operations together with the data they were sent with.
+         * @return descriptor. Caller owns it. return -1 if no descriptor is received.
+         */
+        int popFileDescriptor(void);
+
+        // Return number of bytes stored in RX ring buffer.
+        size_t getRxBufferedBytes(void);
+
+        // Return number of bytes queued in TX ring buffers. Zero means all data is handed to the kernel.
+        size_t getTxQueuedBytes(void);
+
+        // Remove certain number character from front of RX ring buffer.
+        void removeFrontRxBuffer(size_t num);
+
+        // Remove all data from RX ring buffer.
+        void removeAllRxBuffer(void);
+
+        /**
+         * Return view of all data in RX buffer without copy. Data is moved to be contiguous only if it wraps in storage.
+         * The view is valid until next read or consumeRxBuffer().
+         */
+        std::string_view peekRxBuffer(void);
+
+        /**
+         * Return data in RX buffer as at most two segments without any copy or move.
+         * @return number of non empty segments.
+         */
+        int peekRxBuffer(struct iovec segments[2]);
+
+        // Remove certain number of consumed bytes from front of RX buffer. Use it after peekRxBuffer().
+        void consumeRxBuffer(size_t size);
+
+        /**
+         * Pop front certain number elements from RX buffer and remove them.
+         * @return string that pop front.
+         *  */
+        std::string popFrontRxBuffer(size_t size);
+
+        /**
+         * Pop front all elements from RX buffer and remove them.
+         * @return string that pop front. Use peekRxBuffer() and consumeRxBuffer() to avoid copy and allocation.
+         *  */
+        std::string popAllRxBuffer(void);
+
+        /**
+         * Push back certain number character from char array to TX buffer. TX buffer size is handled by overflow policy of server.
+         * @return true if data is queued. return false if backpressure refused it. (TCPOverflowPolicy::Backpressure)
+         */
+        bool pushBackTxBuffer(const char* data, size_t size);
+
+        /**
+         * Push back certain string to TX buffer.
+         * @return true if data is queued. return false if backpressure refused it.
+         */
+        bool pushBackTxBuffer(const std::string* data);
+
+    private:
+
+        friend class TCPServer;
+        friend class TCPFrameCodec;
+        friend class TCPDelimiterFramer;
+
+        TCPRingBuffer _txBuffer;           // TX ring buffer.
+        TCPRingBuffer _rxBuffer;           // RX ring buffer.
+
+        size_t _txBufferSize;              // Max size for tx ring buffer.
+        size_t _rxBufferSize;              // Max size for rx ring buffer.
+
+        // Integer representing the connection socket descriptor.
+        int _socket;
+
+        // Client IP address and port number.
+        std::string _ip;
+        uint16_t _port;
+
+        // Connection is a unix domain socket.
+        bool _unix;
+
+        // Received file descriptors that are not popped yet.
+        std::vector<int> _rxFileDescriptors;
+
+        // Connection status. It is cleared when peer closed or an error accured.
+        bool _connected;
+
+        // Connection is in ready connections list of the current event loop iteration.
+        bool _inReadyList;
+
+        // Connection is in drained connections list of the current event loop iteration.
+        bool _inDrainedList;
+
+        // Reason of closing. None while connection is open.
+        TCPCloseReason _closeReason;
+
+        // Owner server.
+        TCPServer* _server;
+
+        // Timer wheel of owner server.
+        TCPTimerWheel* _timerWheel;
+
+        // Idle, write and heartbeat timers. 0 timeout or interval disables the timer. [ms]
+        TCPTimer _idleTimer;
+        TCPTimer _writeTimer;
+        TCPTimer _heartbeatTimer;
+        int _idleTimeout;
+        int _writeTimeout;
+        int _heartbeatInterval;
+
+        // Time of last received and sent data on wheel clock. Idle and heartbeat timers are re-armed lazily from them. [ms]
+        uint64_t _lastRxTime;
+        uint64_t _lastTxTime;
+
+        // Arm write timer if TX data is queued and cancel it if TX data is fully sent.
+        void _updateWriteTimer(void);
+
+        // Overflow policy of TX and RX buffers.
+        TCPOverflowPolicy _overflowPolicy;
+
+        // Low watermarks of backpressure. Blocked TX and paused RX continue when queued or buffered bytes drop to them.
+        size_t _txLowWatermark;
+        size_t _rxLowWatermark;
+
+        // Backpressure refused TX data and TX queue did not drop to low watermark yet.
+        bool _txBlocked;
+
+        // Reading stopped since RX buffer was full.
+        bool _rxPaused;
+
+        // Frame sizes of TX buffer. (TCPOverflowPolicy::DropOldestFrames)
+        TCPFrameTracker _txFrames;
+
+        // Resume list of owner server. A paused connection adds itself when its RX buffer drops to low watermark.
+        std::vector<TCPConnection*>* _rxResumeList;
+
+        // A recv request of io_uring backend is armed.
+        bool _rxArmed;
+
+        // Check backpressure before certain number of bytes are queued. return false and block TX if they do not fit.
+        bool _admitTx(size_t size);
+
+        // Record offered TX data as a frame. (TCPOverflowPolicy::DropOldestFrames)
+        void _recordTxFrame(size_t size);
+
+        // Clear blocked state if TX queue dropped to low watermark. return true if it is cleared.
+        bool _unblockTx(void);
+
+        // Unblock list of owner server. write() adds the connection when it sends TX queue down to low watermark.
+        std::vector<TCPConnection*>* _txUnblockList;
+
+        // Clear blocked state after write() sent queued data, and add connection to unblock list if it is cleared.
+        void _reportUnblockedTx(void);
+
+        // Add paused connection to resume list if RX buffer dropped to low watermark.
+        void _resumeRx(void);
+
+        // Deferred send list of io_uring backend. nullptr means sends are issued directly by syscalls.
+        std::vector<TCPConnection*>* _txDeferredList;
+
+        // Connection is in deferred send list.
+        bool _txDeferred;
+
+        // TX data that is owned by an in flight io_uring send. New data is queued in _txBuffer meanwhile.
+        TCPRingBuffer _txSending;
+
+        // An io_uring send of _txSending is in flight.
+        bool _txInFlight;
+
+        // An io_uring send left a remainder, so TX data waited for socket space. Drained is reported when queue is empty again.
+        bool _txWaited;
+
+        // Number of in flight io_uring requests that refer to this object. Object is deleted when it is zero.
+        uint32_t _uringPending;
+
+        // Registered file index of io_uring backend. -1 if socket is not registered.
+        int _fileSlot;
+
+        // Hot path statistics of the connection.
+        TCPStats _stats;
+
+        // Statistics of owner server. Every count is also added to it.
+        TCPStats* _serverStats;
+
+        // Count one receive call on connection and server statistics. bytesRead is result or negative errno value.
+        void _countRx(ssize_t bytesRead, size_t droppedBytes);
+
+        // Count one send call on connection and server statistics. bytesWrite is result or negative errno value.
+        void _countTx(ssize_t bytesWrite, size_t offeredBytes, size_t queuedBytes);
+
+        TCPConnection(int socket, const struct sockaddr_in &address, size_t rxBufferSize, size_t txBufferSize);
+
+        // Connection objects are cut from TCPBufferPool slabs. They are not limited by memory budget.
+        static void* operator new(size_t size);
+        static void operator delete(void* pointer, size_t size) noexcept;
+
+        // Return storage of empty RX and TX buffers to TCPBufferPool.
+        void _releaseIdleBuffers(void);
+
+        /**
+         * Receive all data until the socket would block and append it to the RX buffer. (Edge triggered mode)
+         * With TCPOverflowPolicy::Backpressure, it stops and pauses RX when the buffer is full.
+         * @param hangUp: event reported peer close or error. If it is false, a short read means the socket is drained and 
+         * read stops without the extra EAGAIN call. Later data or peer close raises a new edge.
+         * @return number of bytes that read. return -1 if connection closed or there is any error.
+         *  */
+        int32_t _readAll(bool hangUp = true);
+
+        // Close socket of the connection.
+        void _close(void);
+};
+
+// ############################################################################################
+// TCPFrameCodec class:
+
+/**
+ * Length prefixed message framing on top of ring buffers of connections.
+ * Every frame is a length header followed by payload. Complete frames are returned as views into RX storage, 
+ * so decoding does not copy or allocate. Use one object per thread.
+ */
+class TCPFrameCodec
+{
+    public:
+
+        // Last error accured for TCPFrameCodec object.
+        std::string errorMessage;
+
+        /**
+         * Constructor.
+         * @param header: length header format.
+         * @param maxFrameSize: maximum payload size. It is limited to maximum length that header can carry.
+         */
+        TCPFrameCodec(TCPFrameHeader header = TCPFrameHeader::Fixed32BE, size_t maxFrameSize = TCPNetworkLinux_DEFAULT_MAX_FRAME_SIZE);
+
+        // Set length header format. Maximum frame size is limited again for new format.
+        void setHeader(TCPFrameHeader header);
+
+        // Return length header format.
+        TCPFrameHeader getHeader(void);
+
+        // Set maximum payload size. It is limited to maximum length that header can carry.
+        void setMaxFrameSize(size_t size);
+
+        // Return maximum payload size.
+        size_t getMaxFrameSize(void);
+
+        // Return header size for certain payload size.
+        size_t headerSize(size_t frameSize);
+
+        /**
+         * Decode front frame of buffer without removing it.
+         * Storage is linearized only if a frame wraps around the end of non mirrored storage. Use mirrored RX buffers to avoid it.
+         * @param buffer: ring buffer that contains received stream.
+         * @param frame: view of payload. It is valid until buffer is changed.
+         * @return number of bytes of frame including header. Remove them by buffer.discard() after frame is used.
+         * return 0 if frame is not complete. return -1 if frame is larger than maximum frame size or header is invalid.
+         */
+        ssize_t decode(TCPRingBuffer &buffer, std::string_view &frame);
+
+        /**
+         * Decode front frame of RX buffer of connection without removing it.
+         * @return number of bytes of frame including header. Remove them by connection->consumeRxBuffer() after frame is used.
+         * return 0 if frame is not complete. return -1 if frame is larger than maximum frame size or header is invalid.
+         */
+        ssize_t decode(TCPConnection* connection, std::string_view &frame);
+
+        /**
+         * Encode list of payloads as frames and push back them into buffer in one pass. Buffer capacity grows once for all frames.
+         * @return true if successed. Nothing is pushed if any payload is larger than maximum frame size.
+         */
+        bool encode(TCPRingBuffer &buffer, const struct iovec* frames, size_t count);
+
+        // Encode one payload as frame and push back it into buffer. return true if successed.
+        bool encode(TCPRingBuffer &buffer, const char* data, size_t size);
+
+        /**
+         * Encode list of payloads as frames into TX buffer of connection in one pass and send them.
+         * @return true if successed.
+         */
+        bool write(TCPConnection* connection, const struct iovec* frames, size_t count);
+
+        // Encode one payload as frame into TX buffer of connection and send it. return true if successed.
+        bool write(TCPConnection* connection, const char* data, size_t size);
+
+    private:
+
+        // Length header format.
+        TCPFrameHeader _header;
+
+        // Maximum payload size.
+        size_t _maxFrameSize;
+
+        // Return maximum payload length that header format can carry.
+        size_t _headerLimit(void);
+
+        // Write header of certain payload size into header array. return header size.
+        size_t _encodeHeader(size_t frameSize, uint8_t* header);
+};
+
+// ############################################################################################
+// TCPDelimiterFramer class:
+
+/**
+ * Delimiter terminated record framing on top of ring buffers of connections. eg: newline terminated text protocols.
+ * Delimiter is found by SSE2/AVX2 vector scan. The best implementation is selected at runtime with a scalar fallback.
+ * Complete records are returned as views into RX storage, so decoding does not copy or allocate.
+ */
+class TCPDelimiterFramer
+{
+    public:
+
+        // Last error accured for TCPDelimiterFramer object.
+        std::string errorMessage;
+
+        /**
+         * Constructor.
+         * @param delimiter: record terminator character.
+         * @param maxRecordSize: maximum record size without delimiter.
+         */
+        TCPDelimiterFramer(char delimiter = '\n', size_t maxRecordSize = TCPNetworkLinux_DEFAULT_MAX_FRAME_SIZE);
+
+        // Set record terminator character.
+        void setDelimiter(char delimiter);
+
+        // Return record terminator character.
+        char getDelimiter(void);
+
+        // Set maximum record size without delimiter.
+        void setMaxRecordSize(size_t size);
+
+        // Return maximum record size without delimiter.
+        size_t getMaxRecordSize(void);
+
+        /**
+         * Decode front record of buffer without removing it.
+         * Storage is linearized only if a record wraps around the end of non mirrored storage. Use mirrored RX buffers to avoid it.
+         * Incomplete records are scanned again on next call, so maximum record size also bounds the scan work.
+         * @param buffer: ring buffer that contains received stream.
+         * @param record: view of record without delimiter. It is valid until buffer is changed.
+         * @return number of bytes of record including delimiter. Remove them by buffer.discard() after record is used.
+         * return 0 if record is not complete. return -1 if no delimiter is found within maximum record size.
+         */
+        ssize_t decode(TCPRingBuffer &buffer, std::string_view &record);
+
+        /**
+         * Decode front record of RX buffer of connection without removing it.
+         * @return number of bytes of record including delimiter. Remove them by connection->consumeRxBuffer() after record is used.
+         * return 0 if record is not complete. return -1 if no delimiter is found within maximum record size.
+         */
+        ssize_t decode(TCPConnection* connection, std::string_view &record);
+
+        /**
+         * Find first delimiter in data by selected scan implementation.
+         * @return pointer to delimiter. return nullptr if data does not contain delimiter.
+         */
+        static const char* find(const char* data, size_t size, char delimiter);
+
+        /**
+         * Select scan implementation for all objects. It is selected automatically at startup.
+         * It is not thread safe. Call it before framers are used by other threads.
+         * @return false if CPU does not support it.
+         */
+        static bool setScanImplementation(TCPScanImplementation implementation);
+
+        // Return selected scan implementation.
+        static TCPScanImplementation getScanImplementation(void);
+
+    private:
+
+        // Record terminator character.
+        char _delimiter;
+
+        // Maximum record size without delimiter.
+        size_t _maxRecordSize;
+};
+
+// ############################################################################################
+// TCPLinkMonitor class:
+
+// Link state and address of one network interface.
+struct TCPLinkState
+{
+    // Interface index. 0 means the table entry is not used.
+    int index;
+
+    // Interface name. eg: eth0
+    char name[IFNAMSIZ];
+
+    // Interface is administratively up. (IFF_UP)
+    bool up;
+
+    // Physical link is detected. Same value as /sys/class/net/<if>/carrier.
+    bool carrier;
+
+    // Primary IPv4 address in network byte order. 0 if interface has no address.
+    uint32_t address;
+};
+
+/**
+ * Interface monitor. It subscribes to rtnetlink link and IPv4 address notifications and keeps a table of link states and addresses.
+ * A thread receives notifications, so cable pull or address change is seen without per call file I/O or getifaddrs() walks.
+ * Table entries are protected by sequence locks: readers of any thread never block and never make a syscall.
+ */
+class TCPLinkMonitor
+{
+    public:
+
+        /**
+         * Handler of changes. It is called by monitor thread after state of an interface is changed.
+         * @param state: new state. index is 0 if interface is removed.
+         */
+        using Handler = std::function<void(const TCPLinkState& state)>;
+
+        // Last error accured for TCPLinkMonitor object.
+        std::string errorMessage;
+
+        // Default constructor. init some variables.
+        TCPLinkMonitor();
+
+        // Destructor. Stop monitor thread.
+        ~TCPLinkMonitor();
+
+        TCPLinkMonitor(const TCPLinkMonitor&) = delete;
+        TCPLinkMonitor& operator=(const TCPLinkMonitor&) = delete;
+
+        /**
+         * Open netlink socket, fill table by dump of all links and addresses and start monitor thread.
+         * @param handler: handler of changes. It can be nullptr.
+         * @return true if successed.
+         */
+        bool start(Handler handler = nullptr);
+
+        // Stop monitor thread and close netlink socket. Table keeps its last state.
+        void stop(void);
+
+        // Return true if monitor thread is running.
+        bool isRunning(void);
+
+        /**
+         * Read state of certain interface. Lock free, it can be called by any thread.
+         * @return false if interface does not exist.
+         */
+        bool getLinkState(const char* interfaceName, TCPLinkState &state);
+
+        // Return true if certain interface is up and its physical link is detected. Lock free.
+        bool isLinkUp(const char* interfaceName);
+
+        // Return primary IPv4 address of certain interface. return empty string if it has no address. Lock free.
+        std::string getIPAddress(const char* interfaceName);
+
+        // Return number of changes since start. Compare it with an old value to detect changes without handler.
+        uint64_t getChangeCount(void);
+
+    private:
+
+        // Table entry. sequence is odd while the writer changes state. Refresh flags of a dump are used only by monitor thread.
+        struct _Entry
+        {
+            std::atomic<uint32_t> sequence;
+            TCPLinkState state;
+            bool linkRefreshed;
+            bool addressRefreshed;
+        };
+
+        // Table of interfaces. Only monitor thread writes it.
+        _Entry _entries[TCPNetworkLinux_LINK_MONITOR_MAX_INTERFACES];
+
+        // Netlink route socket.
+        int _socket;
+
+        // Monitor thread.
+        std::thread _thread;
+
+        // Monitor thread keeps running while it is true.
+        std::atomic<bool> _running;
+
+        // Number of changes since start.
+        std::atomic<uint64_t> _changeCount;
+
+        // Handler of changes.
+        Handler _handler;
+
+        // Sequence number of netlink requests.
+        uint32_t _requestSequence;
+
+        // Dump in progress. 0: none, RTM_GETLINK or RTM_GETADDR.
+        int _dumpType;
+
+        // Notifications were lost while a dump was in progress. A new dump of links and addresses follows it.
+        bool _resyncPending;
+
+        // Loop of monitor thread.
+        void _run(void);
+
+        /**
+         * Send dump request of certain type. (RTM_GETLINK or RTM_GETADDR)
+         * Entries are marked as not refreshed. When dump is done, links that it did not report are removed and addresses it did not report are cleared.
+         */
+        bool _requestDump(int type);
+
+        // Remove links or clear addresses that finished dump did not report.
+        void _sweepEntries(int type);
+
+        // Receive and handle one batch of netlink messages. return false if socket failed.
+        bool _receive(int flags);
+
+        // Update table by link message.
+        void _handleLink(const struct nlmsghdr* message);
+
+        // Update table by address message.
+        void _handleAddress(const struct nlmsghdr* message);
+
+        // Return entry of certain interface index. If create is true a free entry is returned for new index. return nullptr if not found.
+        _Entry* _findEntry(int index, bool create);
+
+        // Read entry by sequence lock.
+        static void _readEntry(const _Entry &entry, TCPLinkState &state);
+
+        // Write entry by sequence lock and notify handler if state is changed.
+        void _writeEntry(_Entry &entry, const TCPLinkState &state);
+};
+
+// ############################################################################################
+// TCPNotifier class:
+
+/**
+ * Wakeup of a thread by eventfd. Notifications that arrive before wait() are not lost, since the counter keeps them.
+ * notify() may be called by any thread. wait() and clear() are used by the thread that owns the notifier.
+ */
+class TCPNotifier
+{
+    public:
+
+        // Last error accured for TCPNotifier object.
+        std::string errorMessage;
+
+        // Default constructor. Descriptor is created by open().
+        TCPNotifier();
+
+        // Destructor. Close descriptor.
+        ~TCPNotifier();
+
+        TCPNotifier(const TCPNotifier&) = delete;
+        TCPNotifier& operator=(const TCPNotifier&) = delete;
+
+        // Create non blocking eventfd descriptor. return true if successed.
+        bool open(void);
+
+        // Close descriptor.
+        void close(void);
+
+        // Return eventfd descriptor. It is readable while notifications are pending. return -1 if it is not open.
+        int getFileDescriptor(void);
+
+        // Wake up the owner thread.
+        void notify(void);
+
+        // Remove pending notifications. return number of notify() calls since last clear.
+        uint64_t clear(void);
+
+        /**
+         * Block until notify() is called and remove pending notifications.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit.
+         * @return true if notified. return false on timeout or signal.
+         */
+        bool wait(int timeoutMs = -1);
+
+    private:
+
+        // eventfd descriptor.
+        int _fileDescriptor;
+};
+
+// ############################################################################################
+// TCPSpscQueue class:
+
+/**
+ * Bounded lock free queue of one producer thread and one consumer thread.
+ * Producer and consumer indexes live on separate cache lines, and each side caches the index of the other side.
+ * Without notifier, a push or pop touches the shared line of the other side only when the queue looks full or empty.
+ * If a notifier is given, push() notifies the consumer only when the queue goes from empty to non empty.
+ * To see that, every push() runs a seq_cst fence and reads consumer index, which is the cost of notifier mode.
+ * The consumer drains by pop() until it fails, then waits on the notifier.
+ */
+template <class T>
+class TCPSpscQueue
+{
+    public:
+
+        /**
+         * Constructor.
+         * @param capacity: maximum number of items. It is rounded up to power of two.
+         * @param notifier: notifier of consumer thread. nullptr means consumer polls.
+         */
+        explicit TCPSpscQueue(size_t capacity, TCPNotifier* notifier = nullptr);
+
+        TCPSpscQueue(const TCPSpscQueue&) = delete;
+        TCPSpscQueue& operator=(const TCPSpscQueue&) = delete;
+
+        // Push item. Producer thread only. return false if queue is full. Item is not moved then.
+        bool push(T &&item);
+
+        // Pop oldest item. Consumer thread only. return false if queue is empty.
+        bool pop(T &item);
+
+        // Return number of items. It is exact only for producer or consumer thread while the other side is idle.
+        size_t size(void) const;
+
+        // Return maximum number of items.
+        size_t capacity(void) const;
+
+    private:
+
+        // Consumer side.
+        alignas(TCPNetworkLinux_CACHE_LINE_SIZE) std::atomic<size_t> _head;     // Free running index of next pop.
+        size_t _cachedTail;                                                     // Last tail seen by consumer.
+
+        // Producer side.
+        alignas(TCPNetworkLinux_CACHE_LINE_SIZE) std::atomic<size_t> _tail;     // Free running index of next push.
+        size_t _cachedHead;                                                     // Last head seen by producer.
+
+        // Read only after construction.
+        alignas(TCPNetworkLinux_CACHE_LINE_SIZE) std::vector<T> _slots;
+        size_t _mask;
+        TCPNotifier* _notifier;
+};
+
+// ############################################################################################
+// TCPMpscQueue class:
+
+/**
+ * Bounded lock free queue of many producer threads and one consumer thread. (sequence numbered slots)
+ * Producers claim slots by one compare and swap on the tail index and publish them by sequence number of the slot,
+ * so a slow producer never blocks other producers. Items of one producer are popped in push order.
+ * If a notifier is given, push() notifies the consumer only when the queue goes from empty to non empty.
+ */
+template <class T>
+class TCPMpscQueue
+{
+    public:
+
+        /**
+         * Constructor.
+         * @param capacity: maximum number of items. It is rounded up to power of two.
+         * @param notifier: notifier of consumer thread. nullptr means consumer polls.
+         */
+        explicit TCPMpscQueue(size_t capacity, TCPNotifier* notifier = nullptr);
+
+        TCPMpscQueue(const TCPMpscQueue&) = delete;
+        TCPMpscQueue& operator=(const TCPMpscQueue&) = delete;
+
+        // Push item. Any thread. return false if queue is full. Item is not moved then.
+        bool push(T &&item);
+
+        // Pop oldest published item. Consumer thread only. return false if queue is empty.
+        bool pop(T &item);
+
+        // Return maximum number of items.
+        size_t capacity(void) const;
+
+    private:
+
+        // One item and its sequence number. Sequence is index when slot is free and index + 1 when item is published.
+        struct _Slot
+        {
+            std::atomic<size_t> sequence;
+            T item;
+        };
+
+        // Consumer side.
+        alignas(TCPNetworkLinux_CACHE_LINE_SIZE) std::atomic<size_t> _head;     // Free running index of next pop.
+
+        // Producer side.
+        alignas(TCPNetworkLinux_CACHE_LINE_SIZE) std::atomic<size_t> _tail;     // Free running index of next claimed slot.
+
+        // Read only after construction.
+        alignas(TCPNetworkLinux_CACHE_LINE_SIZE) std::vector<_Slot> _slots;
+        size_t _mask;
+        TCPNotifier* _notifier;
+};
+
+template <class T>
+TCPSpscQueue<T>::TCPSpscQueue(size_t capacity, TCPNotifier* notifier) : _head(0), _cachedTail(0), _tail(0), _cachedHead(0)
+{
+    size_t slotNum = 1;
+    while (slotNum < capacity)
+    {
+        slotNum <<= 1;
+    }
+
+    _slots.resize(slotNum);
+    _mask = slotNum - 1;
+    _notifier = notifier;
+}
+
+template <class T>
+bool TCPSpscQueue<T>::push(T &&item)
+{
+    size_t tail = _tail.load(std::memory_order_relaxed);
+
+    if (tail - _cachedHead > _mask)
+    {
+        _cachedHead = _head.load(std::memory_order_acquire);
+        if (tail - _cachedHead > _mask)
+        {
+            return false;
+        }
+    }
+
+    _slots[tail & _mask] = std::move(item);
+    _tail.store(tail + 1, std::memory_order_release);
+
+    if (_notifier != nullptr)
+    {
+        // Pairs with fence of pop(). Either consumer sees the item, or this push sees that the consumer drained the queue.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // Acquire, because the full check of next push trusts this head too.
+        _cachedHead = _head.load(std::memory_order_acquire);
+        if (_cachedHead == tail)
+        {
+            _notifier->notify();
+        }
+    }
+
+    return true;
+}
+
+template <class T>
+bool TCPSpscQueue<T>::pop(T &item)
+{
+    size_t head = _head.load(std::memory_order_relaxed);
+
+    if (head == _cachedTail)
+    {
+        // Queue looks empty. Consumer waits after this, so its head must be visible before tail is checked.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        _cachedTail = _tail.load(std::memory_order_acquire);
+        if (head == _cachedTail)
+        {
+            return false;
+        }
+    }
+
+    item = std::move(_slots[head & _mask]);
+    _head.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+template <class T>
+size_t TCPSpscQueue<T>::size(void) const
+{
+    return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+}
+
+template <class T>
+size_t TCPSpscQueue<T>::capacity(void) const
+{
+    return _mask + 1;
+}
+
+template <class T>
+TCPMpscQueue<T>::TCPMpscQueue(size_t capacity, TCPNotifier* notifier) : _head(0), _tail(0)
+{
+    size_t slotNum = 1;
+    while (slotNum < capacity)
+    {
+        slotNum <<= 1;
+    }
+
+    _slots = std::vector<_Slot>(slotNum);
+    for (size_t i = 0; i < slotNum; i++)
+    {
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _mask = slotNum - 1;
+    _notifier = notifier;
+}
+
+template <class T>
+bool TCPMpscQueue<T>::push(T &&item)
+{
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    _Slot* slot;
+
+    while (true)
+    {
+        slot = &_slots[tail & _mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+        if (sequence == tail)
+        {
+            // Slot is free. Claim it, or retry with the tail of the producer that won.
+            if (_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (sequence < tail)
+        {
+            // Slot still holds the item of previous round.
+            return false;
+        }
+        else
+        {
+            tail = _tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->item = std::move(item);
+    slot->sequence.store(tail + 1, std::memory_order_release);
+
+    if (_notifier != nullptr)
+    {
+        // Pairs with fence of pop(). Consumer that waits for this slot is woken up by the producer of this slot.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_head.load(std::memory_order_relaxed) == tail)
+        {
+            _notifier->notify();
+        }
+    }
+
+    return true;
+}
+
+template <class T>
+bool TCPMpscQueue<T>::pop(T &item)
+{
+    size_t head = _head.load(std::memory_order_relaxed);
+    _Slot* slot = &_slots[head & _mask];
+
+    if (slot->sequence.load(std::memory_order_acquire) != head + 1)
+    {
+        // Queue looks empty. Consumer waits after this, so its head must be visible before the slot is checked.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (slot->sequence.load(std::memory_order_acquire) != head + 1)
+        {
+            return false;
+        }
+    }
+
+    item = std::move(slot->item);
+    slot->sequence.store(head + _mask + 1, std::memory_order_release);
+    _head.store(head + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+template <class T>
+size_t TCPMpscQueue<T>::capacity(void) const
+{
+    return _mask + 1;
+}
+
+// ############################################################################################
+// TCPHandler class:
+
+/**
+ * Base of event handlers of TCPServer::runEventLoop(handler). (CRTP: class MyHandler : public TCPHandler<MyHandler>)
+ * The event loop calls functions of Derived type directly, so they can be inlined. There is no virtual dispatch.
+ * Derived class hides only functions it needs. Others are empty.
+ * Events of one iteration are dispatched in order: accept, data, writable, heartbeat, close. 
+ * A connection that is closed in the iteration gets its data and then close.
+ */
+template <class Derived>
+class TCPHandler
+{
+    public:
+
+        // New connection is accepted.
+        void onAccept(TCPServer &server, TCPConnection &connection) { (void)server; (void)connection; }
+
+        /**
+         * New data is received.
+         * @param data: view of all data in RX buffer. It is valid only in this call.
+         * @return number of bytes consumed from front of RX buffer. Remained bytes are passed again with next data.
+         */
+        size_t onData(TCPServer &server, TCPConnection &connection, std::string_view data) { (void)server; (void)connection; (void)data; return 0; }
+
+        /**
+         * Queued TX data is fully sent and TX buffer is empty, or TX queue dropped to low watermark after backpressure refused data.
+         * It is called only after data waited for socket space.
+         */
+        void onWritable(TCPServer &server, TCPConnection &connection) { (void)server; (void)connection; }
+
+        // Nothing is sent on the connection during heartbeat interval. (eg: send a heartbeat message)
+        void onHeartbeat(TCPServer &server, TCPConnection &connection) { (void)server; (void)connection; }
+
+        // Connection is closed. The object is deleted after the next iteration.
+        void onClose(TCPServer &server, TCPConnection &connection, TCPCloseReason reason) { (void)server; (void)connection; (void)reason; }
+};
+
+// ############################################################################################
+// TCPServer class:
+
+// TCP/IP Object for server
+class TCPServer
+{
+    public:
+
+        // Server Port number on which the server listens. eg: 8080
+        int _port; 
+
+        // Server IP address on which the server listens.. Replace with your interface's IP address. eg: "192.168.1.100"                         
+        std::string _ip;  
+
+        // Server interface port name on which the server listens. eg: eth0.
+        std::string _portName; 
+
+        // Last error accured for TCPServer object.
+        std::string errorMessage;
+
+        // Default constructor. init some variables.
+        TCPServer();
+
+        // Destructor. Close server, client and all event loop connections.
+        ~TCPServer();
+
+        TCPServer(const TCPServer&) = delete;
+        TCPServer& operator=(const TCPServer&) = delete;
+
+        /** 
+        * Configures and sets up the server.
+        * Set port number and ip address.
+        * Server start listening in non blocking mode.
+        * @param port: port number for server listening.
+        * @param ip: ip address for certain ethernet port.
+        * @return true if successed.
+        */
+        bool startByIP(const uint16_t port, const char* ip);      
+
+        /** 
+        * Configures and sets up the server.
+        * Set port number and interface name.
+        * Server start listening in non blocking mode.
+        * @param port: port number for server listening.
+        * @param InterfaceName: ethernet port name. eg: eth0, en0.
+        * @return true if successed.
+        */
+        bool startByName(const uint16_t port, const char* InterfaceName);             
+
+        /** 
+        * Configures and sets up the server on a unix domain stream socket for peers on the same host.
+        * Read, write and buffer functions work the same as TCP. Server start listening in non blocking mode.
+        * @param path: socket file path. Stale socket file is removed. Path that starts with '@' is in abstract namespace.
+        * @return true if successed.
+        */
+        bool startByPath(const char* path);
+        
+        /// @brief Print last error accured for server.
+        void printError(void);
+
+        // Reteurn last error accured for server.
+        std::string getError(void);
+
+        /**
+         * Return status of server listening.
+         * @return true if server is listening.
+         *  */ 
+        bool isListening(void);
+
+        /**
+         * Return status of client connection. It is a cached state without any syscall.
+         * Disconnection is detected by read (recv returns 0), send errors and wait functions.
+         * @return true if client is connected.
+         *  */ 
+        bool isClientConnected(void);
+
+        /**
+         * Check ethernet physically cable connected to certain port.
+         * It reads the cached table of link monitor if it is set and running, otherwise /sys/class/net/<if>/carrier.
+         * @return true if ethernet port connected physically.
+         *  */ 
+        bool checkLinkStatus(const char* port_name);   
+
+        /**
+         * Use certain link monitor for checkLinkStatus() and address lookup of startByName(). nullptr disables it.
+         * Monitor is not owned. It must outlive the server or be removed first.
+         */
+        void setLinkMonitor(TCPLinkMonitor* monitor);
+
+        /**
+         * readWrite or send/recieve operation. 
+         * Send txBuffer, receive and store in rxBuffer.
+         * @return true if successed.
+         * */ 
+        bool readWrite(char *txBuffer = nullptr, size_t txSize = 0, char *rxBuffer = nullptr, size_t rxSize = 0);
+
+        /**
+         * read or recieve operation.
+         * Receive and store in a rxBuffer char array.
+         * @param rxSize: number of character for read.
+         * @return number of bytes that read. return -1 if there is any error.
+         *  */  
+        int32_t read(char *rxBuffer, const size_t &rxSize);
+
+        /**
+         * read or recieve operation.
+         * Receive and store all data(max size = rxBufferSize) in a rxBuffer string.
+         * @return number of bytes that read. return -1 if there is any error.
+         *  */ 
+        int32_t read(std::string *rxBuffer);
+
+        /**
+         * read or recieve operation.
+         * Receive data directly in to the ring rxBuffer of server without intermediate copy. *Hint: max size of ring of rxBuffer is limited to rxBufferSize.
+         * With TCPOverflowPolicy::Backpressure, it reads only into free space and returns 0 while rxBuffer is full.
+         * @return number of bytes that read. return -1 if there is any error.
+         *  */ 
+        int32_t read(void);
+
+        /**
+         * Write or send operation.
+         * Data that the socket does not accept (partial write) is queued in TX buffer and sent by next write() calls.
+         * With TCPOverflowPolicy::Backpressure, data that does not fit in TX buffer is refused while TX data is queued and it returns false.
+         * @param txBuffer: pointer to the char array.
+         * @param txSize: number of char that want to send.
+         * @return true if successed.
+         *  */  
+        bool write(const char &txBuffer, const size_t &txSize);
+
+        /**
+         * Write or send operation.
+         * @param txBuffer: pointer to the string that want to send.
+         * @return true if successed.
+         *  */  
+        bool write(const std::string &txBuffer);
+
+        /**
+         * Write or send operation.
+         * Write as much data of TX buffer as the socket accepts and remove only the sent elements.
+         * @return true if successed.
+         *  */  
+        bool write(void);
+
+        /**
+         * Vectored write or send operation.
+         * Send pending TX data and certain list of buffers by one sendmsg call. Unsent bytes are queued in TX buffer.
+         * It is refused like write(txBuffer, txSize) by backpressure.
+         * @param buffers: list of buffers.
+         * @param count: number of buffers.
+         * @return true if successed.
+         *  */  
+        bool write(const struct iovec* buffers, size_t count);
+
+        /**
+         * Send data with file descriptors (SCM_RIGHTS). Unix domain sockets only.
+         * Queued TX data is sent first. Descriptors are not sent if the socket does not accept queued data or first byte of data.
+         * Unsent tail of data is queued in TX buffer.
+         * @param fileDescriptors: list of descriptors. They stay open and owned by caller.
+         * @param count: number of descriptors. Maximum is TCPNetworkLinux_MAX_FILE_DESCRIPTORS.
+         * @param size: size of data. It must be at least one byte.
+         * @return true if descriptors are sent.
+         */
+        bool sendFileDescriptors(const int* fileDescriptors, size_t count, const char* data, size_t size);
+
+        /**
+         * Pop oldest received file descriptor. Unix domain sockets only.
+         * Descriptors are received by read operations together with the data they were sent with.
+         * @return descriptor. Caller owns it. return -1 if no descriptor is received.
+         */
+        int popFileDescriptor(void);
+
+        // Return number of bytes queued in TX buffer. Zero means all data is handed to the kernel.
+        size_t getTxQueuedBytes(void);
+
+        // Close server socket.
+        void serverClose(void);
+
+        // Close client socket.
+        void clientClose(void);
+
+        /**
+         * Try to connect to any client socket.
+         * @return true if client connected.
+         */
+        bool clientConnect(void);
+
+        /**
+         * Block until data or disconnection of client is pending. If no client is connected, block until a connection is pending on server socket.
+         * In event loop mode, block until runEventLoop() has events to handle. With io_uring backend, ready completions or submissions are events.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit.
+         * @return ready events. (TCPNetworkLinux_WAIT_READABLE or TCPNetworkLinux_WAIT_ACCEPT) return 0 on timeout or signal. return -1 if there is any error.
+         */
+        int32_t waitReadable(int timeoutMs = -1);
+
+        /**
+         * Block until client socket accepts more data.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit.
+         * @return TCPNetworkLinux_WAIT_WRITABLE if ready. return 0 on timeout or signal. return -1 if there is any error.
+         */
+        int32_t waitWritable(int timeoutMs = -1);
+
+        /**
+         * Block until data, disconnection or pending connection arrives, or until queued TX data can be sent.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit.
+         * @return ready events. (TCPNetworkLinux_WAIT_...) return 0 on timeout or signal. return -1 if there is any error.
+         */
+        int32_t waitAny(int timeoutMs = -1);
+
+        // Return library version.
+        std::string getVersion(void);
+
+        /**
+         * Set transmit buffer size. If queued data is larger, TCPOverflowPolicy::DropOldest discards oldest bytes,
+         * DropOldestFrames drops whole oldest frames and Backpressure refuses new data until the queue is sent.
+         */
+        void setTxBufferSize(size_t size = 1000);
+
+        // Set receive buffer size. Only TCPOverflowPolicy::DropOldest discards oldest unread bytes if they are more than size.
+        void setRxBufferSize(size_t size = 1000);
+
+        // Return number of character available for read on the server socket.
+        int32_t available(void);
+
+        // Remove certain number character from front of RX ring buffer.
+        void removeFrontRxBuffer(size_t num);
+
+        // Remove certain number character from front of TX ring buffer.
+        void removeFrontTxBuffer(size_t size);
+
+        // Remove all data from RX ring buffer.
+        void removeAllRxBuffer(void);
+
+        // Remove all data from TX ring buffer.
+        void removeAllTxBuffer(void);
+
+        /**
+         * Pop front certain number elements from RX buffer and remove them.
+         * @return string that pop front.
+         *  */
+        std::string popFrontRxBuffer(size_t size);
+
+        /**
+         * Pop front all elements from RX buffer and remove them.
+         * @return string that pop front. Use peekRxBuffer() and consumeRxBuffer() to avoid copy and allocation.
+         *  */
+        std::string popAllRxBuffer(void);
+
+        /**
+         * Return view of all data in RX buffer without copy. Data is moved to be contiguous only if it wraps in storage.
+         * The view is valid until next read or consumeRxBuffer().
+         */
+        std::string_view peekRxBuffer(void);
+
+        /**
+         * Return data in RX buffer as at most two segments without any copy or move.
+         * @return number of non empty segments.
+         */
+        int peekRxBuffer(struct iovec segments[2]);
+
+        // Remove certain number of consumed bytes from front of RX buffer. Use it after peekRxBuffer().
+        void consumeRxBuffer(size_t size);
+
+        /**
+         * Push back certain number character from char array to RX buffer. RX buffer size is handled by overflow policy.
+         * @return true if data is stored. return false if backpressure refused it. (TCPOverflowPolicy::Backpressure)
+         */
+        bool pushBackRxBuffer(const char* data, size_t size);
+
+        /**
+         * Push back certain string to RX buffer.
+         * @return true if data is stored. return false if backpressure refused it.
+         */
+        bool pushBackRxBuffer(const std::string* data);
+
+        /**
+         * Push back certain number character from char array to TX buffer. TX buffer size is handled by overflow policy.
+         * @return true if data is queued. return false if backpressure refused it. (TCPOverflowPolicy::Backpressure)
+         */
+        bool pushBackTxBuffer(const char* data, size_t size);
+
+        /**
+         * Push back certain string to TX buffer.
+         * @return true if data is queued. return false if backpressure refused it.
+         */
+        bool pushBackTxBuffer(const std::string* data);
+
+        /**
+         * Set overflow policy of TX and RX buffers of single client mode and event loop connections. Default is TCPOverflowPolicy::DropOldest.
+         * Buffer sizes are the high watermarks. It is applied to open and new connections.
+         * With backpressure, the largest message must fit in the buffers.
+         */
+        void setOverflowPolicy(TCPOverflowPolicy policy);
+
+        // Return overflow policy of buffers.
+        TCPOverflowPolicy getOverflowPolicy(void);
+
+        /**
+         * Set low watermarks of TCPOverflowPolicy::Backpressure. Blocked TX is reported writable and paused RX is read again
+         * when queued or buffered bytes drop to them. It is applied to open and new connections.
+         * Single client mode uses only RX low watermark: read() does not read again until RX buffer drops to it.
+         * It does not report writable, so TX of single client mode is refused only while data does not fit.
+         * @param txLowWatermark: TX low watermark in bytes of event loop connections. 0 means half of TX buffer size.
+         * @param rxLowWatermark: RX low watermark in bytes. 0 means half of RX buffer size.
+         */
+        void setLowWatermarks(size_t txLowWatermark, size_t rxLowWatermark);
+
+        /**
+         * Start event loop mode on the listening server socket. (epoll, edge triggered)
+         * In this mode the server accepts, reads and writes many client connections by runEventLoop().
+         * Each connection has its own RX/TX buffers. Call it after startByIP() or startByName().
+         * @param maxConnections: maximum number of connections. New connections above this number are closed.
+         * @return true if successed.
+         */
+        bool startEventLoop(size_t maxConnections = TCPNetworkLinux_DEFAULT_MAX_CONNECTIONS, TCPEventBackend backend = TCPEventBackend::Epoll);
+
+        /**
+         * Return backend that event loop actually uses.
+         * It is Epoll if io_uring is requested but not supported. errorMessage has the reason in that case.
+         */
+        TCPEventBackend getEventBackend(void);
+
+        /**
+         * Watch notifier in event loop. runEventLoop() stops waiting and clears the notifier when another thread notifies it.
+         * It may be set before or after startEventLoop(). Only one notifier is watched.
+         * @param notifier: open notifier that lives until it is removed. nullptr removes the watched notifier.
+         * @return true if successed.
+         */
+        bool setNotifier(TCPNotifier* notifier);
+
+        // Stop event loop mode and close all of its connections.
+        void stopEventLoop(void);
+
+        // Return true if event loop mode is started.
+        bool isEventLoopRunning(void);
+
+        /**
+         * Run one iteration of event loop. Wait for ready sockets, accept new clients, 
+         * read ready connections into their RX buffers and flush pending TX buffers of writable connections.
+         * Only ready sockets are processed. Wait time is limited to next expiry of timer wheel and expired timers are handled.
+         * In io_uring backend, sends queued by TCPConnection::write() are submitted as one batch at the start of the next iteration.
+         * @param timeoutMs: maximum wait time in milliseconds. 0 returns immediately, -1 waits without timeout.
+         * @return number of ready events and expired timers. return -1 if there is any error.
+         */
+        int32_t runEventLoop(int timeoutMs = 0);
+
+        /**
+         * Run one iteration of event loop and dispatch its events to handler.
+         * Accepts and closes that happened outside of event loop (startEventLoop(), closeConnection()) are dispatched first.
+         * @param handler: object of class that derives from TCPHandler<Derived>.
+         * @param timeoutMs: maximum wait time in milliseconds. 0 returns immediately, -1 waits without timeout.
+         * @return number of ready events and expired timers. return -1 if there is any error.
+         */
+        template <class Derived>
+        int32_t runEventLoop(TCPHandler<Derived> &handler, int timeoutMs = 0);
+
+        // Return connections that accepted in the last runEventLoop().
+        const std::vector<TCPConnection*>& getAcceptedConnections(void);
+
+        // Return connections that received new data in the last runEventLoop().
+        const std::vector<TCPConnection*>& getReadyConnections(void);
+
+        // Return connections whose queued TX data is fully sent, or whose blocked TX queue dropped to low watermark, by the last runEventLoop().
+        const std::vector<TCPConnection*>& getDrainedConnections(void);
+
+        // Return connections whose heartbeat timer expired in the last runEventLoop().
+        const std::vector<TCPConnection*>& getHeartbeatConnections(void);
+
+        /**
+         * Set idle timeout of event loop connections. A connection that receives nothing during timeout is closed. (TCPCloseReason::IdleTimeout)
+         * It is applied to open and new connections.
+         * @param timeoutMs: timeout in milliseconds. 0 disables it.
+         */
+        void setIdleTimeout(int timeoutMs);
+
+        /**
+         * Set write timeout of event loop connections. A connection whose queued TX data is not fully sent 
+         * during timeout after it is queued is closed. (TCPCloseReason::WriteTimeout)
+         * It is applied to open and new connections.
+         * @param timeoutMs: timeout in milliseconds. 0 disables it.
+         */
+        void setWriteTimeout(int timeoutMs);
+
+        /**
+         * Set heartbeat interval of event loop connections. A connection that sends nothing during interval is reported 
+         * by getHeartbeatConnections() and TCPHandler::onHeartbeat() every interval.
+         * It is applied to open and new connections.
+         * @param intervalMs: interval in milliseconds. 0 disables it.
+         */
+        void setHeartbeatInterval(int intervalMs);
+
+        /**
+         * Return timer wheel of event loop. Application timers armed on it expire in runEventLoop(), 
+         * and wait time of event loop is limited to next expiry. Only thread of event loop may use it.
+         */
+        TCPTimerWheel& getTimerWheel(void);
+
+        // Return connections that closed in the last runEventLoop(). They remain valid until next runEventLoop().
+        const std::vector<TCPConnection*>& getClosedConnections(void);
+
+        // Return connection by its socket descriptor. return nullptr if there is not any connection.
+        TCPConnection* getConnection(int socket);
+
+        // Return number of open event loop connections.
+        size_t getConnectionCount(void);
+
+        // Close certain event loop connection. The object remains valid until next runEventLoop().
+        void closeConnection(int socket);
+
+        /**
+         * Set socket options of listening socket and all accepted sockets. It is used by next startByIP()/startByName().
+         * Accepted sockets get options when they are accepted. Failures are reported in errorMessage.
+         */
+        void setSocketOptions(const TCPSocketOptions &options);
+
+        // Return socket options that are used for server sockets.
+        TCPSocketOptions getSocketOptions(void);
+
+        // Return values of socket options that kernel applied on listening socket.
+        TCPSocketOptions getAppliedSocketOptions(void);
+
+        /**
+         * Return snapshot of hot path statistics of server. It includes single client mode and all event loop connections.
+         * It can be called by any thread.
+         */
+        TCPStatsSnapshot getStats(void);
+
+        // Set all server statistics to zero.
+        void resetStats(void);
+
+        /**
+         * Return statistics in Prometheus text exposition format. Series have server="ip:port" label.
+         * Occupancy of TCPBufferPool is appended without labels.
+         * @param perConnection: also add series of every event loop connection with connection="ip:port" label. 
+         * Only thread of event loop may use it.
+         */
+        std::string getStatsPrometheus(bool perConnection = false);
+
+        /**
+         * Write statistics periodically in Prometheus text format to certain file by runEventLoop(). (eg: node exporter textfile collector)
+         * File is replaced atomically by rename of a temporary file.
+         * @param path: file path. Empty path disables dump.
+         * @param intervalMs: dump interval in milliseconds.
+         * @param perConnection: also add series of every event loop connection.
+         */
+        void setStatsDump(const std::string &path, int intervalMs, bool perConnection = false);
+    
+    private:
+
+        friend class TCPShardedServer;
+        friend class TCPWaitSet;
+
+        TCPRingBuffer _txBuffer;           // TX ring buffer.
+        TCPRingBuffer _rxBuffer;           // RX ring buffer.
+
+        size_t _txBufferSize;              // Max size for tx ring buffer.
+        size_t _rxBufferSize;              // Max size for rx ring buffer.
+
+        // Overflow policy of buffers and low watermarks of backpressure. 0 low watermark means half of buffer size.
+        TCPOverflowPolicy _overflowPolicy;
+        size_t _txLowWatermark;
+        size_t _rxLowWatermark;
+
+        // Frame sizes of TX buffer of single client mode. (TCPOverflowPolicy::DropOldestFrames)
+        TCPFrameTracker _txFrames;
+
+        // Reading of single client mode stopped since rxBuffer was full. It starts again at RX low watermark.
+        bool _rxPaused;
+        
+        // Integer representing the server's socket descriptor.
+        int _serverSocket;             
+
+        // Integer representing the client's socket descriptor. 
+        int _clientSocket;                            
+
+        // Integer representing the epoll descriptor of event loop.
+        int _epollSocket;
+
+        // Notifier that wakes up event loop. nullptr if it is not set.
+        TCPNotifier* _notifier;
+
+        // Socket path of unix domain server. Empty for TCP server.
+        std::string _unixPath;
+
+        // Received file descriptors of client that are not popped yet.
+        std::vector<int> _rxFileDescriptors;
+
+        // Create listening socket for certain address, bind and listen in non blocking mode.
+        bool _startListening(const struct sockaddr* address, socklen_t addressLength);
+
+        // Link monitor for cached link state and address lookup. nullptr if it is not set.
+        TCPLinkMonitor* _linkMonitor;
+
+        // Socket options of listening and accepted sockets.
+        TCPSocketOptions _socketOptions;
+
+        // Hot path statistics of server.
+        TCPStats _stats;
+
+        // Periodic statistics dump file path. Empty if disabled.
+        std::string _statsDumpPath;
+
+        // Periodic statistics dump interval.
+        std::chrono::milliseconds _statsDumpInterval;
+
+        // Time of next periodic statistics dump.
+        std::chrono::steady_clock::time_point _statsDumpTime;
+
+        // Add connection series into periodic statistics dump.
+        bool _statsDumpPerConnection;
+
+        // Write statistics dump file if its interval is passed.
+        void _dumpStats(void);
+
+        // Block in poll until certain events are ready. return ready events, 0 on timeout, -1 on error.
+        int32_t _wait(uint32_t events, int timeoutMs);
+
+        /**
+         * Fill poll entries for certain wait events.
+         * @param pollSockets: array with space for two entries.
+         * @param timeoutMs: wait time. It is set to 0 if io_uring event loop has work that does not wait for a completion.
+         * @return number of filled entries. return -1 if there is any error.
+         */
+        int _pollPrepare(uint32_t events, struct pollfd* pollSockets, int &timeoutMs);
+
+        // Return ready wait events from result of poll entries that _pollPrepare() filled.
+        uint32_t _pollComplete(uint32_t events, const struct pollfd* pollSockets, int count);
+
+        // Maximum number of event loop connections.
+        size_t _maxConnections;
+
+        // Number of open event loop connections.
+        size_t _connectionCount;
+
+        // Event loop connection table. Indexed by socket descriptor.
+        std::vector<TCPConnection*> _connections;
+
+        // Connections that accepted in the last event loop iteration.
+        std::vector<TCPConnection*> _acceptedConnections;
+
+        // Connections that received data in the last event loop iteration.
+        std::vector<TCPConnection*> _readyConnections;
+
+        // Connections whose queued TX data is fully sent in the last event loop iteration.
+        std::vector<TCPConnection*> _drainedConnections;
+
+        // Connections whose heartbeat timer expired in the last event loop iteration.
+        std::vector<TCPConnection*> _heartbeatConnections;
+
+        // Timer wheel of event loop.
+        TCPTimerWheel _timers;
+
+        // Idle timeout, write timeout and heartbeat interval of connections. 0 disables them. [ms]
+        int _idleTimeout;
+        int _writeTimeout;
+        int _heartbeatInterval;
+
+        // Arm or cancel idle and heartbeat timers of connection by current settings.
+        void _armConnectionTimers(TCPConnection* connection);
+
+        // Expiry callbacks of connection timers. context is the connection.
+        static void _onIdleTimer(TCPTimer &timer, void* context);
+        static void _onWriteTimer(TCPTimer &timer, void* context);
+        static void _onHeartbeatTimer(TCPTimer &timer, void* context);
+
+        // Connections that closed in the last event loop iteration. Deleted at next iteration.
+        std::vector<TCPConnection*> _closedConnections;
+
+        // Number of front elements of accepted and closed lists that are dispatched to a handler.
+        size_t _acceptedDispatched;
+        size_t _closedDispatched;
+
+        // Event list for epoll_wait.
+        std::vector<struct epoll_event> _events;
+
+        // io_uring backend state. nullptr if event loop uses epoll.
+        TCPIoUring* _uring;
+
+        // Connections with TX data waiting for io_uring batch submission.
+        std::vector<TCPConnection*> _txDeferred;
+
+        // Multishot accept or notifier poll ended while io_uring submission queue was full. Next iteration arms them again.
+        bool _uringAcceptRearm;
+        bool _uringNotifierRearm;
+
+        // Closed connections that still have in flight io_uring requests.
+        std::vector<TCPConnection*> _zombieConnections;
+
+        // Accept all pending client connections for event loop. (Edge triggered mode)
+        void _acceptConnections(void);
+
+        // Create connection object for accepted socket and add it into table. return nullptr if maximum number of connections reached.
+        TCPConnection* _addConnection(int socket, const struct sockaddr_in &address);
+
+        // Add connection into ready connections list once per iteration.
+        void _markReady(TCPConnection* connection);
+
+        // Add connection into drained connections list once per iteration.
+        void _markDrained(TCPConnection* connection);
+
+        // Paused connections whose RX buffer dropped to low watermark. (TCPOverflowPolicy::Backpressure)
+        std::vector<TCPConnection*> _rxResumed;
+
+        // Blocked connections that write() unblocked. The event loop reports them as drained.
+        std::vector<TCPConnection*> _txUnblocked;
+
+        // Move connections of unblock list into drained connections list.
+        void _markUnblocked(void);
+
+        // Read again from resumed connections. return number of connections that received data.
+        int _resumeConnections(void);
+
+        // Apply overflow policy and low watermarks to connection.
+        void _applyOverflowPolicy(TCPConnection* connection);
+
+        // Check backpressure of single client mode before certain number of bytes are queued. return false if they do not fit.
+        bool _admitTx(size_t size);
+
+        // Record offered TX data of single client mode as a frame. (TCPOverflowPolicy::DropOldestFrames)
+        void _recordTxFrame(size_t size);
+
+        // Dispatch accepts that are not dispatched yet to handler.
+        template <class Derived>
+        void _dispatchAccepted(Derived &handler);
+
+        // Dispatch closes that are not dispatched yet to handler.
+        template <class Derived>
+        void _dispatchClosed(Derived &handler);
+
+        // Start io_uring backend. return false if kernel does not support needed features.
+        bool _startIoUring(void);
+
+        // Stop io_uring backend after all of its requests are completed.
+        void _stopIoUring(void);
+
+        // Submit queued sends, wait for completions and handle them.
+        int32_t _runIoUring(int timeoutMs);
+
+        // Handle all available io_uring completions. return number of completions.
+        int32_t _handleIoUringCompletions(void);
+
+        // Return true if io_uring event loop has work that does not wait for a completion.
+        bool _hasIoUringWork(void);
+
+        // Queue multishot accept request on server socket. return false if submission queue is full.
+        bool _armIoUringAccept(void);
+
+        // Queue multishot poll request on descriptor of notifier. return false if submission queue is full.
+        bool _armIoUringNotifier(void);
+
+        // Add descriptor of notifier to epoll. return true if successed.
+        bool _watchNotifier(void);
+
+        /**
+         * Queue multishot recv request on connection socket. It is one shot and limited to free RX space with backpressure.
+         * If submission queue is full, connection goes to resume list and next iteration arms it.
+         */
+        void _armIoUringRecv(TCPConnection* connection);
+
+        // Pause reading of connection and cancel its recv if a multishot recv is still armed. (TCPOverflowPolicy::Backpressure)
+        void _pauseIoUringRecv(TCPConnection* connection);
+
+        // Queue one send request for every connection in deferred send list. Connections stay in the list while submission queue is full.
+        void _submitIoUringSends(void);
+
+        /**
+         * Remove connection from table and epoll and move it into closed connections list.
+         * @param reason: reason of closing if connection does not have a reason already.
+         */
+        void _removeConnection(TCPConnection* connection, TCPCloseReason reason);
+
+        // Delete closed connections of last event loop iteration.
+        void _deleteClosedConnections(void);
+
+        /**
+         * Accepts a client connection. [ Non blocking mode.]
+         * @return true if successfully connected to a client
+         *  */ 
+        bool _clientConfig(void);                
+        
+        // Handles client disconnection
+        void _handleClientDisconnection(void);  
+
+        // Handles server disconnection
+        void _handleServerDisconnection(void);
+
+        // Send queued TX data until it is empty or the socket would block.
+        bool _flushTxBuffer(void);
+
+};
+
+template <class Derived>
+int32_t TCPServer::runEventLoop(TCPHandler<Derived> &handler, int timeoutMs)
+{
+    Derived &derived = static_cast<Derived&>(handler);
+
+    // Connections of these lists are deleted or forgotten by next iteration.
+    _dispatchAccepted(derived);
+    _dispatchClosed(derived);
+
+    int32_t eventNum = runEventLoop(timeoutMs);
+    if (eventNum < 0)
+    {
+        return eventNum;
+    }
+
+    _dispatchAccepted(derived);
+
+    for (size_t i = 0; i < _readyConnections.size(); i++)
+    {
+        TCPConnection* connection = _readyConnections[i];
+        std::string_view data = connection->peekRxBuffer();
+        if (!data.empty())
+        {
+            connection->consumeRxBuffer(std::min(derived.onData(*this, *connection, data), data.size()));
+        }
+    }
+
+    for (size_t i = 0; i < _drainedConnections.size(); i++)
+    {
+        TCPConnection* connection = _drainedConnections[i];
+        if (connection->_connected)
+        {
+            derived.onWritable(*this, *connection);
+        }
+    }
+
+    for (size_t i = 0; i < _heartbeatConnections.size(); i++)
+    {
+        TCPConnection* connection = _heartbeatConnections[i];
+        if (connection->_connected)
+        {
+            derived.onHeartbeat(*this, *connection);
+        }
+    }
+
+    _dispatchClosed(derived);
+
+    return eventNum;
+}
+
+template <class Derived>
+void TCPServer::_dispatchAccepted(Derived &handler)
+{
+    for (; _acceptedDispatched < _acceptedConnections.size(); _acceptedDispatched++)
+    {
+        handler.onAccept(*this, *_acceptedConnections[_acceptedDispatched]);
+    }
+}
+
+template <class Derived>
+void TCPServer::_dispatchClosed(Derived &handler)
+{
+    // Handler may close other connections, so the list can grow while it is dispatched.
+    for (; _closedDispatched < _closedConnections.size(); _closedDispatched++)
+    {
+        TCPConnection* connection = _closedConnections[_closedDispatched];
+        handler.onClose(*this, *connection, connection->_closeReason);
+    }
+}
+
+// ############################################################################################
+// TCPShardedServer class:
+
+/**
+ * Multi threaded server. It starts N TCPServer shards in event loop mode on the same ip and port.
+ * Every shard has its own listening socket (SO_REUSEPORT), worker thread and event loop, so the kernel spreads
+ * new connections across shards and a connection is handled by one thread for its whole life.
+ */
+class TCPShardedServer
+{
+    public:
+
+        /**
+         * Handler of shard worker thread. It is called after every event loop iteration of the shard.
+         * @param server: event loop server of shard. It is used only by the shard thread.
+         * @param shardIndex: index of shard.
+         */
+        using Handler = std::function<void(TCPServer& server, size_t shardIndex)>;
+
+        // Last error accured for TCPShardedServer object.
+        std::string errorMessage;
+
+        // Default constructor. init some variables.
+        TCPShardedServer();
+
+        // Destructor. Stop all shards.
+        ~TCPShardedServer();
+
+        TCPShardedServer(const TCPShardedServer&) = delete;
+        TCPShardedServer& operator=(const TCPShardedServer&) = delete;
+
+        /**
+         * Start shards and their worker threads.
+         * @param port: port number for server listening.
+         * @param ip: ip address for certain ethernet port.
+         * @param shardCount: number of shards. Zero means one shard per CPU that the process may run on.
+         * @param handler: handler that is called by worker threads.
+         * @param cpuSteering: pin shard i to i-th CPU that the process may run on and keep every new connection on the shard of the CPU that processes its packets.
+         * Every online CPU may process packets, so it needs one shard per online CPU and an affinity mask of all online CPUs.
+         * It uses a reuseport BPF program and falls back to SO_INCOMING_CPU. errorMessage has the reason if steering is not available.
+         * Shards stay pinned only while steering is enabled.
+         * @param backend: event loop backend of shards.
+         * @param maxConnections: maximum number of connections of each shard.
+         * @return true if successed.
+         */
+        bool start(const uint16_t port, const char* ip, size_t shardCount, Handler handler, bool cpuSteering = false,
+                   TCPEventBackend backend = TCPEventBackend::Epoll, size_t maxConnections = TCPNetworkLinux_DEFAULT_MAX_CONNECTIONS);
+
+        // Set socket options of all shards. It is used by next start().
+        void setSocketOptions(const TCPSocketOptions &options);
+
+        // Stop worker threads, close all shards and their connections.
+        void stop(void);
+
+        // Return true if worker threads are running.
+        bool isRunning(void);
+
+        // Return true if connections are steered to shards by CPU.
+        bool isCpuSteering(void);
+
+        // Return number of shards.
+        size_t getShardCount(void);
+
+        /**
+         * Return server of certain shard. return nullptr if index is not valid.
+         * It must not be used by other threads while worker threads are running.
+         */
+        TCPServer* getShard(size_t index);
+
+    private:
+
+        // Shard servers. Index of listening socket in reuseport group is the shard index.
+        std::vector<TCPServer*> _shards;
+
+        // Worker threads. One thread per shard.
+        std::vector<std::thread> _threads;
+
+        // Handler of worker threads.
+        Handler _handler;
+
+        // Worker threads run while it is true.
+        std::atomic<bool> _running;
+
+        // Connections are steered to shards by CPU.
+        bool _cpuSteering;
+
+        // Socket options of shards.
+        TCPSocketOptions _socketOptions;
+
+        // Worker thread function of certain shard.
+        void _runShard(size_t index);
+
+        /**
+         * Steer connections to shards by CPU of received packets. return false if kernel does not support it.
+         * @param cpus: CPU of every shard.
+         */
+        bool _attachCpuSteering(const std::vector<int> &cpus);
+};
+
+// ############################################################################################
+// TCPWorkerPipeline class:
+
+// Framed message between I/O thread and workers of TCPWorkerPipeline.
+struct TCPPipelineMessage
+{
+    int socket = -1;                // Connection socket. It is the connection id in the TCPServer table.
+    uint64_t generation = 0;        // Accept number of the connection. Replies to a closed connection whose socket is reused are dropped.
+    std::string payload;            // Frame payload without header.
+};
+
+/**
+ * Hand off of received messages to worker threads. TCPServer is not thread safe, so one I/O thread owns the server and its sockets.
+ * The I/O thread calls run(). It decodes frames of received data by TCPFrameCodec and pushes them into the SPSC queue of a worker.
+ * All frames of a connection go to the same worker, so they are handled in order.
+ * Workers push replies into one MPSC queue. The I/O thread drains it, encodes all replies of a connection in one pass and sends them by one write.
+ * Every queue wakes its consumer by eventfd only when it goes from empty to non empty. The reply queue wakes the event loop of the server.
+ * A connection whose worker queue is full keeps its frames in RX buffer, so backpressure of RX buffer slows down the peer.
+ */
+class TCPWorkerPipeline
+{
+    public:
+
+        /**
+         * Handler of worker threads. It is called once for every received frame.
+         * @param pipeline: the pipeline. Handler replies by pipeline.reply().
+         * @param workerIndex: index of worker thread.
+         * @param message: received message. It can be moved into reply after payload is replaced.
+         */
+        using Handler = std::function<void(TCPWorkerPipeline& pipeline, size_t workerIndex, TCPPipelineMessage& message)>;
+
+        // Last error accured for TCPWorkerPipeline object.
+        std::string errorMessage;
+
+        // Default constructor. init some variables.
+        TCPWorkerPipeline();
+
+        // Destructor. Stop worker threads.
+        ~TCPWorkerPipeline();
+
+        TCPWorkerPipeline(const TCPWorkerPipeline&) = delete;
+        TCPWorkerPipeline& operator=(const TCPWorkerPipeline&) = delete;
+
+        // Set capacity of every worker queue and of the reply queue. It is used by next start(). default: TCPNetworkLinux_DEFAULT_PIPELINE_QUEUE_SIZE
+        void setQueueCapacity(size_t capacity);
+
+        // Set frame format of messages. It is used by next start().
+        void setFrameCodec(const TCPFrameCodec &codec);
+
+        /**
+         * Start worker threads. Event loop of server must be started and the calling thread becomes the I/O thread.
+         * @param server: event loop server. Only the I/O thread may use it until stop().
+         * @param workerCount: number of worker threads. Zero means one worker per online CPU.
+         * @param handler: handler that is called by worker threads.
+         * @return true if successed.
+         */
+        bool start(TCPServer &server, size_t workerCount, Handler handler);
+
+        /**
+         * Run one iteration of I/O thread: event loop of server, hand off of received frames and sending of replies.
+         * Connections of the server lists are valid like after TCPServer::runEventLoop(). Ready connections are consumed by the pipeline.
+         * A connection with invalid frame is closed.
+         * @param timeoutMs: maximum wait time in milliseconds. Replies of workers end the wait.
+         * @return number of handled events. return -1 if there is any error.
+         */
+        int32_t run(int timeoutMs = -1);
+
+        /**
+         * Queue reply of a worker. Any thread may call it.
+         * @param message: socket and generation of received message and payload of reply.
+         * @return false if reply queue is full. message is not moved then and can be pushed again.
+         */
+        bool reply(TCPPipelineMessage &&message);
+
+        // Stop and join worker threads. Messages that are not handled are dropped.
+        void stop(void);
+
+        // Return true if worker threads are running.
+        bool isRunning(void);
+
+        // Return number of worker threads.
+        size_t getWorkerCount(void);
+
+        // Return number of replies that were dropped since their connection was closed.
+        uint64_t getDroppedReplies(void);
+
+    private:
+
+        // Queue, notifier and thread of one worker.
+        struct _Worker
+        {
+            TCPNotifier notifier;
+            TCPSpscQueue<TCPPipelineMessage>* queue = nullptr;
+            std::thread thread;
+        };
+
+        // Server that the I/O thread owns.
+        TCPServer* _server;
+
+        // Workers.
+        std::vector<_Worker*> _workers;
+
+        // Replies of workers. Its notifier wakes the event loop.
+        TCPMpscQueue<TCPPipelineMessage>* _replies;
+        TCPNotifier _replyNotifier;
+
+        // Handler of worker threads.
+        Handler _handler;
+
+        // Worker threads run while it is true.
+        std::atomic<bool> _running;
+
+        // Frame format of messages.
+        TCPFrameCodec _codec;
+
+        // Capacity of queues.
+        size_t _queueCapacity;
+
+        // Accept number of connections indexed by socket.
+        std::vector<uint64_t> _generations;
+        uint64_t _acceptNum;
+
+        // Connections whose worker queue was full. Their frames wait in RX buffer. (socket, generation)
+        std::vector<std::pair<int, uint64_t>> _stalled;
+
+        // Replies that are drained but not sent yet. Refused replies of a blocked TX buffer stay here in order.
+        std::vector<TCPPipelineMessage> _pendingReplies;
+
+        // Frames of one reply batch.
+        std::vector<struct iovec> _frames;
+
+        uint64_t _droppedReplies;
+
+        // Worker thread function of certain worker.
+        void _runWorker(size_t index);
+
+        // Push received frames of connection to its worker. return false if worker queue is full.
+        bool _dispatch(TCPConnection* connection);
+
+        // Return connection of certain socket and generation. return nullptr if it is closed.
+        TCPConnection* _findConnection(int socket, uint64_t generation);
+
+        // Drain reply queue and send replies of every connection by one write.
+        void _sendReplies(void);
+};
+
+// ############################################################################################
+// TCPClient class:
+
+class TCPClient
+{
+    public:
+
+        // Destructor
+        ~TCPClient() {
+            clientClose();
+        }
+
+        /*
+        Configures and sets up the client.
+        Set port and ip address.
+        Client connection is in non blocking mode. It starts connect and returns without waiting for handshake.
+        Connect state is Connecting until updateConnect() or waitConnect() reports completion or the deadline passes.
+        */
+        bool start(int port, const char* ip);                 
+
+        /*
+        Configures and sets up the client on a unix domain stream socket. 
+        path: socket file path of server. Path that starts with '@' is in abstract namespace.
+        Connect of unix domain sockets is completed immediately. It fails if backlog of server is full.
+        */
+        bool startByPath(const char* path);
+        
+        // Update send/recieve operation. 
+        // Send txBuffer, receive and store in rxBuffer.
+        // No data is sent or received while connect is in progress.
         bool update(char *txBuffer, int txSize, char *rxBuffer, int rxSize);
 
-        /// @brief Print last error accured in methods of server.
-        void printError(void);
+        /**
+         * read or recieve operation. [ Non blocking mode.]
+         * Receive and store in a rxBuffer char array.
+         * @param rxSize: maximum number of character for read.
+         * @return number of bytes that read. return 0 if no data is available or connect is in progress. 
+         * return -1 if server disconnected or there is any error.
+         *  */
+        int32_t read(char *rxBuffer, size_t rxSize);
+
+        /// @brief Print last error accured in methods of server.
+        void printError(void);
+
+        // Return true if connect handshake is completed. It checks connect progress without waiting.
+        bool isClientConnected(void);
+
+        /**
+         * Set connect deadline for next start(). 
+         * @param timeoutMs: time from start() to connect completion in milliseconds. -1 means no deadline.
+         */
+        void setConnectTimeout(int timeoutMs);
+
+        // Return connect state.
+        TCPConnectState getConnectState(void);
+
+        /**
+         * Drive connect state machine. Wait for socket writability and read SO_ERROR to complete connect.
+         * @param timeoutMs: maximum wait time in milliseconds. It is limited to the connect deadline. 0 returns immediately, -1 waits until deadline.
+         * @return connect state.
+         */
+        TCPConnectState updateConnect(int timeoutMs = 0);
+
+        /**
+         * Drive connect state machines of many clients by one poll call, so connects complete in parallel.
+         * @param clients: list of clients.
+         * @param count: number of clients.
+         * @param timeoutMs: maximum wait time in milliseconds. It is limited to the nearest connect deadline. -1 waits until a client completes.
+         * @return number of clients that are still connecting. return -1 if there is any error.
+         */
+        static int32_t waitConnect(TCPClient* const* clients, size_t count, int timeoutMs);
+
+        /**
+         * Block until data or disconnection is pending on client socket.
+         * While connect is in progress, completion or failure of connect is reported by TCPNetworkLinux_WAIT_CONNECT. Wait is limited to the connect deadline.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit.
+         * @return ready events. return 0 on timeout or signal. return -1 if there is any error.
+         */
+        int32_t waitReadable(int timeoutMs = -1);
+
+        /**
+         * Block until client socket accepts more data. Completion of connect is reported by TCPNetworkLinux_WAIT_CONNECT too.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit.
+         * @return ready events. return 0 on timeout or signal. return -1 if there is any error.
+         */
+        int32_t waitWritable(int timeoutMs = -1);
+
+        /**
+         * Block until data, disconnection or connect completion arrives, or until queued TX data can be sent.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit.
+         * @return ready events. (TCPNetworkLinux_WAIT_...) return 0 on timeout or signal. return -1 if there is any error.
+         */
+        int32_t waitAny(int timeoutMs = -1);
+
+        /**
+         * Set socket options of client socket. It is used by next start() and applied before connect.
+         * listenBacklog is not used.
+         */
+        void setSocketOptions(const TCPSocketOptions &options);
+
+        // Return values of socket options that kernel applied on client socket.
+        TCPSocketOptions getAppliedSocketOptions(void);
+
+        // Close client socket.
+        void clientClose(void);
+
+        std::string getVersion(void);
+
+        /**
+         * Push back certain number character from char array to TX buffer. Nothing is sent until write() is called.
+         */
+        void pushBackTxBuffer(const char* data, size_t size);
+
+        /**
+         * Write or send operation.
+         * Send all queued TX data by one sendmsg call and remove only the sent elements.
+         * @return true if successed.
+         *  */  
+        bool write(void);
+
+        /**
+         * Vectored write or send operation.
+         * Send pending TX data and certain list of buffers by one sendmsg call. Unsent bytes are queued in TX buffer.
+         * @param buffers: list of buffers.
+         * @param count: number of buffers.
+         * @return true if successed.
+         *  */  
+        bool write(const struct iovec* buffers, size_t count);
+
+        /**
+         * Send data with file descriptors (SCM_RIGHTS). Unix domain sockets only.
+         * Queued TX data is sent first. Descriptors are not sent if the socket does not accept queued data or first byte of data.
+         * Unsent tail of data is queued in TX buffer.
+         * @param fileDescriptors: list of descriptors. They stay open and owned by caller.
+         * @param count: number of descriptors. Maximum is TCPNetworkLinux_MAX_FILE_DESCRIPTORS.
+         * @param size: size of data. It must be at least one byte.
+         * @return true if descriptors are sent.
+         */
+        bool sendFileDescriptors(const int* fileDescriptors, size_t count, const char* data, size_t size);
+
+        /**
+         * Pop oldest received file descriptor. Unix domain sockets only.
+         * Descriptors are received by read operations together with the data they were sent with.
+         * @return descriptor. Caller owns it. return -1 if no descriptor is received.
+         */
+        int popFileDescriptor(void);
+
+        // Return number of bytes queued in TX buffer. Zero means all data is handed to the kernel.
+        size_t getTxQueuedBytes(void);
+
+    private:
+
+        friend class TCPWaitSet;
+        friend class TCPClientPool;
+
+        // TX ring buffer. Queue of data that is not sent yet.
+        TCPRingBuffer _txBuffer;
+
+        ssize_t bytesRead, bytesSent;       
+
+        // Integer representing the client's socket descriptor. 
+        int clientSocket = -1;              
+
+        // Connect state.
+        TCPConnectState _connectState = TCPConnectState::Disconnected;
+
+        // Socket options of client socket.
+        TCPSocketOptions _socketOptions;
+
+        // Connect timeout of start(). [ms] -1 means no deadline.
+        int _connectTimeout = TCPNetworkLinux_DEFAULT_CONNECT_TIMEOUT;
+
+        // Time point that connect fails if handshake is not completed.
+        std::chrono::steady_clock::time_point _connectDeadline;
+
+        // Server Port number on which the server listens. eg: 8080
+        int _port; 
+
+        // Server IP address on which the server listens.. Replace with your interface's IP address. eg: "192.168.1.100"                         
+        std::string _ip;                    
+
+        // Client socket is a unix domain socket. _ip is the socket path in that case.
+        bool _unix = false;
+
+        // Received file descriptors that are not popped yet.
+        std::vector<int> _rxFileDescriptors;
+
+        // Create socket for certain server address and start non blocking connect.
+        bool _connect(const struct sockaddr* address, socklen_t addressLength);
+
+        // Last error accured in methods of server.
+        std::string errorMessage;
+
+        // Accepts a client connection. [ No blocking mode.]
+        bool clientConfig(void);                
+        
+        // Handles client disconnection
+        void handleClientDisconnection(void);  
+
+        // Return milliseconds until connect deadline. return -1 if there is no deadline.
+        int connectRemainingTime(void);
+
+        // Complete connect by SO_ERROR of writable or failed socket and update connect state.
+        void completeConnect(void);
+
+        // Block in poll until certain events are ready. return ready events, 0 on timeout, -1 on error.
+        int32_t _wait(uint32_t events, int timeoutMs);
+
+        /**
+         * Fill poll entry for certain wait events.
+         * @param pollSockets: array with space for one entry.
+         * @param timeoutMs: wait time. It is limited to the connect deadline while connect is in progress.
+         * @return number of filled entries. return -1 if there is any error.
+         */
+        int _pollPrepare(uint32_t events, struct pollfd* pollSockets, int &timeoutMs);
+
+        // Return ready wait events from result of poll entry that _pollPrepare() filled. It drives connect state machine.
+        uint32_t _pollComplete(uint32_t events, const struct pollfd* pollSockets, int count);
+
+};
+
+// ############################################################################################
+// TCPWaitSet class:
+
+/**
+ * Wait for events of many TCPServer and TCPClient objects by one poll call.
+ * Objects are not owned. Remove them before they are destroyed.
+ */
+class TCPWaitSet
+{
+    public:
+
+        // Last error accured for TCPWaitSet object.
+        std::string errorMessage;
+
+        /**
+         * Add server to the set. Events of an already added server are replaced.
+         * @param events: wait events. (TCPNetworkLinux_WAIT_...)
+         */
+        void add(TCPServer* server, uint32_t events = TCPNetworkLinux_WAIT_ANY);
+
+        /**
+         * Add client to the set. Events of an already added client are replaced.
+         * @param events: wait events. (TCPNetworkLinux_WAIT_...)
+         */
+        void add(TCPClient* client, uint32_t events = TCPNetworkLinux_WAIT_ANY);
+
+        // Remove server from the set.
+        void remove(TCPServer* server);
+
+        // Remove client from the set.
+        void remove(TCPClient* client);
+
+        // Remove all objects from the set.
+        void clear(void);
+
+        // Return number of objects in the set.
+        size_t size(void);
+
+        /**
+         * Block until any object of the set has ready events. Disconnected clients and closed servers are skipped.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit. It is limited to the nearest connect deadline of clients.
+         * @return number of objects with ready events. return 0 on timeout or signal. return -1 if there is any error.
+         */
+        int32_t wait(int timeoutMs = -1);
+
+        // Return ready events of server in last wait(). return 0 if server is not in the set.
+        uint32_t getReadyEvents(TCPServer* server);
+
+        // Return ready events of client in last wait(). return 0 if client is not in the set.
+        uint32_t getReadyEvents(TCPClient* client);
+
+    private:
+
+        // One object of the set.
+        struct _Member
+        {
+            TCPServer* server;          // Server or nullptr.
+            TCPClient* client;          // Client or nullptr.
+            uint32_t events;            // Wait events.
+            uint32_t readyEvents;       // Ready events of last wait().
+            size_t pollIndex;           // First poll entry of the object in last wait().
+            int pollCount;              // Number of poll entries of the object in last wait().
+        };
+
+        // Objects of the set.
+        std::vector<_Member> _members;
+
+        // Poll entries of all objects. Rebuilt by every wait() since sockets change by reconnects.
+        std::vector<struct pollfd> _pollSockets;
+
+        // Return member of certain server or client. return nullptr if it does not exist.
+        _Member* _find(const TCPServer* server, const TCPClient* client);
+};
+
+// ############################################################################################
+// TCPClientPool class:
+
+/**
+ * Pool of persistent client connections to one server. Every connection has its own non blocking connect, TX buffer and RX buffer,
+ * so a slow stream does not block requests that are dispatched to other connections.
+ * Requests are dispatched to the connected connection with fewest outstanding requests, then fewest queued TX bytes.
+ * Failed connections are opened again by update() after the reconnect interval. All methods must be used by one thread.
+ */
+class TCPClientPool
+{
+    public:
+
+        // Last error accured for TCPClientPool object.
+        std::string errorMessage;
+
+        // Default constructor.
+        TCPClientPool();
+
+        // Destructor. Close all connections.
+        ~TCPClientPool();
+
+        TCPClientPool(const TCPClientPool&) = delete;
+        TCPClientPool& operator=(const TCPClientPool&) = delete;
+
+        /**
+         * Open certain number of connections to server ip and port. Connects run in parallel and are completed by update() or waitConnected().
+         * A connection that fails to start is opened again by update().
+         * @return true if successed. return false if address is invalid or pool is already started.
+         */
+        bool start(int port, const char* ip, size_t connectionCount);
+
+        /**
+         * Open certain number of connections to a unix domain stream socket.
+         * @param path: socket file path of server. Path that starts with '@' is in abstract namespace.
+         * @return true if successed. return false if path is invalid or pool is already started.
+         */
+        bool startByPath(const char* path, size_t connectionCount);
+
+        // Close all connections. Pool can be started again.
+        void close(void);
+
+        // Set socket options of connections. It is used by next connects.
+        void setSocketOptions(const TCPSocketOptions &options);
+
+        // Set connect deadline of connections. [ms] -1 means no deadline. It is used by next connects.
+        void setConnectTimeout(int timeoutMs);
+
+        // Set wait time before a failed connection is opened again. [ms]
+        void setReconnectInterval(int intervalMs);
+
+        // Set maximum size of RX buffer of every connection. A connection with full RX buffer is not read until its data is consumed.
+        void setRxBufferSize(size_t size = TCPNetworkLinux_DEFAULT_POOL_RX_SIZE);
+
+        /**
+         * Drive all connections by one poll call. Complete connects, send queued TX data, receive into RX buffers and open failed connections again.
+         * @param timeoutMs: maximum wait time in milliseconds. 0 returns immediately. -1 waits until any connection has events.
+         * @return number of connections that received data. return -1 if there is any error.
+         */
+        int32_t update(int timeoutMs = 0);
+
+        /**
+         * Warm up pool. Block until all connections are connected or timeout passes. Failed connections are opened again while waiting.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit.
+         * @return number of connected connections. return -1 if there is any error.
+         */
+        int32_t waitConnected(int timeoutMs);
+
+        /**
+         * Select least loaded connection. Ties are rotated, so equal connections share load.
+         * @return index of connected connection with fewest outstanding requests, then fewest queued TX bytes. return -1 if no connection is connected.
+         */
+        int32_t select(void);
+
+        /**
+         * Send a request on least loaded connection. Unsent bytes are queued in TX buffer of the connection and sent by update().
+         * If the selected connection fails, the request is sent on the next least loaded one.
+         * @return index of connection that the request is sent on. return -1 if no connection is connected.
+         */
+        int32_t send(const char* data, size_t size);
+
+        /**
+         * Send a request on certain connection. It counts one outstanding request.
+         * @return true if successed.
+         */
+        bool send(size_t index, const char* data, size_t size);
+
+        // Return received data of certain connection that is not consumed yet.
+        std::string_view getRxData(size_t index);
+
+        /**
+         * Remove consumed bytes from RX buffer of certain connection.
+         * @param completedRequests: number of outstanding requests that the consumed data completes.
+         */
+        void consume(size_t index, size_t size, size_t completedRequests = 0);
+
+        // Return number of requests of certain connection that are sent and not completed by consume().
+        size_t getOutstandingRequests(size_t index);
+
+        // Return number of bytes queued in TX buffer of certain connection.
+        size_t getOutstandingBytes(size_t index);
+
+        // Return connect state of certain connection.
+        TCPConnectState getConnectState(size_t index);
+
+        // Return client of certain connection. It is owned by the pool. return nullptr if index is out of range.
+        TCPClient* getClient(size_t index);
+
+        // Return number of connections of the pool.
+        size_t getConnectionCount(void);
+
+        // Return number of connected connections.
+        size_t getConnectedCount(void);
+
+        // Return number of times that failed connections are opened again.
+        size_t getReconnectCount(void);
+
+    private:
+
+        // One connection of the pool.
+        struct _Member
+        {
+            TCPClient client;
+            TCPRingBuffer rxBuffer;                                 // Received data that is not consumed.
+            size_t outstandingRequests;                             // Sent requests that are not completed.
+            uint32_t events;                                        // Wait events of last poll.
+            std::chrono::steady_clock::time_point retryTime;        // Time point that a failed connection is opened again.
+        };
 
-        bool isClientConnected(void);
+        // Connections of the pool. Members are not moved, so clients keep their address.
+        std::vector<_Member*> _members;
 
-        // Close client socket.
-        void clientClose(void);
+        // Poll entries of connections. Index is the connection index.
+        std::vector<struct pollfd> _pollSockets;
 
-        std::string getVersion(void);
+        // Server port. Not used for unix domain sockets.
+        int _port;
+
+        // Server IP address or unix socket path.
+        std::string _address;
+
+        // Connections are unix domain sockets.
+        bool _unix;
+
+        // Socket options of connections.
+        TCPSocketOptions _socketOptions;
+
+        // Connect deadline of connections. [ms]
+        int _connectTimeout;
+
+        // Wait time before a failed connection is opened again. [ms]
+        int _reconnectInterval;
+
+        // Maximum size of RX buffer of every connection.
+        size_t _rxBufferSize;
+
+        // First connection that select() checks. It rotates ties.
+        size_t _cursor;
+
+        // Number of times that failed connections are opened again.
+        size_t _reconnectCount;
+
+        // Create connections after address is checked.
+        bool _start(size_t connectionCount);
+
+        // Open certain connection. On failure, it is opened again after the reconnect interval.
+        void _open(size_t index);
+
+        // Receive data into RX buffer of a member until socket is drained or buffer is full. return number of received bytes.
+        size_t _receive(_Member* member);
+
+        // Keep error of failed connection and schedule its next open.
+        void _fail(size_t index);
+};
+
+#if TCPNetworkLinux_COROUTINES
+
+class TCPScheduler;
+class TCPAsyncConnection;
+
+// ############################################################################################
+// TCPFramePool class:
+
+/**
+ * Allocator of coroutine frames. Freed frames are kept in per thread free lists by size class and reused,
+ * so after warm up new sessions and sub tasks do not allocate from heap.
+ * Frames larger than TCPNetworkLinux_FRAME_POOL_MAX_SIZE use global operator new.
+ */
+class TCPFramePool
+{
+    public:
+
+        // Allocate memory of certain size. Memory is aligned to __STDCPP_DEFAULT_NEW_ALIGNMENT__.
+        static void* allocate(size_t size);
+
+        // Return memory of allocate() to free list of calling thread. size must be the allocated size.
+        static void deallocate(void* pointer, size_t size) noexcept;
+
+        // Return number of heap allocations of calling thread. Reused frames are not counted.
+        static size_t getHeapAllocations(void);
+
+        // Return number of free frames cached by calling thread.
+        static size_t getCachedFrames(void);
+
+        // Free all cached frames of calling thread.
+        static void release(void);
+};
+
+// ############################################################################################
+// TCPTask class:
+
+/**
+ * Coroutine type of async API. A task starts suspended and runs when it is spawned on a TCPScheduler
+ * or awaited by another task. Awaiting a task resumes the awaiter after the task finished.
+ * Frames are allocated by TCPFramePool.
+ */
+class TCPTask
+{
+    public:
+
+        // Promise of the coroutine. Required by compiler.
+        struct promise_type
+        {
+            TCPTask get_return_object(void) noexcept;
+            std::suspend_always initial_suspend(void) noexcept { return {}; }
+            auto final_suspend(void) noexcept { return _FinalAwaiter{}; }
+            void return_void(void) noexcept {}
+            void unhandled_exception(void) noexcept { _exception = std::current_exception(); }
+
+            static void* operator new(size_t size) { return TCPFramePool::allocate(size); }
+            static void operator delete(void* pointer, size_t size) noexcept { TCPFramePool::deallocate(pointer, size); }
+
+            // Awaiter coroutine that is resumed after the task finished.
+            std::coroutine_handle<> _continuation;
+
+            // Owner scheduler of a spawned task. nullptr for awaited tasks.
+            TCPScheduler* _scheduler = nullptr;
+
+            // List of spawned tasks of the scheduler.
+            promise_type* _previous = nullptr;
+            promise_type* _next = nullptr;
+
+            // Exception that is thrown by the task. It is rethrown to the awaiter.
+            std::exception_ptr _exception;
+        };
+
+        TCPTask(void) noexcept : _handle(nullptr) {}
+
+        // Destructor. Destroy frame of a task that is not spawned.
+        ~TCPTask();
+
+        TCPTask(TCPTask &&other) noexcept;
+        TCPTask& operator=(TCPTask &&other) noexcept;
+
+        TCPTask(const TCPTask&) = delete;
+        TCPTask& operator=(const TCPTask&) = delete;
+
+        // Return true if the task finished.
+        bool isDone(void);
+
+        // Awaiter interface. Start the task and resume the awaiter when it finished.
+        bool await_ready(void) noexcept { return (_handle == nullptr) || _handle.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept;
+        void await_resume(void);
 
     private:
 
-        ssize_t bytesRead, bytesSent;       
+        friend class TCPScheduler;
 
-        // Integer representing the client's socket descriptor. 
-        int clientSocket = -1;              
+        // Final awaiter. Resume the awaiter, or destroy frame of a spawned task.
+        struct _FinalAwaiter
+        {
+            bool await_ready(void) noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume(void) noexcept {}
+        };
 
-        // Server Port number on which the server listens. eg: 8080
-        int _port; 
+        std::coroutine_handle<promise_type> _handle;
 
-        // Server IP address on which the server listens.. Replace with your interface's IP address. eg: "192.168.1.100"                         
-        std::string _ip;                    
+        explicit TCPTask(std::coroutine_handle<promise_type> handle) noexcept : _handle(handle) {}
+};
 
-        // Last error accured in methods of server.
+// ############################################################################################
+// TCPAsyncOperation class:
+
+/**
+ * Awaiter of one socket operation of TCPAsyncConnection or TCPAsyncListener.
+ * The operation is tried immediately. The coroutine is suspended only if the socket would block, then the scheduler
+ * continues the operation when the socket is ready. The awaiter lives in the coroutine frame, so operations do not allocate.
+ * One read and one write operation can be pending on a socket at a time.
+ * @return (co_await) result of the operation. Meaning is described by functions that return the operation.
+ */
+class TCPAsyncOperation
+{
+    public:
+
+        // Destructor. Cancel a pending operation when its coroutine is destroyed.
+        ~TCPAsyncOperation();
+
+        TCPAsyncOperation(const TCPAsyncOperation&) = delete;
+        TCPAsyncOperation& operator=(const TCPAsyncOperation&) = delete;
+
+        // Awaiter interface.
+        bool await_ready(void) noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        ssize_t await_resume(void) noexcept { return _result; }
+
+    protected:
+
+        friend class TCPScheduler;
+        friend class TCPAsyncConnection;
+        friend class TCPAsyncListener;
+
+        // Type of operation.
+        enum class _Type
+        {
+            ReadSome,
+            ReadExact,
+            WriteAll,
+            Accept,
+            Connect
+        };
+
+        _Type _type;
+
+        // Scheduler that continues the operation.
+        TCPScheduler* _scheduler;
+
+        // Socket of the operation. -1 means the operation fails immediately.
+        int _socket;
+
+        // errorMessage of owner object.
+        std::string* _errorMessage;
+
+        // Data buffer and size of read/write operations.
+        char* _data;
+        size_t _size;
+
+        // Number of bytes transferred so far.
+        size_t _done;
+
+        // Result of the operation.
+        ssize_t _result;
+
+        // Suspended coroutine.
+        std::coroutine_handle<> _handle;
+
+        // Operation is waiting in scheduler for readiness of socket.
+        bool _pending;
+
+        TCPAsyncOperation(_Type type, TCPScheduler* scheduler, int socket, std::string* errorMessage, char* data, size_t size);
+
+        /**
+         * Try the operation until it completes or the socket would block.
+         * @return true if the operation is completed. (_result is set)
+         */
+        bool _attempt(void);
+
+        // Complete the operation by an error. errorMessage is text and reason of error code.
+        void _fail(const char* text, int error);
+};
+
+/**
+ * Awaiter of TCPAsyncListener::accept().
+ * @return (co_await) accepted connection. It is not open if there is any error. (errorMessage of listener)
+ */
+class TCPAcceptOperation : public TCPAsyncOperation
+{
+    public:
+
+        TCPAsyncConnection await_resume(void);
+
+    private:
+
+        friend class TCPAsyncListener;
+
+        // Socket options of accepted connection.
+        const TCPSocketOptions* _socketOptions;
+
+        // Listening socket is a unix domain socket.
+        bool _unix;
+
+        TCPAcceptOperation(TCPScheduler* scheduler, int socket, std::string* errorMessage, const TCPSocketOptions* socketOptions, bool unixSocket);
+};
+
+/**
+ * Awaiter of TCPAsyncConnection::connect().
+ * @return (co_await) true if connection is established. Socket is closed if connect failed. (errorMessage of connection)
+ */
+class TCPConnectOperation : public TCPAsyncOperation
+{
+    public:
+
+        // Awaiter interface. Start non blocking connect and suspend until handshake is completed.
+        bool await_suspend(std::coroutine_handle<> handle);
+        bool await_resume(void);
+
+    private:
+
+        friend class TCPAsyncConnection;
+
+        // Connection that is connecting.
+        TCPAsyncConnection* _connection;
+
+        // Connect timeout. 0 disables it. [ms]
+        int _timeoutMs;
+
+        // Timer of connect timeout.
+        TCPTimer _timer;
+
+        // Expiry callback of connect timeout. context is the operation.
+        static void _onTimeout(TCPTimer &timer, void* context);
+
+        // Server address.
+        struct sockaddr_storage _address;
+        socklen_t _addressLength;
+
+        TCPConnectOperation(TCPAsyncConnection* connection, const struct sockaddr* address, socklen_t addressLength, int timeoutMs);
+};
+
+// ############################################################################################
+// TCPScheduler class:
+
+/**
+ * Single threaded scheduler of coroutine tasks. It owns an epoll instance (edge triggered) and resumes tasks
+ * whose socket operations are ready. All tasks, connections and listeners of a scheduler must be used by the thread that runs it.
+ */
+class TCPScheduler
+{
+    public:
+
+        // Last error accured for TCPScheduler object.
         std::string errorMessage;
 
-        // Accepts a client connection. [ No blocking mode.]
-        bool clientConfig(void);                
-        
-        // Handles client disconnection
-        void handleClientDisconnection(void);  
+        // Default constructor. Create epoll instance.
+        TCPScheduler();
+
+        // Destructor. Destroy frames of all tasks that are not finished.
+        ~TCPScheduler();
+
+        TCPScheduler(const TCPScheduler&) = delete;
+        TCPScheduler& operator=(const TCPScheduler&) = delete;
+
+        /**
+         * Take ownership of task and start it in next iteration.
+         * Frame of the task is destroyed when it finished. Exceptions of spawned tasks terminate the program.
+         */
+        void spawn(TCPTask task);
+
+        /**
+         * Run until all spawned tasks finished or stop() is called.
+         * @return false if there is any error.
+         */
+        bool run(void);
+
+        /**
+         * Wait for socket events at most certain time, expire timers and resume ready tasks.
+         * @param timeoutMs: maximum wait time in milliseconds. -1 waits without limit. It is 0 if any task is ready 
+         * and it is limited to next expiry of timer wheel.
+         * @return number of resumed tasks. return -1 if there is any error.
+         */
+        int32_t runOnce(int timeoutMs = -1);
+
+        // Make run() return after the current iteration.
+        void stop(void);
+
+        // Return number of spawned tasks that are not finished.
+        size_t getTaskCount(void);
+
+        /**
+         * Awaitable that suspends current task behind other ready tasks. (co_await scheduler.yield())
+         * Operations that do not block do not suspend, so long running tasks use it to let other tasks run.
+         */
+        auto yield(void) noexcept { return _YieldAwaiter{this}; }
+
+        /**
+         * Awaitable that suspends current task for certain time. (co_await scheduler.sleep(100))
+         * @param delayMs: delay in milliseconds. Resolution is 1 ms.
+         */
+        auto sleep(int64_t delayMs) noexcept { return _SleepAwaiter{this, delayMs, {}, nullptr}; }
+
+        // Return timer wheel of scheduler. Timers armed on it expire in runOnce(). Only thread of scheduler may use it.
+        TCPTimerWheel& getTimerWheel(void);
+
+    private:
+
+        friend class TCPTask;
+        friend class TCPAsyncOperation;
+        friend class TCPConnectOperation;
+        friend class TCPAsyncConnection;
+        friend class TCPAsyncListener;
+
+        // Awaiter of yield().
+        struct _YieldAwaiter
+        {
+            TCPScheduler* scheduler;
+            bool await_ready(void) noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->_readyList.push_back(handle); }
+            void await_resume(void) noexcept {}
+        };
+
+        // Awaiter of sleep(). Its timer lives in the coroutine frame.
+        struct _SleepAwaiter
+        {
+            TCPScheduler* scheduler;
+            int64_t delayMs;
+            TCPTimer timer;
+            std::coroutine_handle<> handle;
+
+            bool await_ready(void) noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> awaiter);
+            void await_resume(void) noexcept {}
+
+            // Expiry callback. context is the awaiter.
+            static void _onTimer(TCPTimer &timer, void* context);
+        };
+
+        // Pending operations of a socket.
+        struct _Watch
+        {
+            TCPAsyncOperation* read;
+            TCPAsyncOperation* write;
+        };
+
+        // Epoll file descriptor.
+        int _epoll;
+
+        // Coroutines that are resumed in next iteration.
+        std::vector<std::coroutine_handle<>> _readyList;
+
+        // Coroutines that are resumed in current iteration. Swapped with _readyList to keep capacity of both.
+        std::vector<std::coroutine_handle<>> _runList;
+
+        // Pending operations. Index is the socket descriptor.
+        std::vector<_Watch> _watches;
+
+        // Timers of sleeps, connect timeouts and application.
+        TCPTimerWheel _timers;
+
+        // First spawned task that is not finished.
+        TCPTask::promise_type* _tasks;
+
+        // Number of spawned tasks that are not finished.
+        size_t _taskCount;
+
+        // run() returns while it is true.
+        bool _stopped;
+
+        // Scheduler is being destroyed. Canceled operations are not resumed.
+        bool _closing;
+
+        // Add socket to epoll instance. return false if there is any error.
+        bool _addSocket(int socket, std::string &errorMessage);
+
+        // Cancel pending operations of socket and forget it. Socket is removed from epoll when it is closed.
+        void _removeSocket(int socket);
+
+        // Register pending operation. return false if another operation of same direction is pending.
+        bool _watch(TCPAsyncOperation* operation);
+
+        // Unregister pending operation.
+        void _unwatch(TCPAsyncOperation* operation);
+
+        // Remove finished spawned task from task list.
+        void _finishTask(TCPTask::promise_type* task);
+};
+
+// ############################################################################################
+// TCPAsyncConnection class:
+
+/**
+ * Non blocking stream socket (TCP or unix domain) with awaitable operations. (co_await connection.readSome(...))
+ * Buffers of operations must stay valid until the operation completed. Do not move the object while an operation is pending.
+ */
+class TCPAsyncConnection
+{
+    public:
+
+        // Last error accured for this connection.
+        std::string errorMessage;
+
+        // Constructor. Connection is not open until connect().
+        explicit TCPAsyncConnection(TCPScheduler &scheduler);
+
+        // Destructor. Close socket.
+        ~TCPAsyncConnection();
+
+        TCPAsyncConnection(TCPAsyncConnection &&other) noexcept;
+        TCPAsyncConnection& operator=(TCPAsyncConnection &&other) noexcept;
+
+        TCPAsyncConnection(const TCPAsyncConnection&) = delete;
+        TCPAsyncConnection& operator=(const TCPAsyncConnection&) = delete;
+
+        /**
+         * Connect to a TCP server. An open socket is closed first.
+         * @param timeoutMs: connect timeout in milliseconds. 0 disables it.
+         * @return (co_await) true if connection is established.
+         */
+        TCPConnectOperation connect(uint16_t port, const char* ip, int timeoutMs = TCPNetworkLinux_DEFAULT_CONNECT_TIMEOUT);
+
+        /**
+         * Connect to a unix domain server. Path that starts with '@' is in abstract namespace.
+         * @param timeoutMs: connect timeout in milliseconds. 0 disables it.
+         * @return (co_await) true if connection is established.
+         */
+        TCPConnectOperation connectByPath(const char* path, int timeoutMs = TCPNetworkLinux_DEFAULT_CONNECT_TIMEOUT);
+
+        /**
+         * Receive available data, at most size bytes.
+         * @return (co_await) number of bytes received. return 0 if peer closed, -1 if there is any error.
+         */
+        TCPAsyncOperation readSome(char* data, size_t size);
+
+        /**
+         * Receive exactly size bytes.
+         * @return (co_await) size. return 0 if peer closed before first byte, -1 if peer closed later or there is any error.
+         */
+        TCPAsyncOperation readExact(char* data, size_t size);
+
+        /**
+         * Send all data.
+         * @return (co_await) size. return -1 if there is any error.
+         */
+        TCPAsyncOperation writeAll(const char* data, size_t size);
+
+        /**
+         * Send all data of string. The string must stay valid until the operation completed.
+         * @return (co_await) size of string. return -1 if there is any error.
+         */
+        TCPAsyncOperation writeAll(const std::string &data);
+
+        /**
+         * Set socket options. They are used by next connect() and applied now if socket is open.
+         * @return false if any option failed. (errorMessage)
+         */
+        bool setSocketOptions(const TCPSocketOptions &options);
+
+        // Close socket. Pending operations complete with error.
+        void close(void);
+
+        // Return true if socket is open.
+        bool isOpen(void);
+
+        // Return socket descriptor. return -1 if socket is not open.
+        int getSocket(void);
+
+    private:
+
+        friend class TCPAcceptOperation;
+        friend class TCPConnectOperation;
+
+        TCPScheduler* _scheduler;
+
+        // Socket descriptor.
+        int _socket;
+
+        // Socket is a unix domain socket.
+        bool _unix;
+
+        // Socket options.
+        TCPSocketOptions _socketOptions;
+
+        // Connection of an accepted socket. Socket is added to scheduler. Its failure is written to errorMessage of listener.
+        TCPAsyncConnection(TCPScheduler &scheduler, int socket, const TCPSocketOptions &options, bool unixSocket, std::string &listenerErrorMessage);
+
+        // Open non blocking socket of address family and return its connect operation. Socket of operation is -1 on failure.
+        TCPConnectOperation _connect(const struct sockaddr* address, socklen_t addressLength, int timeoutMs);
+};
+
+// ############################################################################################
+// TCPAsyncListener class:
+
+/**
+ * Non blocking listening socket (TCP or unix domain) with awaitable accept. (co_await listener.accept())
+ */
+class TCPAsyncListener
+{
+    public:
+
+        // Last error accured for TCPAsyncListener object.
+        std::string errorMessage;
+
+        // Constructor. Listener is not open until start.
+        explicit TCPAsyncListener(TCPScheduler &scheduler);
+
+        // Destructor. Close socket.
+        ~TCPAsyncListener();
+
+        TCPAsyncListener(const TCPAsyncListener&) = delete;
+        TCPAsyncListener& operator=(const TCPAsyncListener&) = delete;
+
+        /**
+         * Listen on certain ip and port.
+         * @return true if successed.
+         */
+        bool startByIP(uint16_t port, const char* ip);
+
+        /**
+         * Listen on unix domain socket. Path that starts with '@' is in abstract namespace. A stale socket file is removed.
+         * @return true if successed.
+         */
+        bool startByPath(const char* path);
+
+        // Set socket options of listening socket and accepted connections. It is used by next start.
+        void setSocketOptions(const TCPSocketOptions &options);
+
+        /**
+         * Accept one connection.
+         * @return (co_await) accepted connection. It is not open if there is any error.
+         */
+        TCPAcceptOperation accept(void);
+
+        // Close listening socket. A pending accept completes with error. Socket file of filesystem path is removed.
+        void close(void);
+
+        // Return true if listening socket is open.
+        bool isOpen(void);
+
+    private:
+
+        TCPScheduler* _scheduler;
+
+        // Listening socket descriptor.
+        int _socket;
+
+        // Listening socket is a unix domain socket.
+        bool _unix;
 
+        // Filesystem path of unix domain socket. It is removed on close.
+        std::string _unixPath;
+
+        // Socket options of listening socket and accepted connections.
+        TCPSocketOptions _socketOptions;
+
+        // Create, bind and listen non blocking socket.
+        bool _startListening(const struct sockaddr* address, socklen_t addressLength);
 };
 
 #endif
+
+#endif
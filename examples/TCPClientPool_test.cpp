@@ -0,0 +1,105 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -o ./bin/TCPClientPool_test TCPClientPool_test.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPClientPool_test [connectionCount]
+
+Line requests are sent over a pool of connections to the line echo server of TCPHandler_test. (./bin/TCPHandler_test)
+Every request goes to the connection with fewest outstanding requests. Restart the server to see failed connections refilled.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <csignal>              // For SIGINT handler
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+int serverPort = 9040;                       // Port number on which the server listens
+const char *server_ip = "127.0.0.1";         // IP address on which the server listens.. Replace with your interface's IP address
+
+volatile sig_atomic_t stopFlag = 0;
+
+// ###################################################
+// Function declerations
+
+// Consume complete response lines of a connection. return number of responses.
+size_t consumeResponses(TCPClientPool &pool, size_t index);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    size_t connectionCount = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 4;
+
+    signal(SIGINT, [](int) { stopFlag = 1; });
+
+    TCPClientPool pool;
+    pool.setConnectTimeout(1000);
+    pool.setReconnectInterval(500);
+
+    if (!pool.start(serverPort, server_ip, connectionCount))
+    {
+        std::cout << pool.errorMessage << std::endl;
+        return 1;
+    }
+
+    // Warm up all connections before first request.
+    printf("connected: %d/%zu\n", pool.waitConnected(2000), connectionCount);
+
+    std::vector<size_t> responses(connectionCount, 0);
+    auto reportTime = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    size_t requestNum = 0;
+
+    while (!stopFlag)
+    {
+        std::string request = "request " + std::to_string(requestNum) + "\n";
+        if (pool.send(request.data(), request.size()) >= 0)
+        {
+            requestNum++;
+        }
+
+        if (pool.update(10) == -1)
+        {
+            std::cout << pool.errorMessage << std::endl;
+            break;
+        }
+
+        for (size_t i = 0; i < connectionCount; i++)
+        {
+            responses[i] += consumeResponses(pool, i);
+        }
+
+        if (std::chrono::steady_clock::now() >= reportTime)
+        {
+            printf("requests: %zu, connected: %zu, reconnects: %zu, responses:", requestNum, pool.getConnectedCount(), pool.getReconnectCount());
+            for (size_t i = 0; i < connectionCount; i++)
+            {
+                printf(" %zu", responses[i]);
+            }
+            printf("\n");
+            reportTime += std::chrono::seconds(1);
+        }
+    }
+
+    pool.close();
+
+    return 0;
+}
+
+size_t consumeResponses(TCPClientPool &pool, size_t index)
+{
+    std::string_view data = pool.getRxData(index);
+
+    size_t end = data.rfind('\n');
+    if (end == std::string_view::npos)
+    {
+        return 0;
+    }
+
+    size_t responseNum = std::count(data.begin(), data.begin() + end + 1, '\n');
+    pool.consume(index, end + 1, responseNum);
+
+    return responseNum;
+}
@@ -1,10 +1,10 @@
-// For compile: g++ -o TCPClient_test TCPClient_test.cpp ../TCPNetwork.cpp
+// For compile: g++ -o TCPClient_test TCPClient_test.cpp ../TCPNetworkLinux.cpp
 // For run: sudo ./TCPClient_test
 // ##################################################
 // Include libraries
 
 #include <iostream>             // For standard input and output stream.
-#include "../TCPNetwork.h"       // Custom TCP/IP network library for handel server and client
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
 
 /*
 to set the server socket to non-blocking mode before calling accept. 
@@ -27,8 +27,9 @@ int i;
 // ###################################################
 int main() 
 {
-    // Start the client and connect to the server
-    if (client.start(serverPort, server_ip)) {
+    // Start the client and wait for connect handshake. (deadline: 5 seconds)
+    client.setConnectTimeout(5000);
+    if (client.start(serverPort, server_ip) && (client.updateConnect(-1) == TCPConnectState::Connected)) {
         std::cout << "Connected to the server successfully." << std::endl;
     } else {
         client.printError();
@@ -39,22 +40,40 @@ int main()
     const char* message = "Hello, Server!";
     char buffer[1024];
 
+    auto sendTime = std::chrono::steady_clock::now();
+
     // Main loop for continuous communication
     while (client.isClientConnected()) {
-        // Update the client: send and receive
-        if (client.update(const_cast<char*>(message), strlen(message), buffer, sizeof(buffer) - 1)) {
+        // Send message every 1 second.
+        if (std::chrono::steady_clock::now() >= sendTime) {
+            client.pushBackTxBuffer(message, strlen(message));
+            if (!client.write()) {
+                client.printError();
+                break;
+            }
             std::cout << "Message sent to the server." << std::endl;
+            sendTime += std::chrono::seconds(1);
+        }
 
-            // Print the received message
-            std::cout << "Received message from server: " << buffer << std::endl;
-        } else {
+        // Block until server data arrives or next send time. Received data is printed without waiting for the sleep interval.
+        auto waitTime = std::chrono::duration_cast<std::chrono::milliseconds>(sendTime - std::chrono::steady_clock::now());
+        int32_t events = client.waitReadable(std::max<int>(waitTime.count(), 0));
+        if (events == -1) {
             client.printError();
-            client.clientClose();
-            break;  // Exit the loop on error
+            break;
         }
 
-        // Sleep for a while before sending the next message
-        usleep(1000000);  // Sleep for 1 second (1000000 microseconds)
+        if (events & TCPNetworkLinux_WAIT_READABLE) {
+            int32_t bytesRead = client.read(buffer, sizeof(buffer) - 1);
+            if (bytesRead < 0) {
+                client.printError();
+                break;  // Exit the loop on error
+            }
+
+            // Print the received message
+            buffer[bytesRead] = '\0';
+            std::cout << "Received message from server: " << buffer << std::endl;
+        }
     }
 
     // Close the client connection
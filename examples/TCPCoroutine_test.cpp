@@ -0,0 +1,204 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -std=c++20 -O2 -pthread -o ./bin/TCPCoroutine_test TCPCoroutine_test.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPCoroutine_test [sessionCount] [roundCount] [payloadSize]
+
+Length prefixed echo protocol written with coroutines. One scheduler runs the server and all client sessions on one thread.
+Every session sends roundCount messages (4 byte length + payload) and reads the echo of each message.
+The test runs twice and the second run shows heap allocations of coroutine frames, which are zero when frames are reused.
+Every session needs two descriptors. Raise limit for many sessions. (eg: ulimit -n 65536)
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <chrono>               // For elapsed time
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+int serverPort = 9030;                       // Port number on which the server listens
+const char *server_ip = "127.0.0.1";         // IP address on which the server listens.
+
+size_t completedSessions = 0;                // Number of client sessions that finished all rounds
+size_t failedSessions = 0;                   // Number of client sessions that failed
+
+// ###################################################
+// Function declerations
+
+// Accept connections and spawn one echo session per connection.
+TCPTask acceptLoop(TCPScheduler& scheduler, TCPAsyncListener& listener, size_t sessionCount);
+
+// Echo length prefixed messages until peer closed.
+TCPTask echoSession(TCPAsyncConnection connection);
+
+// Read one length prefixed message. Sub task of sessions.
+TCPTask readMessage(TCPAsyncConnection& connection, std::string& payload, bool& ok);
+
+// Connect, send messages and check echoes.
+TCPTask clientSession(TCPScheduler& scheduler, size_t roundCount, size_t payloadSize);
+
+// Run server and sessions once. return elapsed seconds.
+double runOnce(size_t sessionCount, size_t roundCount, size_t payloadSize);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    size_t sessionCount = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 256;
+    size_t roundCount = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 100;
+    size_t payloadSize = (argc > 3) ? strtoul(argv[3], nullptr, 10) : 64;
+
+    printf("sessions: %zu, rounds: %zu, payloadSize: %zu\n", sessionCount, roundCount, payloadSize);
+
+    for (int run = 0; run < 2; run++)
+    {
+        completedSessions = 0;
+        failedSessions = 0;
+
+        size_t heapAllocations = TCPFramePool::getHeapAllocations();
+        double seconds = runOnce(sessionCount, roundCount, payloadSize);
+        heapAllocations = TCPFramePool::getHeapAllocations() - heapAllocations;
+
+        printf("run %d: completed: %zu, failed: %zu, seconds: %.3f, messages/s: %.0f, frame heap allocations: %zu, cached frames: %zu\n",
+               run, completedSessions, failedSessions, seconds, (sessionCount * roundCount) / seconds, heapAllocations, TCPFramePool::getCachedFrames());
+    }
+
+    return 0;
+}
+
+double runOnce(size_t sessionCount, size_t roundCount, size_t payloadSize)
+{
+    TCPScheduler scheduler;
+    TCPAsyncListener listener(scheduler);
+
+    // All sessions connect at once, so backlog must hold them.
+    TCPSocketOptions options;
+    options.noDelay = 1;
+    options.listenBacklog = (int)sessionCount;
+    listener.setSocketOptions(options);
+
+    if (!listener.startByIP(serverPort, server_ip))
+    {
+        std::cout << listener.errorMessage << std::endl;
+        exit(1);
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    scheduler.spawn(acceptLoop(scheduler, listener, sessionCount));
+    for (size_t i = 0; i < sessionCount; i++)
+    {
+        scheduler.spawn(clientSession(scheduler, roundCount, payloadSize));
+    }
+
+    if (!scheduler.run())
+    {
+        std::cout << scheduler.errorMessage << std::endl;
+        exit(1);
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+TCPTask acceptLoop(TCPScheduler& scheduler, TCPAsyncListener& listener, size_t sessionCount)
+{
+    for (size_t i = 0; i < sessionCount; i++)
+    {
+        TCPAsyncConnection connection = co_await listener.accept();
+        if (!connection.isOpen())
+        {
+            std::cout << listener.errorMessage << std::endl;
+            co_return;
+        }
+
+        scheduler.spawn(echoSession(std::move(connection)));
+    }
+}
+
+TCPTask echoSession(TCPAsyncConnection connection)
+{
+    std::string payload;
+    bool ok = true;
+
+    while (true)
+    {
+        co_await readMessage(connection, payload, ok);
+        if (!ok)
+        {
+            co_return;
+        }
+
+        uint32_t header = htonl((uint32_t)payload.size());
+        if ( (co_await connection.writeAll((const char*)&header, sizeof(header)) < 0) ||
+             (co_await connection.writeAll(payload) < 0) )
+        {
+            std::cout << connection.errorMessage << std::endl;
+            co_return;
+        }
+    }
+}
+
+TCPTask readMessage(TCPAsyncConnection& connection, std::string& payload, bool& ok)
+{
+    uint32_t header;
+    ok = false;
+
+    // 0 means peer closed between messages.
+    if (co_await connection.readExact((char*)&header, sizeof(header)) <= 0)
+    {
+        co_return;
+    }
+
+    payload.resize(ntohl(header));
+    if (co_await connection.readExact(&payload[0], payload.size()) < 0)
+    {
+        std::cout << connection.errorMessage << std::endl;
+        co_return;
+    }
+
+    ok = true;
+}
+
+TCPTask clientSession(TCPScheduler& scheduler, size_t roundCount, size_t payloadSize)
+{
+    TCPAsyncConnection connection(scheduler);
+
+    TCPSocketOptions options;
+    options.noDelay = 1;
+    connection.setSocketOptions(options);
+
+    if (!co_await connection.connect(serverPort, server_ip))
+    {
+        std::cout << connection.errorMessage << std::endl;
+        failedSessions++;
+        co_return;
+    }
+
+    std::string message(sizeof(uint32_t) + payloadSize, 'x');
+    uint32_t header = htonl((uint32_t)payloadSize);
+    memcpy(&message[0], &header, sizeof(header));
+
+    std::string echo;
+    bool ok = true;
+
+    for (size_t round = 0; round < roundCount; round++)
+    {
+        if (co_await connection.writeAll(message) < 0)
+        {
+            std::cout << connection.errorMessage << std::endl;
+            failedSessions++;
+            co_return;
+        }
+
+        co_await readMessage(connection, echo, ok);
+        if ( !ok || (echo.size() != payloadSize) )
+        {
+            failedSessions++;
+            co_return;
+        }
+    }
+
+    completedSessions++;
+}
@@ -0,0 +1,153 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -pthread -o ./bin/TCPDelimiterScan_bench TCPDelimiterScan_bench.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPDelimiterScan_bench [totalMiB]
+
+Compare delimiter framing of newline terminated records at 64 B, 1 KiB and 64 KiB record sizes:
+ - naive deque: byte by byte search over std::deque<char> and erase of each record. (previous RX buffer)
+ - naive loop: byte by byte search over contiguous memory.
+ - TCPDelimiterFramer::decode() over a TCPRingBuffer with Scalar, SSE2 and AVX2 scan implementations.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <deque>                // For naive deque baseline
+#include <chrono>               // For elapsed time
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+volatile size_t checksum = 0;                // Keeps results alive against optimizer
+
+// ###################################################
+// Function declerations
+
+// Print one result line.
+void printResult(size_t recordSize, const char* name, double seconds, size_t bytes, size_t records);
+
+// Naive baselines. return elapsed seconds.
+double runNaiveDeque(const std::string& stream, size_t &records);
+double runNaiveLoop(const std::string& stream, size_t &records);
+
+// TCPDelimiterFramer with selected scan implementation. return elapsed seconds.
+double runFramer(const std::string& stream, size_t &records);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    size_t totalBytes = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 64) << 20;
+    const size_t recordSizes[] = {64, 1024, 65536};
+    const TCPScanImplementation implementations[] = {TCPScanImplementation::Scalar, TCPScanImplementation::SSE2, TCPScanImplementation::AVX2};
+    const char* implementationNames[] = {"framer scalar", "framer sse2", "framer avx2"};
+
+    printf("%-12s %-16s %12s %14s\n", "recordSize", "case", "GB/s", "Mrecords/s");
+
+    for (size_t recordSize : recordSizes)
+    {
+        // Records of recordSize bytes including newline.
+        std::string stream;
+        stream.reserve(totalBytes);
+        while (stream.size() + recordSize <= totalBytes)
+        {
+            stream.append(recordSize - 1, 'a');
+            stream.push_back('\n');
+        }
+
+        size_t records = 0;
+        double seconds = runNaiveDeque(stream, records);
+        printResult(recordSize, "naive deque", seconds, stream.size(), records);
+
+        seconds = runNaiveLoop(stream, records);
+        printResult(recordSize, "naive loop", seconds, stream.size(), records);
+
+        for (size_t i = 0; i < 3; i++)
+        {
+            if (!TCPDelimiterFramer::setScanImplementation(implementations[i]))
+            {
+                printf("%-12zu %-16s %12s\n", recordSize, implementationNames[i], "unsupported");
+                continue;
+            }
+
+            seconds = runFramer(stream, records);
+            printResult(recordSize, implementationNames[i], seconds, stream.size(), records);
+        }
+    }
+
+    return 0;
+}
+
+void printResult(size_t recordSize, const char* name, double seconds, size_t bytes, size_t records)
+{
+    printf("%-12zu %-16s %12.2f %14.2f\n", recordSize, name, bytes / seconds / 1e9, records / seconds / 1e6);
+}
+
+double runNaiveDeque(const std::string& stream, size_t &records)
+{
+    std::deque<char> buffer(stream.begin(), stream.end());
+    records = 0;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    while (!buffer.empty())
+    {
+        size_t size = 0;
+        while ((size < buffer.size()) && (buffer[size] != '\n'))
+        {
+            size++;
+        }
+
+        checksum = checksum + size;
+        buffer.erase(buffer.begin(), buffer.begin() + size + 1);
+        records++;
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+double runNaiveLoop(const std::string& stream, size_t &records)
+{
+    const char* data = stream.data();
+    size_t offset = 0;
+    records = 0;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    while (offset < stream.size())
+    {
+        size_t size = 0;
+        while ((offset + size < stream.size()) && (data[offset + size] != '\n'))
+        {
+            size++;
+        }
+
+        checksum = checksum + size;
+        offset += size + 1;
+        records++;
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+double runFramer(const std::string& stream, size_t &records)
+{
+    TCPDelimiterFramer framer('\n', stream.size());
+    TCPRingBuffer buffer;
+    buffer.append(stream.data(), stream.size());
+    records = 0;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::string_view record;
+    ssize_t frameBytes;
+    while ((frameBytes = framer.decode(buffer, record)) > 0)
+    {
+        checksum = checksum + record.size();
+        buffer.discard(frameBytes);
+        records++;
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
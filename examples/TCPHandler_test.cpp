@@ -0,0 +1,119 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -o ./bin/TCPHandler_test TCPHandler_test.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPHandler_test [backend]
+
+Line echo server with event handler. The event loop calls handler functions directly (CRTP), without polling of connections.
+backend 1 uses io_uring. Test it by: nc 127.0.0.1 9040
+Connections that send nothing for 60 s are closed. Quiet connections receive "ping" every 10 s.
+Buffers use backpressure. A client that does not read its echoes is slowed down by TCP flow control and no byte is dropped.
+Buffers of all connections share a 256 MB memory budget. Idle connections hold no buffer memory.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <csignal>              // For SIGINT handler
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+int serverPort = 9040;                       // Port number on which the server listens
+const char *server_ip = "127.0.0.1";         // IP address on which the server listens.. Replace with your interface's IP address
+
+volatile sig_atomic_t stopFlag = 0;
+
+// ###################################################
+// Handler class
+
+class EchoHandler : public TCPHandler<EchoHandler>
+{
+    public:
+
+        void onAccept(TCPServer &server, TCPConnection &connection)
+        {
+            (void)server;
+            printf("accept %s:%d\n", connection.getIP().c_str(), connection.getPort());
+        }
+
+        // Echo complete lines. A partial line stays in RX buffer until its newline is received.
+        // Lines that TX buffer refuses stay in RX buffer too. RX pauses when it is full.
+        size_t onData(TCPServer &server, TCPConnection &connection, std::string_view data)
+        {
+            (void)server;
+
+            size_t end = data.rfind('\n');
+            if ( (end == std::string_view::npos) || !connection.write(data.data(), end + 1) )
+            {
+                return 0;
+            }
+
+            return end + 1;
+        }
+
+        // Echo lines that waited for TX buffer space.
+        void onWritable(TCPServer &server, TCPConnection &connection)
+        {
+            printf("drained %s:%d\n", connection.getIP().c_str(), connection.getPort());
+            connection.consumeRxBuffer(onData(server, connection, connection.peekRxBuffer()));
+        }
+
+        void onHeartbeat(TCPServer &server, TCPConnection &connection)
+        {
+            (void)server;
+            connection.write("ping\n");
+        }
+
+        void onClose(TCPServer &server, TCPConnection &connection, TCPCloseReason reason)
+        {
+            (void)server;
+            printf("close %s:%d reason %d: %s\n", connection.getIP().c_str(), connection.getPort(), (int)reason, connection.errorMessage.c_str());
+        }
+};
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    TCPEventBackend backend = ((argc > 1) && (atoi(argv[1]) == 1)) ? TCPEventBackend::IoUring : TCPEventBackend::Epoll;
+
+    signal(SIGINT, [](int) { stopFlag = 1; });
+
+    TCPServer server;
+    EchoHandler handler;
+
+    server.setRxBufferSize(65536);
+    server.setTxBufferSize(1 << 20);
+    server.setOverflowPolicy(TCPOverflowPolicy::Backpressure);
+    server.setIdleTimeout(60000);
+    server.setWriteTimeout(10000);
+    server.setHeartbeatInterval(10000);
+    TCPBufferPool::setMemoryBudget(256 << 20);
+
+    if (!server.startByIP(serverPort, server_ip) || !server.startEventLoop(TCPNetworkLinux_DEFAULT_MAX_CONNECTIONS, backend))
+    {
+        server.printError();
+        return 1;
+    }
+
+    printf("Server is listening on %s:%d. io_uring: %d\n", server_ip, serverPort, server.getEventBackend() == TCPEventBackend::IoUring);
+
+    while (!stopFlag)
+    {
+        if (server.runEventLoop(handler, 100) == -1)
+        {
+            server.printError();
+            break;
+        }
+    }
+
+    server.stopEventLoop();
+
+    // Dispatch shutdown closes.
+    server.runEventLoop(handler, 0);
+
+    server.serverClose();
+
+    return 0;
+}
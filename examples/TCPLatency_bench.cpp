@@ -0,0 +1,376 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -pthread -o ./bin/TCPLatency_bench TCPLatency_bench.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPLatency_bench [--sizes 16,256,4096,65536] [--iterations 100000] [--warmup 1000] [--server-cpu N] [--client-cpu N]
+                       [--backend epoll|uring] [--low-latency] [--transport tcp|unix] [--format text|json|csv]
+
+Ping-pong round trip latency of TCPClient and TCPServer event loop (echo) over 127.0.0.1 for every message size.
+Transport unix runs the same API over a unix domain socket (abstract namespace) to compare with the TCP loopback stack.
+Latencies are recorded in an HDR style log-linear histogram (relative error < 1%) and reported as
+min, mean, p50, p90, p99, p99.9, p99.99 and max in microseconds.
+Client runs on main thread and server on a second thread. Both can be pinned to CPUs.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <thread>               // For server thread
+#include <atomic>               // For stop flag
+#include <chrono>               // For time stamps
+#include <getopt.h>             // For command line options
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Latency histogram:
+
+/**
+ * Log-linear histogram of positive integer values. (HDR histogram layout)
+ * Values below 2^SUB_BITS are exact. Larger values are grouped in 2^(SUB_BITS-1) linear sub buckets per power of two.
+ */
+class LatencyHistogram
+{
+    public:
+
+        static const int SUB_BITS = 8;
+
+        LatencyHistogram() : _counts(SUB_BITS_COUNT + 64 * HALF_COUNT, 0) {}
+
+        void record(uint64_t value)
+        {
+            _counts[_index(value)]++;
+            _totalCount++;
+            _sum += value;
+            _min = std::min(_min, value);
+            _max = std::max(_max, value);
+        }
+
+        // Return highest value that is equivalent to the value at certain percentile.
+        uint64_t percentile(double percent) const
+        {
+            uint64_t rank = (uint64_t)(percent / 100.0 * _totalCount + 0.5);
+            rank = std::max<uint64_t>(rank, 1);
+            uint64_t count = 0;
+
+            for (size_t i = 0; i < _counts.size(); i++)
+            {
+                count += _counts[i];
+                if (count >= rank)
+                {
+                    return std::min(_highestEquivalent(i), _max);
+                }
+            }
+
+            return _max;
+        }
+
+        uint64_t count(void) const { return _totalCount; }
+        uint64_t min(void) const { return _totalCount ? _min : 0; }
+        uint64_t max(void) const { return _max; }
+        double mean(void) const { return _totalCount ? (double)_sum / _totalCount : 0; }
+
+    private:
+
+        static const size_t SUB_BITS_COUNT = (size_t)1 << SUB_BITS;
+        static const size_t HALF_COUNT = SUB_BITS_COUNT / 2;
+
+        std::vector<uint64_t> _counts;
+        uint64_t _totalCount = 0;
+        uint64_t _sum = 0;
+        uint64_t _min = UINT64_MAX;
+        uint64_t _max = 0;
+
+        static size_t _index(uint64_t value)
+        {
+            if (value < SUB_BITS_COUNT)
+            {
+                return value;
+            }
+
+            // shift keeps SUB_BITS - 1 significant bits below the most significant bit.
+            int shift = 63 - __builtin_clzll(value) - (SUB_BITS - 1);
+            return SUB_BITS_COUNT + (size_t)(shift - 1) * HALF_COUNT + (size_t)((value >> shift) - HALF_COUNT);
+        }
+
+        static uint64_t _highestEquivalent(size_t index)
+        {
+            if (index < SUB_BITS_COUNT)
+            {
+                return index;
+            }
+
+            int shift = (int)((index - SUB_BITS_COUNT) / HALF_COUNT) + 1;
+            uint64_t sub = (index - SUB_BITS_COUNT) % HALF_COUNT + HALF_COUNT;
+            return ((sub + 1) << shift) - 1;
+        }
+};
+
+// ###################################################
+// Global Variables
+
+int serverPort = 9030;                       // Port number on which the server listens
+const char *server_ip = "127.0.0.1";         // Loopback address for benchmark
+const char *server_path = "@TCPLatency_bench";   // Unix domain socket name for benchmark
+
+std::atomic<bool> serverRunning(true);
+
+// ###################################################
+// Function declerations
+
+// Pin current thread to certain CPU. -1 keeps default affinity.
+void pinThread(int cpu);
+
+// Echo server loop. It runs on server thread.
+void runServer(TCPServer* server, int cpu);
+
+// Send one message and wait for its echo. return false if connection failed.
+bool pingPong(TCPClient &client, std::string &message, std::vector<char> &buffer);
+
+// Print results in selected format. config is a list of JSON members that describe the run.
+void printResults(const std::string& format, const std::string& config, const std::vector<size_t>& sizes, const std::vector<LatencyHistogram>& histograms);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = {16, 256, 4096, 65536};
+    size_t iterations = 100000;
+    size_t warmup = 1000;
+    int serverCpu = -1;
+    int clientCpu = -1;
+    bool lowLatency = false;
+    TCPEventBackend backend = TCPEventBackend::Epoll;
+    bool unixTransport = false;
+    std::string format = "text";
+
+    static struct option longOptions[] =
+    {
+        {"sizes", required_argument, nullptr, 's'},
+        {"iterations", required_argument, nullptr, 'n'},
+        {"warmup", required_argument, nullptr, 'w'},
+        {"server-cpu", required_argument, nullptr, 'S'},
+        {"client-cpu", required_argument, nullptr, 'C'},
+        {"backend", required_argument, nullptr, 'b'},
+        {"low-latency", no_argument, nullptr, 'l'},
+        {"transport", required_argument, nullptr, 't'},
+        {"format", required_argument, nullptr, 'f'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "", longOptions, nullptr)) != -1)
+    {
+        switch (option)
+        {
+            case 's':
+            {
+                sizes.clear();
+                char* item = strtok(optarg, ",");
+                while (item != nullptr)
+                {
+                    sizes.push_back(strtoul(item, nullptr, 10));
+                    item = strtok(nullptr, ",");
+                }
+                break;
+            }
+            case 'n': iterations = strtoul(optarg, nullptr, 10); break;
+            case 'w': warmup = strtoul(optarg, nullptr, 10); break;
+            case 'S': serverCpu = atoi(optarg); break;
+            case 'C': clientCpu = atoi(optarg); break;
+            case 'b': backend = (strcmp(optarg, "uring") == 0) ? TCPEventBackend::IoUring : TCPEventBackend::Epoll; break;
+            case 'l': lowLatency = true; break;
+            case 't': unixTransport = (strcmp(optarg, "unix") == 0); break;
+            case 'f': format = optarg; break;
+            default:
+                fprintf(stderr, "Invalid option. See usage at top of TCPLatency_bench.cpp\n");
+                return 1;
+        }
+    }
+
+    size_t maxSize = *std::max_element(sizes.begin(), sizes.end());
+    TCPSocketOptions socketOptions = lowLatency ? TCPSocketOptions::lowLatency() : TCPSocketOptions();
+
+    TCPServer server;
+    server.setSocketOptions(socketOptions);
+    // RX limit larger than any message, so overflow trimming never drops benchmark data.
+    server.setRxBufferSize(2 * maxSize);
+
+    bool started = unixTransport ? server.startByPath(server_path) : server.startByIP(serverPort, server_ip);
+    if (!started || !server.startEventLoop(16, backend))
+    {
+        server.printError();
+        return 1;
+    }
+
+    std::thread serverThread(runServer, &server, serverCpu);
+    pinThread(clientCpu);
+
+    TCPClient client;
+    client.setSocketOptions(socketOptions);
+    started = unixTransport ? client.startByPath(server_path) : client.start(serverPort, server_ip);
+    if (!started || (client.updateConnect(-1) != TCPConnectState::Connected))
+    {
+        client.printError();
+        serverRunning = false;
+        serverThread.join();
+        return 1;
+    }
+
+    std::vector<LatencyHistogram> histograms(sizes.size());
+    std::vector<char> buffer(maxSize);
+
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        std::string message(sizes[i], 'x');
+
+        for (size_t j = 0; j < warmup + iterations; j++)
+        {
+            auto startTime = std::chrono::steady_clock::now();
+
+            if (!pingPong(client, message, buffer))
+            {
+                client.printError();
+                serverRunning = false;
+                serverThread.join();
+                return 1;
+            }
+
+            if (j >= warmup)
+            {
+                histograms[i].record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+            }
+        }
+    }
+
+    client.clientClose();
+    serverRunning = false;
+    serverThread.join();
+
+    char config[256];
+    snprintf(config, sizeof(config), "\"transport\": \"%s\", \"backend\": \"%s\", \"iterations\": %zu, \"warmup\": %zu, \"server_cpu\": %d, \"client_cpu\": %d, \"low_latency\": %d",
+             unixTransport ? "unix" : "tcp", (server.getEventBackend() == TCPEventBackend::IoUring) ? "uring" : "epoll", iterations, warmup, serverCpu, clientCpu, lowLatency);
+
+    printResults(format, config, sizes, histograms);
+
+    return 0;
+}
+
+void pinThread(int cpu)
+{
+    if (cpu < 0)
+    {
+        return;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+    {
+        fprintf(stderr, "Error setting CPU affinity to CPU %d\n", cpu);
+    }
+}
+
+void runServer(TCPServer* server, int cpu)
+{
+    pinThread(cpu);
+
+    while (serverRunning)
+    {
+        server->runEventLoop(10);
+
+        for (TCPConnection* connection : server->getReadyConnections())
+        {
+            std::string_view data = connection->peekRxBuffer();
+            connection->write(data.data(), data.size());
+            connection->consumeRxBuffer(data.size());
+        }
+    }
+}
+
+bool pingPong(TCPClient &client, std::string &message, std::vector<char> &buffer)
+{
+    struct iovec request = {&message[0], message.size()};
+
+    if (!client.write(&request, 1))
+    {
+        return false;
+    }
+
+    size_t received = 0;
+    while (received < message.size())
+    {
+        // Large requests may be queued partially. Flush them while echo is received.
+        if ( (client.getTxQueuedBytes() > 0) && !client.write() )
+        {
+            return false;
+        }
+
+        int32_t bytesRead = client.read(buffer.data(), message.size() - received);
+
+        if (bytesRead < 0)
+        {
+            return false;
+        }
+
+        if (bytesRead == 0)
+        {
+            // Let server thread run if it shares the CPU.
+            std::this_thread::yield();
+        }
+
+        received += bytesRead;
+    }
+
+    return true;
+}
+
+void printResults(const std::string& format, const std::string& config, const std::vector<size_t>& sizes, const std::vector<LatencyHistogram>& histograms)
+{
+    const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+    const char* names[] = {"p50", "p90", "p99", "p99.9", "p99.99"};
+
+    if (format == "json")
+    {
+        printf("{%s, \"results\": [\n", config.c_str());
+        for (size_t i = 0; i < sizes.size(); i++)
+        {
+            const LatencyHistogram& histogram = histograms[i];
+            printf("  {\"size\": %zu, \"count\": %lu, \"min_us\": %.3f, \"mean_us\": %.3f",
+                   sizes[i], histogram.count(), histogram.min() / 1e3, histogram.mean() / 1e3);
+            for (size_t j = 0; j < 5; j++)
+            {
+                printf(", \"%s_us\": %.3f", names[j], histogram.percentile(percentiles[j]) / 1e3);
+            }
+            printf(", \"max_us\": %.3f}%s\n", histogram.max() / 1e3, (i + 1 < sizes.size()) ? "," : "");
+        }
+        printf("]}\n");
+        return;
+    }
+
+    const char* separator = (format == "csv") ? "," : " ";
+
+    if (format == "csv")
+    {
+        printf("size,count,min_us,mean_us,p50_us,p90_us,p99_us,p99.9_us,p99.99_us,max_us\n");
+    }
+    else
+    {
+        printf("%s\n", config.c_str());
+        printf("%8s %10s %10s %10s %10s %10s %10s %10s %10s %10s   [us]\n", "size", "count", "min", "mean", "p50", "p90", "p99", "p99.9", "p99.99", "max");
+    }
+
+    for (size_t i = 0; i < sizes.size(); i++)
+    {
+        const LatencyHistogram& histogram = histograms[i];
+        int width = (format == "csv") ? 0 : 10;
+
+        printf("%*zu%s%*lu", (format == "csv") ? 0 : 8, sizes[i], separator, width, histogram.count());
+        printf("%s%*.3f%s%*.3f", separator, width, histogram.min() / 1e3, separator, width, histogram.mean() / 1e3);
+        for (size_t j = 0; j < 5; j++)
+        {
+            printf("%s%*.3f", separator, width, histogram.percentile(percentiles[j]) / 1e3);
+        }
+        printf("%s%*.3f\n", separator, width, histogram.max() / 1e3);
+    }
+}
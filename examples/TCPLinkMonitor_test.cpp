@@ -0,0 +1,75 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -pthread -o ./bin/TCPLinkMonitor_test TCPLinkMonitor_test.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPLinkMonitor_test [interfaceName]
+
+Print link state and address of an interface and every change reported by netlink. (eg: cable pull, ip addr add/del)
+Server link check reads the cached table of monitor, so it does no file I/O per call.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <csignal>              // For SIGINT handler
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+const char *server_portName = "eth0";        // Interface name of server
+
+volatile sig_atomic_t stopFlag = 0;
+
+// ###################################################
+// Function declerations
+
+// Print change of link state. It runs on monitor thread.
+void linkHandler(const TCPLinkState& state);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        server_portName = argv[1];
+    }
+
+    signal(SIGINT, [](int) { stopFlag = 1; });
+
+    TCPLinkMonitor monitor;
+
+    if (!monitor.start(linkHandler))
+    {
+        std::cout << monitor.errorMessage << std::endl;
+        return 1;
+    }
+
+    TCPServer server;
+    server.setLinkMonitor(&monitor);
+
+    printf("%s: link %d, ip address: %s\n", server_portName, server.checkLinkStatus(server_portName), monitor.getIPAddress(server_portName).c_str());
+
+    while (!stopFlag)
+    {
+        usleep(100000);
+    }
+
+    monitor.stop();
+
+    return 0;
+}
+
+void linkHandler(const TCPLinkState& state)
+{
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &state.address, ip, sizeof(ip));
+
+    if (state.index == 0)
+    {
+        printf("%s: removed\n", state.name);
+        return;
+    }
+
+    printf("%s: up %d, carrier %d, ip address: %s\n", state.name, state.up, state.carrier, (state.address != 0) ? ip : "-");
+}
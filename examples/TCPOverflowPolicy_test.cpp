@@ -0,0 +1,243 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -o ./bin/TCPOverflowPolicy_test TCPOverflowPolicy_test.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPOverflowPolicy_test [backend]
+
+Checks of TX overflow policies of event loop connections. backend 1 uses io_uring. Exit code is 0 if all checks pass.
+DropOldestFrames: frames are queued by vectored writes and by pushBackTxBuffer() while the client does not read.
+TX queue must stay within TX buffer size, and the client must receive only whole frames in order.
+Backpressure: writes are refused while the client does not read. Then the client reads and user code sends the queue by write().
+The event loop must report the connection as drained and clear its blocked state.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+int serverPort = 9060;                       // Port number on which the server listens
+const char *server_ip = "127.0.0.1";         // IP address on which the server listens.
+
+const size_t txBufferSize = 8192;            // TX buffer size of server connections
+const size_t frameSize = 1000;               // Frame: 4 byte sequence number + payload of (sequence % 251)
+
+// ###################################################
+// Function declerations
+
+// Start server and client, and return accepted connection. return nullptr if it fails.
+TCPConnection* connectPair(TCPServer &server, TCPClient &client, TCPEventBackend backend);
+
+// Read from client until nothing is received for certain time. Server event loop runs meanwhile.
+void readAll(TCPServer &server, TCPClient &client, std::string &data);
+
+// DropOldestFrames with vectored writes. return true if the check passes.
+bool testDropOldestFrames(TCPEventBackend backend);
+
+// Drained report of Backpressure after user code sent the queue. return true if the check passes.
+bool testDrainedAfterWrite(TCPEventBackend backend);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    TCPEventBackend backend = ((argc > 1) && (atoi(argv[1]) == 1)) ? TCPEventBackend::IoUring : TCPEventBackend::Epoll;
+
+    bool passed = testDropOldestFrames(backend);
+    passed = testDrainedAfterWrite(backend) && passed;
+
+    return passed ? 0 : 1;
+}
+
+TCPConnection* connectPair(TCPServer &server, TCPClient &client, TCPEventBackend backend)
+{
+    if (!server.startByIP(serverPort, server_ip) || !server.startEventLoop(16, backend))
+    {
+        server.printError();
+        return nullptr;
+    }
+
+    if (!client.start(serverPort, server_ip) || (client.updateConnect(-1) != TCPConnectState::Connected))
+    {
+        client.printError();
+        return nullptr;
+    }
+
+    TCPConnection* connection = nullptr;
+    while (connection == nullptr)
+    {
+        if (server.runEventLoop(1000) == -1)
+        {
+            server.printError();
+            return nullptr;
+        }
+
+        for (TCPConnection* accepted : server.getAcceptedConnections())
+        {
+            connection = accepted;
+        }
+    }
+
+    return connection;
+}
+
+void readAll(TCPServer &server, TCPClient &client, std::string &data)
+{
+    char buffer[65536];
+    auto quietTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+
+    while (std::chrono::steady_clock::now() < quietTime)
+    {
+        server.runEventLoop(1);
+
+        int32_t bytesRead;
+        while ((bytesRead = client.read(buffer, sizeof(buffer))) > 0)
+        {
+            data.append(buffer, bytesRead);
+            quietTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+        }
+    }
+}
+
+bool testDropOldestFrames(TCPEventBackend backend)
+{
+    TCPServer server;
+    TCPClient client;
+
+    server.setTxBufferSize(txBufferSize);
+    server.setOverflowPolicy(TCPOverflowPolicy::DropOldestFrames);
+
+    TCPConnection* connection = connectPair(server, client, backend);
+    if (connection == nullptr)
+    {
+        return false;
+    }
+
+    // Sockets buffer some megabytes, so frames are dropped after that.
+    const uint32_t frameNum = 20000;
+    size_t maxQueuedBytes = 0;
+    std::string frame(frameSize, '\0');
+
+    for (uint32_t sequence = 0; sequence < frameNum; sequence++)
+    {
+        memcpy(&frame[0], &sequence, sizeof(sequence));
+        memset(&frame[sizeof(sequence)], (char)(sequence % 251), frameSize - sizeof(sequence));
+
+        // Header and payload of even frames are two buffers of one vectored write.
+        struct iovec buffers[2] = {{&frame[0], sizeof(sequence)}, {&frame[sizeof(sequence)], frameSize - sizeof(sequence)}};
+        bool written = (sequence % 2 == 0) ? connection->write(buffers, 2) : (connection->pushBackTxBuffer(frame.data(), frame.size()) && connection->write());
+        if (!written)
+        {
+            printf("write failed: %s\n", connection->errorMessage.c_str());
+            return false;
+        }
+
+        // Trimming runs when pushBackTxBuffer() queues a frame.
+        if (sequence % 2 == 1)
+        {
+            maxQueuedBytes = std::max(maxQueuedBytes, connection->getTxQueuedBytes());
+        }
+
+        server.runEventLoop(0);
+    }
+
+    std::string data;
+    readAll(server, client, data);
+
+    size_t frameCount = data.size() / frameSize;
+    bool ordered = (data.size() % frameSize == 0);
+    uint32_t lastSequence = 0;
+
+    for (size_t i = 0; ordered && (i < frameCount); i++)
+    {
+        const char* received = data.data() + i * frameSize;
+        uint32_t sequence;
+        memcpy(&sequence, received, sizeof(sequence));
+
+        if ( (sequence >= frameNum) || ((i > 0) && (sequence <= lastSequence)) ||
+             (std::string(received + sizeof(sequence), frameSize - sizeof(sequence)) != std::string(frameSize - sizeof(sequence), (char)(sequence % 251))) )
+        {
+            ordered = false;
+        }
+        lastSequence = sequence;
+    }
+
+    // Queued bytes of io_uring backend include the in flight send, which is not trimmed.
+    size_t queueLimit = (server.getEventBackend() == TCPEventBackend::IoUring) ? 2 * txBufferSize : txBufferSize;
+    uint64_t droppedBytes = server.getStats()[TCPStatsCounter::TxDroppedBytes];
+    bool passed = ordered && (maxQueuedBytes <= queueLimit) && (droppedBytes > 0) && (droppedBytes % frameSize == 0);
+
+    printf("DropOldestFrames: frames %zu/%u, max queued bytes %zu, dropped bytes %lu, %s\n",
+           frameCount, frameNum, maxQueuedBytes, (unsigned long)droppedBytes, passed ? "passed" : "failed");
+
+    client.clientClose();
+    server.stopEventLoop();
+    server.runEventLoop(0);
+    server.serverClose();
+
+    return passed;
+}
+
+bool testDrainedAfterWrite(TCPEventBackend backend)
+{
+    TCPServer server;
+    TCPClient client;
+
+    server.setTxBufferSize(txBufferSize);
+    server.setOverflowPolicy(TCPOverflowPolicy::Backpressure);
+
+    TCPConnection* connection = connectPair(server, client, backend);
+    if (connection == nullptr)
+    {
+        return false;
+    }
+
+    // Fill socket buffers and TX queue until backpressure refuses a frame.
+    std::string frame(frameSize, 'x');
+    size_t writtenNum = 0;
+    while (connection->write(frame))
+    {
+        writtenNum++;
+        server.runEventLoop(0);
+    }
+
+    bool refused = connection->isTxBlocked();
+
+    // Client reads while user code sends the queue. Event loop does not run meanwhile.
+    char buffer[65536];
+    size_t receivedBytes = 0;
+    auto endTime = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while ( (connection->getTxQueuedBytes() > 0) && (std::chrono::steady_clock::now() < endTime) )
+    {
+        int32_t bytesRead;
+        while ((bytesRead = client.read(buffer, sizeof(buffer))) > 0)
+        {
+            receivedBytes += bytesRead;
+        }
+        connection->write();
+    }
+
+    bool drained = false;
+    for (int i = 0; (i < 10) && !drained; i++)
+    {
+        server.runEventLoop(10);
+        for (TCPConnection* drainedConnection : server.getDrainedConnections())
+        {
+            drained = drained || (drainedConnection == connection);
+        }
+    }
+
+    bool passed = refused && drained && !connection->isTxBlocked();
+
+    printf("Backpressure: written frames %zu, refused %d, drained %d, blocked %d, %s\n",
+           writtenNum, refused, drained, connection->isTxBlocked(), passed ? "passed" : "failed");
+
+    client.clientClose();
+    server.stopEventLoop();
+    server.runEventLoop(0);
+    server.serverClose();
+
+    return passed;
+}
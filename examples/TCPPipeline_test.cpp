@@ -0,0 +1,197 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -pthread -o ./bin/TCPPipeline_test TCPPipeline_test.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPPipeline_test [workerCount] [clientCount] [messageCount] [backend]
+
+Length prefixed echo protocol (4 byte length + payload) with worker threads.
+The I/O thread reads frames and passes them to workers by lock free queues. Workers uppercase payloads and pass replies back.
+Every client thread sends messageCount messages and checks the order of replies.
+workerCount 0 means one worker per CPU. backend 1 uses io_uring.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <cctype>               // For toupper()
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+int serverPort = 9050;                       // Port number on which the server listens
+const char *server_ip = "127.0.0.1";         // IP address on which the server listens.. Replace with your interface's IP address
+
+std::atomic<size_t> completedClients(0);     // Number of clients that received all replies in order
+
+// ###################################################
+// Function declerations
+
+// Send messages and check uppercase replies. Runs in its own thread. Sent messages are limited to a window.
+void runClient(size_t clientIndex, size_t messageCount);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    size_t workerCount = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 4;
+    size_t clientCount = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 8;
+    size_t messageCount = (argc > 3) ? strtoul(argv[3], nullptr, 10) : 100000;
+    TCPEventBackend backend = ((argc > 4) && (atoi(argv[4]) == 1)) ? TCPEventBackend::IoUring : TCPEventBackend::Epoll;
+
+    TCPServer server;
+    server.setRxBufferSize(65536);
+    server.setTxBufferSize(1 << 20);
+    server.setOverflowPolicy(TCPOverflowPolicy::Backpressure);
+
+    TCPSocketOptions options;
+    options.listenBacklog = (int)clientCount;
+    server.setSocketOptions(options);
+
+    if (!server.startByIP(serverPort, server_ip) || !server.startEventLoop(TCPNetworkLinux_DEFAULT_MAX_CONNECTIONS, backend))
+    {
+        server.printError();
+        return 1;
+    }
+
+    TCPWorkerPipeline pipeline;
+
+    // Workers run this function. A full reply queue means the I/O thread is behind, so worker yields to it.
+    bool started = pipeline.start(server, workerCount, [](TCPWorkerPipeline &pipeline, size_t workerIndex, TCPPipelineMessage &message)
+    {
+        (void)workerIndex;
+        for (char &c : message.payload)
+        {
+            c = (char)toupper((unsigned char)c);
+        }
+
+        while (!pipeline.reply(std::move(message)))
+        {
+            std::this_thread::yield();
+        }
+    });
+
+    if (!started)
+    {
+        std::cout << pipeline.errorMessage << std::endl;
+        return 1;
+    }
+
+    printf("workers: %zu, clients: %zu, messages: %zu, io_uring: %d\n", pipeline.getWorkerCount(), clientCount, messageCount, server.getEventBackend() == TCPEventBackend::IoUring);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> clients;
+    for (size_t i = 0; i < clientCount; i++)
+    {
+        clients.emplace_back(runClient, i, messageCount);
+    }
+
+    // Clients close after their last reply, so every closed connection is a finished client.
+    size_t closedNum = 0;
+    while (closedNum < clientCount)
+    {
+        if (pipeline.run(100) == -1)
+        {
+            std::cout << pipeline.errorMessage << std::endl;
+            break;
+        }
+        closedNum += server.getClosedConnections().size();
+    }
+
+    for (std::thread &client : clients)
+    {
+        client.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    printf("completed: %zu/%zu, seconds: %.3f, messages/s: %.0f, dropped replies: %lu\n",
+           completedClients.load(), clientCount, seconds, (clientCount * messageCount) / seconds, (unsigned long)pipeline.getDroppedReplies());
+
+    pipeline.stop();
+    server.stopEventLoop();
+    server.runEventLoop(0);
+    server.serverClose();
+
+    return 0;
+}
+
+void runClient(size_t clientIndex, size_t messageCount)
+{
+    TCPClient client;
+    if (!client.start(serverPort, server_ip) || (client.updateConnect(-1) != TCPConnectState::Connected))
+    {
+        client.printError();
+        return;
+    }
+
+    // At most windowSize messages wait for reply, so TX queue of client stays small.
+    const size_t windowSize = 1024;
+    size_t sentNum = 0;
+    size_t replyNum = 0;
+    bool ordered = true;
+    std::string batch;
+    std::string data;
+    char buffer[65536];
+
+    while (replyNum < messageCount)
+    {
+        batch.clear();
+        while ( (sentNum < messageCount) && (sentNum - replyNum < windowSize) )
+        {
+            std::string payload = "client " + std::to_string(clientIndex) + " message " + std::to_string(sentNum);
+            uint32_t header = htonl((uint32_t)payload.size());
+            batch.append((const char*)&header, sizeof(header));
+            batch += payload;
+            sentNum++;
+        }
+
+        struct iovec request = {&batch[0], batch.size()};
+        if ( (!batch.empty() && !client.write(&request, 1)) || ((client.getTxQueuedBytes() > 0) && !client.write()) )
+        {
+            client.printError();
+            break;
+        }
+
+        if (client.waitReadable(1000) <= 0)
+        {
+            continue;
+        }
+
+        int32_t bytesRead = client.read(buffer, sizeof(buffer));
+        if (bytesRead < 0)
+        {
+            client.printError();
+            break;
+        }
+        data.append(buffer, bytesRead);
+
+        size_t offset = 0;
+        while (data.size() - offset >= sizeof(uint32_t))
+        {
+            uint32_t header;
+            memcpy(&header, data.data() + offset, sizeof(header));
+            size_t payloadSize = ntohl(header);
+            if (data.size() - offset - sizeof(header) < payloadSize)
+            {
+                break;
+            }
+
+            std::string expected = "CLIENT " + std::to_string(clientIndex) + " MESSAGE " + std::to_string(replyNum);
+            if (data.compare(offset + sizeof(header), payloadSize, expected) != 0)
+            {
+                ordered = false;
+            }
+
+            replyNum++;
+            offset += sizeof(header) + payloadSize;
+        }
+        data.erase(0, offset);
+    }
+
+    client.clientClose();
+
+    if ( (replyNum == messageCount) && ordered )
+    {
+        completedClients++;
+    }
+}
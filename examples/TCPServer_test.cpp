@@ -45,26 +45,36 @@ int main() {
 
     while(true)
     {
-        if(!server.isClientConnected())
+        // Block until a client connects or sends data. No sleep interval is added to the latency.
+        int32_t events = server.waitReadable(-1);
+        if (events == -1)
         {
-            // try to connect if any client exist.
-            server.clientConnect();
+            server.printError();
+            break;
         }
 
-        std::string rxString;
-        std::string txString = "hello mohammad.\n";
-
-        server.pushBackTxBuffer(&txString);
+        if (events & TCPNetworkLinux_WAIT_ACCEPT)
+        {
+            // try to connect the pending client.
+            server.clientConnect();
+            continue;
+        }
 
-        server.write();
+        if (server.read() <= 0)
+        {
+            // Client disconnected.
+            continue;
+        }
 
-        server.read();
+        std::string_view rxData = server.peekRxBuffer();
+        cout << "rxString: " << rxData << endl;
+        server.consumeRxBuffer(rxData.size());
 
-        cout << "rxString: " << server.popAllRxBuffer() << endl;
+        std::string txString = "hello mohammad.\n";
+        server.write(txString);
 
         i++;
         printf("counter i: %d\n",i);
-        usleep(1000000); // Sleep for 100ms to prevent busy waiting
     }
 
     server.serverClose();
@@ -0,0 +1,75 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -pthread -o ./bin/TCPShardedServer_test TCPShardedServer_test.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPShardedServer_test [shardCount] [cpuSteering]
+
+Echo server with one event loop thread per shard. All shards listen on the same port (SO_REUSEPORT).
+shardCount 0 means one shard per CPU that the process may run on. cpuSteering 1 pins shards to CPUs and keeps connections on the CPU of their packets.
+Steering needs one shard per online CPU. Otherwise the server runs without it and prints the reason.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <csignal>              // For SIGINT handler
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+int serverPort = 9020;                       // Port number on which the server listens
+const char *server_ip = "127.0.0.1";         // IP address on which the server listens.. Replace with your interface's IP address
+
+volatile sig_atomic_t stopFlag = 0;
+
+// ###################################################
+// Function declerations
+
+// Echo received data of ready connections of one shard. It runs on worker thread of the shard.
+void echoHandler(TCPServer& server, size_t shardIndex);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    size_t shardCount = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 0;
+    bool cpuSteering = (argc > 2) ? (atoi(argv[2]) != 0) : false;
+
+    signal(SIGINT, [](int) { stopFlag = 1; });
+
+    TCPShardedServer server;
+
+    if (!server.start(serverPort, server_ip, shardCount, echoHandler, cpuSteering))
+    {
+        std::cout << server.errorMessage << std::endl;
+        return 1;
+    }
+
+    if (!server.errorMessage.empty())
+    {
+        std::cout << server.errorMessage << std::endl;
+    }
+
+    printf("Server is listening on %s:%d with %zu shards. CPU steering: %d\n", server_ip, serverPort, server.getShardCount(), server.isCpuSteering());
+
+    while (!stopFlag)
+    {
+        usleep(100000);
+    }
+
+    server.stop();
+
+    return 0;
+}
+
+void echoHandler(TCPServer& server, size_t shardIndex)
+{
+    (void)shardIndex;
+
+    for (TCPConnection* connection : server.getReadyConnections())
+    {
+        std::string_view data = connection->peekRxBuffer();
+        connection->write(data.data(), data.size());
+        connection->consumeRxBuffer(data.size());
+    }
+}
@@ -0,0 +1,432 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -pthread -o ./bin/TCPThroughput_bench TCPThroughput_bench.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPThroughput_bench [--sizes 64,1024,16384] [--duration 2] [--batch 64] [--transport tcp|unix] [--format text|csv]
+
+Stream messages between TCPClient and TCPServer (single client API) over 127.0.0.1 or a unix domain socket for certain duration,
+one way in both directions and in both directions at once. Every side runs on its own thread.
+Cases cover TX strategies (per message write, pushBackTxBuffer + write(), vectored write) and
+RX strategies (read() + popAllRxBuffer() copy, read() + peekRxBuffer()/consumeRxBuffer() view, TCPClient::read()).
+Reported per case and message size:
+ - GB/s and messages/s of received data.
+ - syscalls per message of both sides. Socket syscalls are counted exactly by wrapping them below.
+ - CPU time per byte of the process (getrusage, user + system).
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <thread>               // For side threads
+#include <atomic>               // For counters
+#include <chrono>               // For elapsed time
+#include <cstdarg>              // For ioctl wrapper
+#include <getopt.h>             // For command line options
+#include <sys/resource.h>       // For getrusage
+#include <sys/syscall.h>        // For raw syscall numbers
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+int serverPort = 9040;                       // Port number on which the server listens
+const char *server_ip = "127.0.0.1";         // Loopback address for benchmark
+const char *server_path = "@TCPThroughput_bench";  // Unix domain socket name for benchmark
+bool unixTransport = false;                  // Use unix domain socket instead of TCP loopback
+
+std::atomic<uint64_t> syscallCounter(0);     // Number of socket syscalls of both sides
+std::atomic<uint64_t> receivedBytes(0);      // Number of bytes received by both sides
+std::atomic<bool> running(false);            // Side threads run while it is true
+
+// TX strategy of one side.
+enum class TxMode
+{
+    None,           // Side does not send.
+    PerMessage,     // write(const std::string&) per message. (TCPServer only)
+    PushWrite,      // pushBackTxBuffer() per message and write() per batch.
+    Vectored        // write(const struct iovec*, size_t) per batch.
+};
+
+// RX strategy of one side.
+enum class RxMode
+{
+    None,           // Side does not receive.
+    PopAll,         // TCPServer read() + popAllRxBuffer().
+    Peek,           // TCPServer read() + peekRxBuffer()/consumeRxBuffer().
+    Read            // TCPClient read() into caller buffer.
+};
+
+// One benchmark case.
+struct BenchCase
+{
+    const char* name;
+    TxMode serverTx;
+    RxMode serverRx;
+    TxMode clientTx;
+    RxMode clientRx;
+};
+
+const BenchCase benchCases[] =
+{
+    {"c2s push+write/popAll",     TxMode::None,       RxMode::PopAll, TxMode::PushWrite, RxMode::None},
+    {"c2s push+write/peek",       TxMode::None,       RxMode::Peek,   TxMode::PushWrite, RxMode::None},
+    {"c2s iovec/peek",            TxMode::None,       RxMode::Peek,   TxMode::Vectored,  RxMode::None},
+    {"s2c write(string)/read",    TxMode::PerMessage, RxMode::None,   TxMode::None,      RxMode::Read},
+    {"s2c push+write/read",       TxMode::PushWrite,  RxMode::None,   TxMode::None,      RxMode::Read},
+    {"s2c iovec/read",            TxMode::Vectored,   RxMode::None,   TxMode::None,      RxMode::Read},
+    {"bidir push+write/popAll",   TxMode::PushWrite,  RxMode::PopAll, TxMode::PushWrite, RxMode::Read},
+    {"bidir iovec/peek",          TxMode::Vectored,   RxMode::Peek,   TxMode::Vectored,  RxMode::Read},
+};
+
+// ###################################################
+// Syscall wrappers. Definitions in the executable take precedence over libc for calls from the library.
+
+extern "C" ssize_t send(int fd, const void* buf, size_t len, int flags)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    return syscall(SYS_sendto, fd, buf, len, flags, nullptr, 0);
+}
+
+extern "C" ssize_t sendmsg(int fd, const struct msghdr* msg, int flags)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    return syscall(SYS_sendmsg, fd, msg, flags);
+}
+
+extern "C" ssize_t recv(int fd, void* buf, size_t len, int flags)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    return syscall(SYS_recvfrom, fd, buf, len, flags, nullptr, nullptr);
+}
+
+extern "C" ssize_t recvmsg(int fd, struct msghdr* msg, int flags)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    return syscall(SYS_recvmsg, fd, msg, flags);
+}
+
+extern "C" ssize_t readv(int fd, const struct iovec* iov, int iovcnt)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    return syscall(SYS_readv, fd, iov, iovcnt);
+}
+
+extern "C" int poll(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    struct timespec time = {timeout / 1000, (timeout % 1000) * 1000000L};
+    return syscall(SYS_ppoll, fds, nfds, (timeout < 0) ? nullptr : &time, nullptr, 0);
+}
+
+extern "C" int ioctl(int fd, unsigned long request, ...)
+{
+    va_list arguments;
+    va_start(arguments, request);
+    void* argument = va_arg(arguments, void*);
+    va_end(arguments);
+
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    return syscall(SYS_ioctl, fd, request, argument);
+}
+
+// ###################################################
+// Function declerations
+
+// Run one case for one message size and print result.
+void runCase(const BenchCase& benchCase, size_t messageSize, double duration, size_t batchSize, bool csv);
+
+// Side thread functions.
+void runServerSide(TCPServer* server, const BenchCase* benchCase, size_t messageSize, size_t batchSize);
+void runClientSide(TCPClient* client, const BenchCase* benchCase, size_t messageSize, size_t batchSize);
+
+// Return CPU time of process in seconds.
+double cpuTime(void);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = {64, 1024, 16384};
+    double duration = 2.0;
+    size_t batchSize = 64;
+    bool csv = false;
+
+    static struct option longOptions[] =
+    {
+        {"sizes", required_argument, nullptr, 's'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"batch", required_argument, nullptr, 'b'},
+        {"transport", required_argument, nullptr, 't'},
+        {"format", required_argument, nullptr, 'f'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "", longOptions, nullptr)) != -1)
+    {
+        switch (option)
+        {
+            case 's':
+            {
+                sizes.clear();
+                char* item = strtok(optarg, ",");
+                while (item != nullptr)
+                {
+                    sizes.push_back(strtoul(item, nullptr, 10));
+                    item = strtok(nullptr, ",");
+                }
+                break;
+            }
+            case 'd': duration = atof(optarg); break;
+            case 'b': batchSize = std::max<size_t>(1, strtoul(optarg, nullptr, 10)); break;
+            case 't': unixTransport = (strcmp(optarg, "unix") == 0); break;
+            case 'f': csv = (strcmp(optarg, "csv") == 0); break;
+            default:
+                fprintf(stderr, "Invalid option. See usage at top of TCPThroughput_bench.cpp\n");
+                return 1;
+        }
+    }
+
+    if (csv)
+    {
+        printf("case,size,batch,seconds,GB/s,messages/s,syscalls/message,cpu_ns/byte\n");
+    }
+    else
+    {
+        printf("transport: %s, duration: %.1f s, batch: %zu\n", unixTransport ? "unix" : "tcp", duration, batchSize);
+        printf("%-26s %8s %10s %14s %18s %14s\n", "case", "size", "GB/s", "messages/s", "syscalls/message", "cpu ns/byte");
+    }
+
+    for (const BenchCase& benchCase : benchCases)
+    {
+        for (size_t size : sizes)
+        {
+            runCase(benchCase, size, duration, batchSize, csv);
+        }
+    }
+
+    return 0;
+}
+
+void runCase(const BenchCase& benchCase, size_t messageSize, double duration, size_t batchSize, bool csv)
+{
+    TCPServer server;
+    TCPClient client;
+
+    // Large limits, so overflow trimming never drops benchmark data.
+    server.setRxBufferSize(1 << 22);
+    server.setTxBufferSize(1 << 22);
+
+    bool started = unixTransport ? (server.startByPath(server_path) && client.startByPath(server_path)) :
+                                   (server.startByIP(serverPort, server_ip) && client.start(serverPort, server_ip));
+    if (!started)
+    {
+        server.printError();
+        client.printError();
+        exit(1);
+    }
+
+    while (!server.clientConnect())
+    {
+    }
+
+    if (client.updateConnect(-1) != TCPConnectState::Connected)
+    {
+        client.printError();
+        exit(1);
+    }
+
+    running = true;
+    std::thread serverThread(runServerSide, &server, &benchCase, messageSize, batchSize);
+    std::thread clientThread(runClientSide, &client, &benchCase, messageSize, batchSize);
+
+    // Warm up, then measure a window of certain duration.
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    uint64_t startBytes = receivedBytes.load();
+    uint64_t startSyscalls = syscallCounter.load();
+    double startCpu = cpuTime();
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+
+    uint64_t bytes = receivedBytes.load() - startBytes;
+    uint64_t syscalls = syscallCounter.load() - startSyscalls;
+    double cpu = cpuTime() - startCpu;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    running = false;
+    serverThread.join();
+    clientThread.join();
+
+    client.clientClose();
+    server.serverClose();
+
+    double messages = (double)bytes / messageSize;
+    double syscallsPerMessage = (messages > 0) ? syscalls / messages : 0;
+    double cpuPerByte = (bytes > 0) ? cpu * 1e9 / bytes : 0;
+
+    if (csv)
+    {
+        printf("%s,%zu,%zu,%.3f,%.3f,%.0f,%.3f,%.3f\n", benchCase.name, messageSize, batchSize, seconds, bytes / seconds / 1e9,
+               messages / seconds, syscallsPerMessage, cpuPerByte);
+    }
+    else
+    {
+        printf("%-26s %8zu %10.3f %14.0f %18.3f %14.3f\n", benchCase.name, messageSize, bytes / seconds / 1e9,
+               messages / seconds, syscallsPerMessage, cpuPerByte);
+    }
+}
+
+void runServerSide(TCPServer* server, const BenchCase* benchCase, size_t messageSize, size_t batchSize)
+{
+    std::string message(messageSize, 's');
+    std::vector<struct iovec> buffers(batchSize, {&message[0], messageSize});
+    const size_t batchBytes = messageSize * batchSize;
+
+    while (running)
+    {
+        bool progress = false;
+        size_t queuedBytes = server->getTxQueuedBytes();
+
+        switch (benchCase->serverTx)
+        {
+            case TxMode::PerMessage:
+                if (queuedBytes == 0)
+                {
+                    for (size_t i = 0; i < batchSize; i++)
+                    {
+                        server->write(message);
+                    }
+                }
+                else
+                {
+                    server->write();
+                }
+                break;
+            case TxMode::PushWrite:
+                if (queuedBytes < batchBytes)
+                {
+                    for (size_t i = 0; i < batchSize; i++)
+                    {
+                        server->pushBackTxBuffer(message.c_str(), messageSize);
+                    }
+                }
+                server->write();
+                break;
+            case TxMode::Vectored:
+                if (queuedBytes == 0)
+                {
+                    server->write(buffers.data(), batchSize);
+                }
+                else
+                {
+                    server->write();
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (benchCase->serverTx != TxMode::None)
+        {
+            // Progress if kernel accepted queued data or a new batch is fully sent.
+            progress |= (server->getTxQueuedBytes() < std::max(queuedBytes, (size_t)1));
+        }
+
+        if (benchCase->serverRx != RxMode::None)
+        {
+            int32_t bytesRead = server->read();
+
+            if (bytesRead > 0)
+            {
+                if (benchCase->serverRx == RxMode::PopAll)
+                {
+                    std::string data = server->popAllRxBuffer();
+                    receivedBytes.fetch_add(data.size(), std::memory_order_relaxed);
+                }
+                else
+                {
+                    std::string_view data = server->peekRxBuffer();
+                    receivedBytes.fetch_add(data.size(), std::memory_order_relaxed);
+                    server->consumeRxBuffer(data.size());
+                }
+                progress = true;
+            }
+        }
+
+        if (!progress)
+        {
+            // Let the other side run if it shares the CPU.
+            std::this_thread::yield();
+        }
+    }
+}
+
+void runClientSide(TCPClient* client, const BenchCase* benchCase, size_t messageSize, size_t batchSize)
+{
+    std::string message(messageSize, 'c');
+    std::vector<struct iovec> buffers(batchSize, {&message[0], messageSize});
+    std::vector<char> buffer(1 << 16);
+    const size_t batchBytes = messageSize * batchSize;
+
+    while (running)
+    {
+        bool progress = false;
+        size_t queuedBytes = client->getTxQueuedBytes();
+
+        switch (benchCase->clientTx)
+        {
+            case TxMode::PushWrite:
+                if (queuedBytes < batchBytes)
+                {
+                    for (size_t i = 0; i < batchSize; i++)
+                    {
+                        client->pushBackTxBuffer(message.c_str(), messageSize);
+                    }
+                }
+                client->write();
+                break;
+            case TxMode::Vectored:
+                if (queuedBytes == 0)
+                {
+                    client->write(buffers.data(), batchSize);
+                }
+                else
+                {
+                    client->write();
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (benchCase->clientTx != TxMode::None)
+        {
+            progress |= (client->getTxQueuedBytes() < std::max(queuedBytes, (size_t)1));
+        }
+
+        if (benchCase->clientRx == RxMode::Read)
+        {
+            int32_t bytesRead = client->read(buffer.data(), buffer.size());
+
+            if (bytesRead > 0)
+            {
+                receivedBytes.fetch_add(bytesRead, std::memory_order_relaxed);
+                progress = true;
+            }
+        }
+
+        if (!progress)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+double cpuTime(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
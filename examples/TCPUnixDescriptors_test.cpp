@@ -0,0 +1,93 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -o ./bin/TCPUnixDescriptors_test TCPUnixDescriptors_test.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPUnixDescriptors_test
+
+File descriptor passing over a unix domain socket with the event loop.
+The client sends data with descriptors, then data without descriptors, then data with descriptors again.
+Receive of a unix socket stops after every message with descriptors, so the server must read until it would block.
+One event loop iteration must deliver all data and all descriptors. Exit code is 0 if it does.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+const char *server_path = "@TCPUnixDescriptors_test";        // Abstract socket name. No socket file is created.
+
+// ###################################################
+int main()
+{
+    TCPServer server;
+    TCPClient client;
+
+    if (!server.startByPath(server_path) || !server.startEventLoop())
+    {
+        server.printError();
+        return 1;
+    }
+
+    if (!client.startByPath(server_path))
+    {
+        client.printError();
+        return 1;
+    }
+
+    TCPConnection* connection = nullptr;
+    while (connection == nullptr)
+    {
+        if (server.runEventLoop(1000) == -1)
+        {
+            server.printError();
+            return 1;
+        }
+
+        for (TCPConnection* accepted : server.getAcceptedConnections())
+        {
+            connection = accepted;
+        }
+    }
+
+    // Descriptors of stdin and stdout are sent. Receiver gets new descriptors of the same files.
+    int fileDescriptors[2] = {STDIN_FILENO, STDOUT_FILENO};
+    std::string expected = "first" "second" "third";
+    char second[] = "second";
+    struct iovec secondBuffer = {second, 6};
+
+    if (!client.sendFileDescriptors(&fileDescriptors[0], 1, "first", 5) || !client.write(&secondBuffer, 1) ||
+        !client.sendFileDescriptors(&fileDescriptors[1], 1, "third", 5))
+    {
+        client.printError();
+        return 1;
+    }
+
+    if (server.runEventLoop(1000) == -1)
+    {
+        server.printError();
+        return 1;
+    }
+
+    std::string data(connection->peekRxBuffer());
+    int descriptorNum = 0;
+    int fileDescriptor;
+    while ((fileDescriptor = connection->popFileDescriptor()) != -1)
+    {
+        descriptorNum++;
+        close(fileDescriptor);
+    }
+
+    bool passed = (data == expected) && (descriptorNum == 2);
+    printf("data: \"%s\", descriptors: %d, %s\n", data.c_str(), descriptorNum, passed ? "passed" : "failed");
+
+    client.clientClose();
+    server.stopEventLoop();
+    server.runEventLoop(0);
+    server.serverClose();
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+/*
+For compile:
+mkdir -p ./bin && g++ -O2 -pthread -o ./bin/TCPVectoredWrite_bench TCPVectoredWrite_bench.cpp ../TCPNetworkLinux.cpp
+For run:
+./bin/TCPVectoredWrite_bench [messageSize] [messageCount] [batchSize]
+
+Compare TX syscalls per message of TCPServer send strategies over 127.0.0.1:
+ - write(const std::string&) called once per message.
+ - pushBackTxBuffer() per message and write() once per batch.
+ - write(const struct iovec*, size_t) once per batch.
+Send syscalls of this process are counted exactly by wrapping send/sendmsg/writev/poll below.
+*/
+// ##################################################
+// Include libraries
+
+#include <iostream>             // For standard input and output stream.
+#include <thread>               // For receiver thread
+#include <atomic>               // For syscall counters
+#include <chrono>               // For elapsed time
+#include <sys/syscall.h>        // For raw syscall numbers
+#include "../TCPNetworkLinux.h"       // Custom TCP/IP network library for handel server and client
+
+// ###################################################
+// Global Variables
+
+int serverPort = 9010;                       // Port number on which the server listens
+const char *server_ip = "127.0.0.1";         // Loopback address for benchmark
+
+std::atomic<uint64_t> syscallCounter(0);     // Number of TX related syscalls of sender
+
+// ###################################################
+// Syscall wrappers. Definitions in the executable take precedence over libc for calls from the library.
+
+extern "C" ssize_t send(int fd, const void* buf, size_t len, int flags)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    return syscall(SYS_sendto, fd, buf, len, flags, nullptr, 0);
+}
+
+extern "C" ssize_t sendmsg(int fd, const struct msghdr* msg, int flags)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    return syscall(SYS_sendmsg, fd, msg, flags);
+}
+
+extern "C" ssize_t writev(int fd, const struct iovec* iov, int iovcnt)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    return syscall(SYS_writev, fd, iov, iovcnt);
+}
+
+extern "C" int poll(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+    syscallCounter.fetch_add(1, std::memory_order_relaxed);
+    struct timespec time = {timeout / 1000, (timeout % 1000) * 1000000L};
+    return syscall(SYS_ppoll, fds, nfds, (timeout < 0) ? nullptr : &time, nullptr, 0);
+}
+
+// ###################################################
+// Function declerations
+
+// Run one send strategy and print result.
+void runCase(const char* name, int mode, size_t messageSize, size_t messageCount, size_t batchSize);
+
+// ###################################################
+int main(int argc, char** argv)
+{
+    size_t messageSize = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 32;
+    size_t messageCount = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 1000000;
+    size_t batchSize = (argc > 3) ? strtoul(argv[3], nullptr, 10) : 64;
+
+    printf("messageSize: %zu, messageCount: %zu, batchSize: %zu\n", messageSize, messageCount, batchSize);
+    printf("%-28s %12s %14s %16s\n", "case", "seconds", "messages/s", "syscalls/message");
+
+    runCase("write(string) per message", 0, messageSize, messageCount, batchSize);
+    runCase("pushBackTxBuffer + write()", 1, messageSize, messageCount, batchSize);
+    runCase("write(iovec, batch)", 2, messageSize, messageCount, batchSize);
+
+    return 0;
+}
+
+void runCase(const char* name, int mode, size_t messageSize, size_t messageCount, size_t batchSize)
+{
+    TCPServer server;
+
+    if (!server.startByIP(serverPort, server_ip))
+    {
+        server.printError();
+        exit(1);
+    }
+
+    const size_t totalBytes = messageSize * messageCount;
+
+    // Large enough that front trimming of pushBackTxBuffer() never drops benchmark data.
+    server.setTxBufferSize(totalBytes);
+
+    // Receiver: plain blocking socket that drains all data.
+    std::thread receiver([&]()
+    {
+        int socket = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(serverPort);
+        inet_pton(AF_INET, server_ip, &address.sin_addr);
+        connect(socket, (struct sockaddr*)&address, sizeof(address));
+
+        char buffer[1 << 16];
+        size_t received = 0;
+        while (received < totalBytes)
+        {
+            ssize_t bytesRead = recv(socket, buffer, sizeof(buffer), 0);
+            if (bytesRead <= 0)
+            {
+                break;
+            }
+            received += bytesRead;
+        }
+        close(socket);
+    });
+
+    while (!server.isClientConnected())
+    {
+        server.clientConnect();
+    }
+
+    std::string message(messageSize, 'x');
+    std::vector<struct iovec> buffers(batchSize);
+    for (struct iovec& buffer : buffers)
+    {
+        buffer.iov_base = &message[0];
+        buffer.iov_len = messageSize;
+    }
+
+    uint64_t startSyscalls = syscallCounter.load();
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (size_t sent = 0; sent < messageCount; sent += batchSize)
+    {
+        size_t num = std::min(batchSize, messageCount - sent);
+
+        if (mode == 0)
+        {
+            for (size_t i = 0; i < num; i++)
+            {
+                server.write(message);
+            }
+        }
+        else if (mode == 1)
+        {
+            for (size_t i = 0; i < num; i++)
+            {
+                server.pushBackTxBuffer(message.c_str(), message.size());
+            }
+            server.write();
+        }
+        else
+        {
+            server.write(buffers.data(), num);
+        }
+    }
+
+    while (server.getTxQueuedBytes() > 0)
+    {
+        server.write();
+    }
+
+    receiver.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    uint64_t syscalls = syscallCounter.load() - startSyscalls;
+
+    printf("%-28s %12.3f %14.0f %16.3f\n", name, seconds, messageCount / seconds, (double)syscalls / messageCount);
+
+    server.serverClose();
+}